@@ -76,6 +76,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #endif /* _WIN32 */
 
 #include "common.h"
@@ -100,12 +102,20 @@ using namespace grk;
 #include "format_defs.h"
 #include "grok_string.h"
 
+#include <cerrno>
+#include <cinttypes>
 #include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 #define TCLAP_NAMESTARTSTRING "-"
 #include "tclap/CmdLine.h"
 #include "common.h"
 #include <chrono>  // for high_resolution_clock
+#include "spdlog/sinks/stdout_color_sinks.h"
 
 using namespace TCLAP;
 using namespace std;
@@ -117,7 +127,9 @@ static int parse_cmdline_decoder(int argc,
 							grk_decompress_parameters *parameters,
 							img_fol_t *img_fol,
 							img_fol_t *out_fol,
-							char* plugin_path);
+							char* plugin_path,
+							char* service_path,
+							uint32_t* service_timeout);
 static grk_image_t* convert_gray_to_rgb(grk_image_t* original);
 
 
@@ -233,10 +245,16 @@ static void decode_help_display(void)
             "    image resolution is effectively divided by 2 to the power of the\n"
             "    number of discarded levels. The reduce factor is limited by the\n"
             "    smallest total number of decomposition levels among tiles.\n"
+			"  [-T | -Thumbnail]\n"
+            "    Decode only the lowest resolution level (a thumbnail). Overrides -r.\n"
 			"  [-l | -Layer] <number of quality layers to decode>\n"
             "    Set the maximum number of quality layers to decode. If there are\n"
             "    fewer quality layers than the specified number, all the quality layers\n"
-            "    are decoded.\n");
+            "    are decoded.\n"
+			"  [-C | -Components] <comp 0 index>[,<comp 1 index>[,...]]\n"
+            "    Decode only the listed components. Other components are skipped, unless\n"
+            "    they are needed to invert a multiple component transform. The output\n"
+            "    image contains the listed components, in increasing index order.\n");
     fprintf(stdout,"  [-p | -Precision] <comp 0 precision>[C|S][,<comp 1 precision>[C|S][,...]]\n"
             "    OPTIONAL\n"
             "    Force the precision (bit depth) of components.\n");
@@ -255,6 +273,23 @@ static void decode_help_display(void)
 			"    Compression format for output file. Currently, only zip is supported for TIFF output (set parameter to 8)\n");
 	fprintf(stdout, "  [-X | -XML]\n"
 		"    Store XML metadata to file. File name will be set to \"output file name\" + \".xml\"\n");
+	fprintf(stdout, "  [-S | -Service] <- | socket path>\n"
+		"    Run as a long-running decode service, keeping threads, decompressors and\n"
+		"    the header cache warm between jobs. Jobs are read from stdin (-) or from\n"
+		"    clients of the given Unix domain socket, one job per line:\n"
+		"      <input file> <output file> [-r <reduce>] [-l <layers>] [-d <x0,y0,x1,y1>] [-t <tile index>]\n"
+		"    Fields are separated by white space; a path containing white space must be\n"
+		"    enclosed in double quotes, within which \\\" and \\\\ stand for \" and \\.\n"
+		"    The output format is taken from the output file extension. Other options\n"
+		"    given on the command line apply to all jobs. Each job is answered with\n"
+		"      ok <job> <milliseconds> <megapixels per second> <width>x<height>\n"
+		"    or\n"
+		"      error <job> <milliseconds> <reason>\n"
+		"    A \"stats\" line reports totals, and a \"quit\" line stops the service.\n"
+		"    Socket clients are served concurrently, while jobs are decoded one at a time.\n");
+	fprintf(stdout, "  [-W | -ServiceTimeout] <seconds>\n"
+		"    Close a service socket connection that sends nothing for this many seconds\n"
+		"    (default 60, 0 for no limit)\n");
     fprintf(stdout,"\n");
 }
 
@@ -362,6 +397,38 @@ static bool parse_precision(const char* option, grk_decompress_parameters* param
     return l_result;
 }
 
+static bool parse_components(const char* option, grk_decompress_parameters* parameters)
+{
+    const char* l_remaining = option;
+    std::vector<uint32_t> l_comps;
+
+    for(;;) {
+        char* l_end = nullptr;
+        unsigned long l_compno = strtoul(l_remaining, &l_end, 10);
+        if (l_end == l_remaining || l_compno >= 16384 ||
+                (*l_end != ',' && *l_end != '\0')) {
+            spdlog::error("Could not parse components option {}\n", option);
+            return false;
+        }
+        l_comps.push_back((uint32_t)l_compno);
+        if (*l_end == '\0')
+            break;
+        l_remaining = l_end + 1;
+    }
+
+    free(parameters->core.comps_to_decode);
+    parameters->core.comps_to_decode = (uint32_t*)malloc(l_comps.size() * sizeof(uint32_t));
+    if (parameters->core.comps_to_decode == nullptr) {
+        spdlog::error("Could not allocate memory for components option");
+        parameters->core.numcomps_to_decode = 0;
+        return false;
+    }
+    memcpy(parameters->core.comps_to_decode, l_comps.data(), l_comps.size() * sizeof(uint32_t));
+    parameters->core.numcomps_to_decode = (uint32_t)l_comps.size();
+
+    return true;
+}
+
 
 /* -------------------------------------------------------------------------- */
 int load_images(dircnt_t *dirptr, char *imgdirpath)
@@ -438,7 +505,9 @@ int parse_cmdline_decoder(int argc,
 							grk_decompress_parameters *parameters,
 							img_fol_t *img_fol,
 							img_fol_t *out_fol,
-							char* plugin_path)
+							char* plugin_path,
+							char* service_path,
+							uint32_t* service_timeout)
 {
 	try {
 
@@ -481,12 +550,17 @@ int parse_cmdline_decoder(int argc,
 		ValueArg<uint32_t> reduceArg("r", "Reduce",
 									"Reduce resolutions", 
 									false, 0, "unsigned integer",cmd);
+		SwitchArg thumbnailArg("T", "Thumbnail",
+								"Thumbnail", cmd);
 		ValueArg<uint32_t> layerArg("l", "Layer",
 									"Layer", 
 									false, 0, "unsigned integer",cmd);
 		ValueArg<uint32_t> tileArg("t", "TileIndex",
 									"Input tile index",
 									false, 0, "unsigned integer", cmd);
+		ValueArg<string> componentsArg("C", "Components",
+										"Components to decode",
+										false, "", "string", cmd);
 		ValueArg<string> precisionArg("p", "Precision",
 										"Force precision",
 										false, "", "string", cmd);
@@ -523,6 +597,14 @@ int parse_cmdline_decoder(int argc,
 
 		SwitchArg verboseArg("v", "verbose",
 			"Verbose", cmd);
+
+		ValueArg<string> serviceArg("S", "Service",
+			"Run as a decode service, reading jobs from stdin (-) or from a Unix domain socket",
+			false, "", "string", cmd);
+
+		ValueArg<uint32_t> serviceTimeoutArg("W", "ServiceTimeout",
+			"Close a service socket connection that sends nothing for this many seconds",
+			false, 0, "unsigned integer", cmd);
 		
 		cmd.parse(argc, argv);
 
@@ -643,7 +725,7 @@ int parse_cmdline_decoder(int argc,
 			}
 		} else {
 			// check for possible output to STDOUT
-			if (!imgDirArg.isSet()){
+			if (!imgDirArg.isSet() && !serviceArg.isSet()){
 				bool toStdout = outForArg.isSet() &&
 						grk::supportedStdioFormat((GROK_SUPPORTED_FILE_FORMAT)parameters->cod_format);
 				if (!toStdout){
@@ -672,6 +754,9 @@ int parse_cmdline_decoder(int argc,
 		if (reduceArg.isSet()) {
 			parameters->core.cp_reduce = reduceArg.getValue();
 		}
+		if (thumbnailArg.isSet()) {
+			parameters->core.thumbnail = true;
+		}
 		if (layerArg.isSet()) {
 			parameters->core.cp_layer = layerArg.getValue();
 		}
@@ -683,6 +768,10 @@ int parse_cmdline_decoder(int argc,
 			if (!parse_precision(precisionArg.getValue().c_str(), parameters))
 				return 1;
 		}
+		if (componentsArg.isSet()) {
+			if (!parse_components(componentsArg.getValue().c_str(), parameters))
+				return 1;
+		}
 		if (numThreadsArg.isSet()) {
 			parameters->core.numThreads = numThreadsArg.getValue();
 		}
@@ -729,6 +818,19 @@ int parse_cmdline_decoder(int argc,
 			parameters->duration = durationArg.getValue();
 		}
 
+		if (serviceArg.isSet()) {
+			if (imgDirArg.isSet() || inputFileArg.isSet() || outputFileArg.isSet()) {
+				spdlog::error("option -Service cannot be used together with -ImgDir, -i or -o");
+				return 1;
+			}
+			if (grk::strcpy_s(service_path, GRK_PATH_LEN, serviceArg.getValue().c_str()) != 0) {
+				spdlog::error( "Path is too long");
+				return 1;
+			}
+			if (serviceTimeoutArg.isSet())
+				*service_timeout = serviceTimeoutArg.getValue();
+		}
+
 
 
 
@@ -760,7 +862,7 @@ int parse_cmdline_decoder(int argc,
             return 1;
         }
     } else {
-		if (parameters->decod_format == UNKNOWN_FORMAT) {
+		if (parameters->decod_format == UNKNOWN_FORMAT && !service_path[0]) {
 			if ((parameters->infile[0] == 0) || (parameters->outfile[0] == 0)) {
 				spdlog::error( "Required parameters are missing\n"
 					"Example: {} -i image.j2k -o image.pgm\n", argv[0]);
@@ -796,6 +898,9 @@ static void destroy_parameters(grk_decompress_parameters* parameters)
             free(parameters->precision);
             parameters->precision = nullptr;
         }
+        free(parameters->core.comps_to_decode);
+        parameters->core.comps_to_decode = nullptr;
+        parameters->core.numcomps_to_decode = 0;
     }
 }
 
@@ -1042,8 +1147,9 @@ void MycmsLogErrorHandlerFunction(cmsContext ContextID, cmsUInt32Number ErrorCod
 
 
 struct DecompressInitParams {
-	DecompressInitParams() : initialized(false) {
+	DecompressInitParams() : initialized(false), service_timeout(60) {
 		plugin_path[0] = 0;
+		service_path[0] = 0;
 		memset(&img_fol, 0, sizeof(img_fol));
 		memset(&out_fol, 0, sizeof(out_fol));
 	}
@@ -1058,6 +1164,10 @@ struct DecompressInitParams {
 
 	grk_decompress_parameters parameters;	/* compression parameters */
 	char plugin_path[GRK_PATH_LEN];
+	/* "-" for stdin, otherwise Unix domain socket path; empty if not a service */
+	char service_path[GRK_PATH_LEN];
+	/* seconds a service socket connection may stay idle; 0 for no limit */
+	uint32_t service_timeout;
 
 	img_fol_t img_fol;
 	img_fol_t out_fol;
@@ -1068,6 +1178,7 @@ static int decode_callback(grok_plugin_decode_callback_info_t* info);
 static int pre_decode(grok_plugin_decode_callback_info_t* info);
 static int post_decode(grok_plugin_decode_callback_info_t* info);
 static int plugin_main(int argc, char **argv, DecompressInitParams* initParams);
+static int service_main(DecompressInitParams* initParams);
 
 
 // returns 0 for failure, 1 for success, and 2 if file is not suitable for decoding
@@ -1113,6 +1224,10 @@ int main(int argc, char **argv){
 			rc = EXIT_FAILURE;
 			goto cleanup;
 		}
+		if (initParams.service_path[0]) {
+			rc = service_main(&initParams) ? EXIT_FAILURE : EXIT_SUCCESS;
+			goto cleanup;
+		}
 		if (plugin_rc == EXIT_SUCCESS) {
 			rc = EXIT_SUCCESS;
 			goto cleanup;
@@ -1176,7 +1291,7 @@ int plugin_main(int argc, char **argv, DecompressInitParams* initParams)
 	set_default_parameters(&initParams->parameters);
 
 	/* parse input and get user encoding parameters */
-	if (parse_cmdline_decoder(argc, argv, &initParams->parameters, &initParams->img_fol, &initParams->out_fol, initParams->plugin_path) == 1) {
+	if (parse_cmdline_decoder(argc, argv, &initParams->parameters, &initParams->img_fol, &initParams->out_fol, initParams->plugin_path, initParams->service_path, &initParams->service_timeout) == 1) {
 		return EXIT_FAILURE;
 	}
 
@@ -1205,6 +1320,12 @@ int plugin_main(int argc, char **argv, DecompressInitParams* initParams)
 		goto cleanup;
 	}
 
+	// service jobs are decoded on the CPU
+	if (initParams->service_path[0]) {
+		success = 1;
+		goto cleanup;
+	}
+
 	isBatch = initParams->img_fol.imgdirpath &&  initParams->out_fol.imgdirpath;
 	if ((grok_plugin_get_debug_state() & GROK_PLUGIN_STATE_DEBUG)) {
 		isBatch = false;
@@ -1337,6 +1458,40 @@ int decode_callback(grok_plugin_decode_callback_info_t* info) {
 	return rc;
 }
 
+// returns nullptr on failure
+static grk_codec_t* create_decoder(int decod_format, grk_decompress_parameters* parameters) {
+	grk_codec_t* codec = nullptr;
+	switch (decod_format) {
+	case J2K_CFMT: {	/* JPEG-2000 codestream */
+						/* Get a decoder handle */
+		codec = grk_create_decompress(GRK_CODEC_J2K);
+		break;
+	}
+	case JP2_CFMT: {	/* JPEG 2000 compressed image data */
+						/* Get a decoder handle */
+		codec = grk_create_decompress(GRK_CODEC_JP2);
+		break;
+	}
+	default:
+		return nullptr;
+	}
+	if (!codec)
+		return nullptr;
+	/* catch events using our callbacks and give a local context */
+	if (parameters->verbose) {
+		grk_set_info_handler(codec, info_callback, nullptr);
+		grk_set_warning_handler(codec, warning_callback, nullptr);
+	}
+	grk_set_error_handler(codec, error_callback, nullptr);
+
+	if (!grk_setup_decoder(codec, &(parameters->core))) {
+		spdlog::error( "grk_decompress: failed to setup the decoder");
+		grk_destroy_codec(codec);
+		return nullptr;
+	}
+	return codec;
+}
+
 // return: 0 for success, non-zero for failure
 int pre_decode(grok_plugin_decode_callback_info_t* info) {
 	if (!info)
@@ -1407,30 +1562,8 @@ int pre_decode(grok_plugin_decode_callback_info_t* info) {
 	}
 
 	if (!info->l_codec) {
-		switch (decod_format) {
-		case J2K_CFMT: {	/* JPEG-2000 codestream */
-							/* Get a decoder handle */
-			info->l_codec = grk_create_decompress(GRK_CODEC_J2K);
-			break;
-		}
-		case JP2_CFMT: {	/* JPEG 2000 compressed image data */
-							/* Get a decoder handle */
-			info->l_codec = grk_create_decompress(GRK_CODEC_JP2);
-			break;
-		}
-		default:
-			failed = 1;
-			goto cleanup;
-		}
-		/* catch events using our callbacks and give a local context */
-		if (parameters->verbose) {
-			grk_set_info_handler(info->l_codec, info_callback, nullptr);
-			grk_set_warning_handler(info->l_codec, warning_callback, nullptr);
-		}
-		grk_set_error_handler(info->l_codec, error_callback, nullptr);
-
-		if (!grk_setup_decoder(info->l_codec, &(parameters->core))) {
-			spdlog::error( "grk_decompress: failed to setup the decoder");
+		info->l_codec = create_decoder(decod_format, parameters);
+		if (!info->l_codec) {
 			failed = 1;
 			goto cleanup;
 		}
@@ -1837,3 +1970,514 @@ cleanup:
 	return failed;
 }
 
+
+/* -------------------------------------------------------------------------- */
+
+/*
+Decode service
+
+A long-running service keeps the thread pool, one decompressor per code stream
+format and the header cache warm, and decodes jobs read one per line from stdin
+or from clients of a Unix domain socket. See decode_help_display for the line protocol.
+
+Each socket client is served by its own thread, so that an idle client does not
+hold up the others, but jobs are decoded one at a time: every job already runs
+on all threads of the library's thread pool.
+*/
+
+// number of file headers kept by the service
+const uint32_t service_header_cache_size = 64;
+
+struct DecodeService {
+	DecodeService() : num_jobs(0),
+					num_failed(0),
+					total_ms(0),
+					total_pixels(0) {
+		codecs[0] = nullptr;
+		codecs[1] = nullptr;
+	}
+	~DecodeService() {
+		for (auto codec : codecs) {
+			if (codec)
+				grk_destroy_codec(codec);
+		}
+	}
+
+	// reusable decompressors, for J2K and JP2 jobs respectively
+	grk_codec_t* codecs[2];
+
+	uint64_t num_jobs;
+	uint64_t num_failed;
+	// totals over successful jobs
+	double total_ms;
+	uint64_t total_pixels;
+
+	// guards decompressors and counters
+	std::mutex mutex;
+};
+
+static bool parse_service_uint(const std::string& value, uint32_t* result) {
+	char* end = nullptr;
+	errno = 0;
+	auto val = strtoul(value.c_str(), &end, 10);
+	if (value.empty() || *end || errno || val > UINT_MAX)
+		return false;
+	*result = (uint32_t)val;
+	return true;
+}
+
+/*
+Split a job line into fields separated by white space. Double quotes
+group white space into a field, and within them a backslash escapes
+a double quote or a backslash. Returns false for an unterminated quote.
+*/
+static bool split_service_job(const std::string& line,
+							std::vector<std::string>& fields) {
+	fields.clear();
+	size_t i = 0;
+	while (true) {
+		while (i < line.size() && isspace((unsigned char)line[i]))
+			++i;
+		if (i == line.size())
+			return true;
+		std::string field;
+		bool quoted = false;
+		while (i < line.size() && (quoted || !isspace((unsigned char)line[i]))) {
+			char c = line[i++];
+			if (c == '"') {
+				quoted = !quoted;
+				continue;
+			}
+			// outside quotes, a backslash is an ordinary path character
+			if (quoted && c == '\\' && i < line.size() && (line[i] == '"' || line[i] == '\\'))
+				c = line[i++];
+			field += c;
+		}
+		if (quoted)
+			return false;
+		fields.push_back(field);
+	}
+}
+
+/*
+Parse a job line into decode parameters, which have been initialized
+from the command line parameters.
+*/
+static bool parse_service_job(const std::string& line,
+							grk_decompress_parameters* parameters,
+							std::string& reason) {
+	std::vector<std::string> fields;
+	if (!split_service_job(line, fields)) {
+		reason = "unterminated quote";
+		return false;
+	}
+	if (fields.size() < 2) {
+		reason = "expected <input file> <output file>";
+		return false;
+	}
+	auto& infile = fields[0];
+	auto& outfile = fields[1];
+	if (grk::strcpy_s(parameters->infile, sizeof(parameters->infile), infile.c_str()) != 0 ||
+			grk::strcpy_s(parameters->outfile, sizeof(parameters->outfile), outfile.c_str()) != 0) {
+		reason = "path is too long";
+		return false;
+	}
+	if (!jpeg2000_file_format(parameters->infile,
+			(GROK_SUPPORTED_FILE_FORMAT*)&parameters->decod_format)) {
+		reason = "unable to open input file " + infile;
+		return false;
+	}
+	if (parameters->decod_format != J2K_CFMT && parameters->decod_format != JP2_CFMT) {
+		reason = "unknown input file format";
+		return false;
+	}
+	parameters->cod_format = get_file_format(parameters->outfile);
+	switch (parameters->cod_format) {
+	case PGX_DFMT:
+	case PXM_DFMT:
+	case BMP_DFMT:
+	case TIF_DFMT:
+	case RAW_DFMT:
+	case RAWL_DFMT:
+	case TGA_DFMT:
+	case PNG_DFMT:
+	case JPG_DFMT:
+		break;
+	default:
+		reason = "unknown output file format";
+		return false;
+	}
+
+	for (size_t i = 2; i < fields.size(); i += 2) {
+		auto& option = fields[i];
+		if (i + 1 == fields.size()) {
+			reason = "missing value for option " + option;
+			return false;
+		}
+		auto& value = fields[i + 1];
+		bool valid = true;
+		if (option == "-r") {
+			valid = parse_service_uint(value, &parameters->core.cp_reduce);
+		} else if (option == "-l") {
+			valid = parse_service_uint(value, &parameters->core.cp_layer);
+		} else if (option == "-t") {
+			valid = parse_service_uint(value, &parameters->tile_index);
+			parameters->nb_tile_to_decode = 1;
+		} else if (option == "-d") {
+			std::vector<char> region(value.begin(), value.end());
+			region.push_back(0);
+			valid = parse_DA_values(false,
+								region.data(),
+								&parameters->DA_x0,
+								&parameters->DA_y0,
+								&parameters->DA_x1,
+								&parameters->DA_y1) == 0;
+		} else {
+			reason = "unknown option " + option;
+			return false;
+		}
+		if (!valid) {
+			reason = "invalid value " + value + " for option " + option;
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+Decode a job with the service's decompressor for its format, and store the
+decoded image. Returns 0 for success, non-zero for failure.
+*/
+static int service_decode(DecodeService* service,
+						grk_decompress_parameters* parameters,
+						uint32_t* width,
+						uint32_t* height) {
+	int failed = 0;
+	grk_stream_t* stream = nullptr;
+	grk_image_t* image = nullptr;
+	auto& codec = service->codecs[parameters->decod_format == JP2_CFMT ? 1 : 0];
+	if (!codec) {
+		codec = create_decoder(parameters->decod_format, parameters);
+		if (!codec)
+			return 1;
+	}
+	// reduce and layers may change from one job to the next
+	else if (!grk_setup_decoder(codec, &(parameters->core))) {
+		spdlog::error( "grk_decompress: failed to setup the decoder");
+		failed = 1;
+		goto cleanup;
+	}
+
+	stream = grk_stream_create_default_file_stream(parameters->infile, true);
+	if (!stream) {
+		spdlog::error( "failed to create the stream from the file {}\n", parameters->infile);
+		failed = 1;
+		goto cleanup;
+	}
+	if (!grk_read_header(stream, codec, &image)) {
+		spdlog::error( "grk_decompress: failed to read the header");
+		failed = 1;
+		goto cleanup;
+	}
+	// limit to 16 bit precision
+	for (uint32_t i = 0; i < image->numcomps; ++i) {
+		if (image->comps[i].prec > 16) {
+			spdlog::error( "grk_decompress: Precision = {} not supported:\n", image->comps[i].prec);
+			failed = 1;
+			goto cleanup;
+		}
+	}
+	if (!grk_set_decode_area(codec, image, parameters->DA_x0,
+		parameters->DA_y0,
+		parameters->DA_x1,
+		parameters->DA_y1)) {
+		spdlog::error( "grk_decompress: failed to set the decoded area");
+		failed = 1;
+		goto cleanup;
+	}
+	if (!parameters->nb_tile_to_decode) {
+		if (!(grk_decode(codec, nullptr, stream, image) && grk_end_decompress(codec, stream))) {
+			spdlog::error( "grk_decompress: failed to decode image!");
+			failed = 1;
+			goto cleanup;
+		}
+	}
+	else if (!grk_get_decoded_tile(codec, stream, image, parameters->tile_index)) {
+		spdlog::error( "grk_decompress: failed to decode tile!");
+		failed = 1;
+		goto cleanup;
+	}
+	*width = image->comps[0].w;
+	*height = image->comps[0].h;
+
+cleanup:
+	if (stream)
+		grk_stream_destroy(stream);
+	if (failed) {
+		// don't reuse a decompressor that failed part way through a stream
+		if (codec)
+			grk_destroy_codec(codec);
+		codec = nullptr;
+		if (image)
+			grk_image_destroy(image);
+		return failed;
+	}
+
+	grok_plugin_decode_callback_info_t info;
+	memset(&info, 0, sizeof(grok_plugin_decode_callback_info_t));
+	info.decod_format = UNKNOWN_FORMAT;
+	info.cod_format = UNKNOWN_FORMAT;
+	info.decode_flags = GROK_DECODE_ALL;
+	info.decoder_parameters = parameters;
+	info.image = image;
+	return post_decode(&info);
+}
+
+static bool read_service_line(FILE* in, std::string& line) {
+	line.clear();
+	int c;
+	while ((c = fgetc(in)) != EOF && c != '\n') {
+		if (c != '\r')
+			line += (char)c;
+	}
+	return c != EOF || !line.empty();
+}
+
+/*
+Run jobs read from in, replying to out, until end of input.
+Returns false if the service was asked to quit.
+*/
+static bool service_jobs(DecodeService* service,
+						DecompressInitParams* initParams,
+						FILE* in,
+						FILE* out) {
+	std::string line;
+	while (read_service_line(in, line)) {
+		auto first = line.find_first_not_of(" \t");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+		line = line.substr(first, line.find_last_not_of(" \t") + 1 - first);
+		if (line == "quit")
+			return false;
+		if (line == "stats") {
+			char reply[256];
+			{
+				std::lock_guard<std::mutex> lock(service->mutex);
+				auto num_ok = service->num_jobs - service->num_failed;
+				snprintf(reply, sizeof(reply), "stats %" PRIu64 " %" PRIu64 " %.3f %.3f\n",
+						service->num_jobs,
+						service->num_failed,
+						num_ok ? service->total_ms / (double)num_ok : 0.0,
+						service->total_ms > 0 ? (double)service->total_pixels / (service->total_ms * 1000) : 0.0);
+			}
+			fputs(reply, out);
+			fflush(out);
+			continue;
+		}
+
+		// reply once the lock is released, so that a client slow to read
+		// its replies does not hold up other clients
+		std::unique_lock<std::mutex> lock(service->mutex);
+		auto job = ++service->num_jobs;
+		auto parameters = initParams->parameters;
+		uint32_t width = 0, height = 0;
+		std::string reason;
+		auto start = std::chrono::high_resolution_clock::now();
+		bool success = parse_service_job(line, &parameters, reason);
+		if (success) {
+			success = service_decode(service, &parameters, &width, &height) == 0;
+			if (!success)
+				reason = "failed to decode " + std::string(parameters.infile);
+		}
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		double ms = elapsed.count() * 1000;
+		uint64_t num_pixels = (uint64_t)width * height;
+		if (success) {
+			service->total_ms += ms;
+			service->total_pixels += num_pixels;
+		}
+		else {
+			service->num_failed++;
+		}
+		lock.unlock();
+		if (success)
+			fprintf(out, "ok %" PRIu64 " %.3f %.3f %ux%u\n",
+					job,
+					ms,
+					ms > 0 ? (double)num_pixels / (ms * 1000) : 0.0,
+					width,
+					height);
+		else
+			fprintf(out, "error %" PRIu64 " %.3f %s\n", job, ms, reason.c_str());
+		fflush(out);
+	}
+	return true;
+}
+
+#ifndef _WIN32
+// open connections of a socket service
+struct ServiceConnections {
+	ServiceConnections() : running(true), num_workers(0) {}
+
+	std::mutex mutex;
+	// signalled when a worker exits
+	std::condition_variable done;
+	// sockets of connections that are still open
+	std::set<int> clients;
+	// cleared once a client asks the service to quit
+	bool running;
+	uint32_t num_workers;
+};
+
+/*
+Connect to the service's own socket, so that a blocking accept returns
+*/
+static void service_wake(const struct sockaddr_un* addr) {
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return;
+	if (connect(fd, (const struct sockaddr*)addr, sizeof(*addr)) < 0)
+		spdlog::warn( "Unable to wake the decode service: {}", strerror(errno));
+	close(fd);
+}
+
+/*
+Serve the jobs of one client, on its own thread
+*/
+static void service_connection(DecodeService* service,
+							DecompressInitParams* initParams,
+							ServiceConnections* connections,
+							const struct sockaddr_un* addr,
+							int client) {
+	// separate streams for reading and writing the same socket
+	int client_out = dup(client);
+	FILE* in = fdopen(client, "r");
+	FILE* out = client_out >= 0 ? fdopen(client_out, "w") : nullptr;
+	bool quit = false;
+	if (in && out)
+		quit = !service_jobs(service, initParams, in, out);
+
+	std::lock_guard<std::mutex> lock(connections->mutex);
+	// forget the socket before it is closed, as its descriptor may be reused
+	connections->clients.erase(client);
+	if (in)
+		fclose(in);
+	else
+		close(client);
+	if (out)
+		fclose(out);
+	else if (client_out >= 0)
+		close(client_out);
+	if (quit && connections->running) {
+		connections->running = false;
+		for (auto other : connections->clients)
+			shutdown(other, SHUT_RDWR);
+		service_wake(addr);
+	}
+	connections->num_workers--;
+	connections->done.notify_all();
+}
+
+static int service_socket(DecodeService* service,
+						DecompressInitParams* initParams) {
+	const char* path = initParams->service_path;
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		spdlog::error( "Socket path {} is too long", path);
+		return 1;
+	}
+	strcpy(addr.sun_path, path);
+
+	// remove a stale socket left behind by a previous service
+	struct stat st;
+	if (lstat(path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			spdlog::error( "{} exists and is not a socket", path);
+			return 1;
+		}
+		unlink(path);
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		spdlog::error( "Unable to create socket: {}", strerror(errno));
+		return 1;
+	}
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+		spdlog::error( "Unable to listen on socket {}: {}", path, strerror(errno));
+		close(fd);
+		return 1;
+	}
+	// a client that disconnects early must not terminate the service
+	signal(SIGPIPE, SIG_IGN);
+
+	int rc = 0;
+	ServiceConnections connections;
+	while (true) {
+		int client = accept(fd, nullptr, nullptr);
+		std::unique_lock<std::mutex> lock(connections.mutex);
+		if (!connections.running) {
+			if (client >= 0)
+				close(client);
+			break;
+		}
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			spdlog::error( "Unable to accept connection: {}", strerror(errno));
+			rc = 1;
+			break;
+		}
+		// a client that sends nothing for too long is disconnected:
+		// its read then ends as if the client had closed the connection
+		if (initParams->service_timeout) {
+			struct timeval tv;
+			tv.tv_sec = (time_t)initParams->service_timeout;
+			tv.tv_usec = 0;
+			if (setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+					setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0)
+				spdlog::warn( "Unable to set connection timeout: {}", strerror(errno));
+		}
+		connections.clients.insert(client);
+		connections.num_workers++;
+		std::thread(service_connection, service, initParams, &connections, &addr, client).detach();
+	}
+
+	// close remaining connections and wait for their workers
+	std::unique_lock<std::mutex> lock(connections.mutex);
+	connections.running = false;
+	for (auto client : connections.clients)
+		shutdown(client, SHUT_RDWR);
+	connections.done.wait(lock, [&connections] { return connections.num_workers == 0; });
+	close(fd);
+	unlink(path);
+	return rc;
+}
+#endif
+
+int service_main(DecompressInitParams* initParams) {
+	int rc = 0;
+	// cache headers, so that repeated jobs on a file skip header parsing
+	// and seek directly to the tile-parts they need
+	grk_set_header_cache_size(service_header_cache_size);
+	DecodeService service;
+	if (!strcmp(initParams->service_path, "-")) {
+		// replies are written to stdout, so log to stderr
+		spdlog::set_default_logger(spdlog::stderr_color_mt("grk_decompress"));
+		service_jobs(&service, initParams, stdin, stdout);
+	}
+	else {
+#ifdef _WIN32
+		spdlog::error( "Unix domain sockets are not supported on this platform: use -Service - to read jobs from stdin");
+		rc = 1;
+#else
+		rc = service_socket(&service, initParams);
+#endif
+	}
+	grk_set_header_cache_size(0);
+	if (service.num_jobs)
+		spdlog::info("decode service: {} jobs, {} failed, {} ms decode time\n",
+				service.num_jobs, service.num_failed, service.total_ms);
+	return rc;
+}
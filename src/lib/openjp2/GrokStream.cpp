@@ -154,7 +154,18 @@ size_t GrokStream::read(uint8_t *p_buffer, size_t p_size) {
 	//a) very first memory buffer "read", or buffered file read
 	if (m_buffer) {
 		for (;;) {
-			m_bytes_in_buffer = m_read_fn(m_buffer, m_buffer_size, m_user_data);
+			// never ask for data beyond the user data length: a pipe, or a file
+			// that is still being written, may not hold it yet
+			size_t l_request = m_buffer_size;
+			if (m_user_data_length) {
+				if (m_stream_offset >= m_user_data_length) {
+					m_status |= GROK_STREAM_STATUS_END;
+					return l_read_nb_bytes ? l_read_nb_bytes : (size_t) -1;
+				}
+				l_request = (size_t) std::min<uint64_t>(l_request,
+						m_user_data_length - m_stream_offset);
+			}
+			m_bytes_in_buffer = m_read_fn(m_buffer, l_request, m_user_data);
 			// i) end of stream
 			if (m_bytes_in_buffer == (size_t) -1) {
 				invalidate_buffer();
@@ -94,6 +94,12 @@ struct GrokStream: public IGrokStream {
 	 */
 	uint64_t m_user_data_length;
 
+	/**
+	 * Identity of the file being read, used as header cache key.
+	 * Empty if the stream is not a regular file read stream.
+	 */
+	std::string m_identity;
+
 	/**
 	 * Pointer to actual read function (nullptr at the initialization of the cio).
 	 */
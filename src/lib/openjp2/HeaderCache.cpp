@@ -0,0 +1,97 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+#include "grok_includes.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace grk {
+
+HeaderCache* HeaderCache::instance() {
+	static HeaderCache cache;
+	return &cache;
+}
+
+void HeaderCache::set_capacity(uint32_t num_entries) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cache.set_capacity(num_entries);
+}
+
+bool HeaderCache::enabled() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_cache.capacity() != 0;
+}
+
+HeaderCacheEntryPtr HeaderCache::get(const std::string &identity) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (identity.empty())
+		return nullptr;
+	return m_cache.get(identity);
+}
+
+void HeaderCache::put(const std::string &identity,
+		HeaderCacheEntryPtr entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (identity.empty() || !entry)
+		return;
+	m_cache.put(identity, entry, 1);
+}
+
+#ifdef _WIN32
+/* st_ino is always 0 on Windows: use the volume serial number
+ and file index instead, which together identify an open file */
+std::string header_cache_file_identity(void *handle) {
+	BY_HANDLE_FILE_INFORMATION info;
+	if (handle == INVALID_HANDLE_VALUE
+			|| GetFileType((HANDLE) handle) != FILE_TYPE_DISK
+			|| !GetFileInformationByHandle((HANDLE) handle, &info)
+			|| (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		return "";
+	uint64_t index = ((uint64_t) info.nFileIndexHigh << 32)
+			| info.nFileIndexLow;
+	uint64_t size = ((uint64_t) info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	uint64_t mtime = ((uint64_t) info.ftLastWriteTime.dwHighDateTime << 32)
+			| info.ftLastWriteTime.dwLowDateTime;
+	std::stringstream ss;
+	ss << info.dwVolumeSerialNumber << ":" << index << ":" << size << ":"
+			<< mtime;
+	return ss.str();
+}
+
+std::string header_cache_file_identity(int fd) {
+	return header_cache_file_identity((void*) _get_osfhandle(fd));
+}
+#else
+std::string header_cache_file_identity(int fd) {
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		return "";
+	std::stringstream ss;
+	ss << st.st_dev << ":" << st.st_ino << ":" << st.st_size << ":"
+			<< st.st_mtime;
+#if defined(__linux__)
+	ss << "." << st.st_mtim.tv_nsec;
+#endif
+	return ss.str();
+}
+#endif
+
+}
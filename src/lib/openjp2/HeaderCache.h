@@ -0,0 +1,94 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "LRUCache.h"
+
+namespace grk {
+
+/**
+ Position of a tile-part (its SOT marker) in a code stream
+ */
+struct TilePartPos {
+	uint64_t pos;
+	uint32_t tileno;
+};
+
+/**
+ Header of an image file, as read by a previous decompressor
+ */
+struct HeaderCacheEntry {
+	/** bytes from the start of the file to the first SOT marker (inclusive) */
+	std::vector<uint8_t> header;
+	/** all tile-parts of the code stream, sorted by position.
+	 *  Empty until one decode has walked the whole code stream. */
+	std::vector<TilePartPos> tile_parts;
+};
+
+typedef std::shared_ptr<const HeaderCacheEntry> HeaderCacheEntryPtr;
+
+/**
+ Process-wide LRU cache of image headers, keyed by file identity.
+
+ Entries are immutable once inserted, so a decompressor may keep
+ using an entry after it has been evicted or replaced.
+ */
+class HeaderCache {
+public:
+	static HeaderCache* instance();
+
+	/**
+	 * Set maximum number of entries. Zero disables and clears the cache.
+	 */
+	void set_capacity(uint32_t num_entries);
+	bool enabled();
+
+	HeaderCacheEntryPtr get(const std::string &identity);
+	void put(const std::string &identity, HeaderCacheEntryPtr entry);
+
+private:
+	LRUCache<HeaderCacheEntryPtr> m_cache;
+	std::mutex m_mutex;
+};
+
+/**
+ * Identity of an open file, made from its device, inode, size
+ * and modification time, so that a rewritten file gets a new identity.
+ * On Windows, the volume serial number and file index stand in for
+ * device and inode. The tile cache keys on the same identity.
+ *
+ * @param fd	file descriptor
+ * @return empty string if file cannot be identified
+ */
+std::string header_cache_file_identity(int fd);
+#ifdef _WIN32
+/**
+ * Identity of an open file, from its Windows file handle
+ *
+ * @param handle	file handle
+ * @return empty string if file cannot be identified
+ */
+std::string header_cache_file_identity(void *handle);
+#endif
+
+}
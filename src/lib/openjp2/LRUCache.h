@@ -0,0 +1,103 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+
+namespace grk {
+
+/**
+ Least recently used cache of values keyed by string.
+ Each value has a cost, and least recently used values are evicted
+ until the total cost is within the capacity.
+ Not thread safe: callers are responsible for locking.
+ */
+template<typename V> class LRUCache {
+public:
+	LRUCache() :
+			m_capacity(0), m_cost(0) {
+	}
+
+	void set_capacity(uint64_t capacity) {
+		m_capacity = capacity;
+		evict();
+	}
+	uint64_t capacity() {
+		return m_capacity;
+	}
+	uint64_t cost() {
+		return m_cost;
+	}
+	size_t size() {
+		return m_lru.size();
+	}
+
+	/**
+	 * Get a value, and mark it as most recently used
+	 *
+	 * @return value, or default constructed value if key is not found
+	 */
+	V get(const std::string &key) {
+		auto it = m_items.find(key);
+		if (it == m_items.end())
+			return V();
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+		return it->second->value;
+	}
+
+	/**
+	 * Add or replace a value. Values that cost more than the capacity are not added.
+	 */
+	void put(const std::string &key, const V &value, uint64_t cost) {
+		auto it = m_items.find(key);
+		if (it != m_items.end()) {
+			m_cost -= it->second->cost;
+			m_lru.erase(it->second);
+			m_items.erase(it);
+		}
+		if (cost > m_capacity)
+			return;
+		m_lru.push_front( { key, value, cost });
+		m_items[key] = m_lru.begin();
+		m_cost += cost;
+		evict();
+	}
+
+private:
+	struct Item {
+		std::string key;
+		V value;
+		uint64_t cost;
+	};
+	void evict() {
+		while (m_cost > m_capacity) {
+			m_cost -= m_lru.back().cost;
+			m_items.erase(m_lru.back().key);
+			m_lru.pop_back();
+		}
+	}
+	std::list<Item> m_lru;
+	std::unordered_map<std::string, typename std::list<Item>::iterator> m_items;
+	uint64_t m_capacity;
+	uint64_t m_cost;
+};
+
+}
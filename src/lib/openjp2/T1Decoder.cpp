@@ -38,6 +38,13 @@ T1Decoder::~T1Decoder() {
 	}
 }
 
+bool T1Decoder::isCompatible(uint16_t blockw, uint16_t blockh) {
+	return codeblock_width == (uint16_t) (blockw ? (uint32_t) 1 << blockw : 0)
+			&& codeblock_height
+					== (uint16_t) (blockh ? (uint32_t) 1 << blockh : 0)
+			&& threadStructs.size() == Scheduler::g_TS.GetNumTaskThreads();
+}
+
 bool T1Decoder::decode(std::vector<decodeBlockInfo*> *blocks) {
 	if (!blocks || !blocks->size())
 		return true;;
@@ -46,6 +53,7 @@ bool T1Decoder::decode(std::vector<decodeBlockInfo*> *blocks) {
 	for (uint64_t i = 0; i < maxBlocks; ++i) {
 		decodeBlocks[i] = blocks->operator[](i);
 	}
+	blockCount = -1;
 	success = true;
 	enki::TaskSet task((uint32_t) maxBlocks,
 			[this, maxBlocks](enki::TaskSetPartition range, uint32_t threadnum) {
@@ -65,11 +73,23 @@ bool T1Decoder::decode(std::vector<decodeBlockInfo*> *blocks) {
 						return;
 					}
 					impl->postDecode(block);
+					if (block->cachedp) {
+						auto cblk = block->cblk;
+						uint32_t cblk_w = cblk->x1 - cblk->x0;
+						uint32_t cblk_h = cblk->y1 - cblk->y0;
+						uint32_t tile_width = block->tilec->x1 - block->tilec->x0;
+						for (uint32_t j = 0; j < cblk_h; ++j)
+							memcpy(block->cachedp + (uint64_t) j * tile_width,
+									block->tiledp + (uint64_t) j * tile_width,
+									cblk_w * sizeof(int32_t));
+					}
 					delete block;
 				}
 			});
 	Scheduler::g_TS.AddTaskSetToPipe(&task);
 	Scheduler::g_TS.WaitforTask(&task);
+	delete[] decodeBlocks;
+	decodeBlocks = nullptr;
 
 	return success;
 }
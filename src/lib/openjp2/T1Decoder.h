@@ -30,6 +30,9 @@ public:
 	T1Decoder(tcp_t *tcp, uint16_t blockw, uint16_t blockh);
 	~T1Decoder();
 	bool decode(std::vector<decodeBlockInfo*> *blocks);
+	/** true if this decoder can be reused for code blocks of nominal size
+	 * 2^blockw x 2^blockh, with the current number of threads */
+	bool isCompatible(uint16_t blockw, uint16_t blockh);
 
 private:
 	uint16_t codeblock_width, codeblock_height;  //nominal dimensions of block
@@ -59,6 +59,7 @@ bool T1Encoder::encode(std::vector<encodeBlockInfo*> *blocks) {
 		return true;
 
 	auto maxBlocks = blocks->size();
+	blockCount = -1;
 	encodeBlocks = new encodeBlockInfo*[maxBlocks];
 	for (uint64_t i = 0; i < maxBlocks; ++i) {
 		encodeBlocks[i] = blocks->operator[](i);
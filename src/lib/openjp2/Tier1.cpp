@@ -16,13 +16,91 @@
  */
 
 #include "Tier1.h"
-#include "T1Decoder.h"
 #include "T1Encoder.h"
 
 namespace grk {
 
+// Passes are only skipped below a quarter of the expected threshold: the
+// final threshold of a tile may be lower than that of its neighbour, or than
+// an estimate from a sample of its code-blocks
+const double slope_safety_factor = 0.25;
+// one code-block in sample_stride is coded in full to estimate the threshold
+const uint32_t sample_stride = 8;
+// with fewer code-blocks, the sample is too small to be representative
+const size_t min_sampled_blocks = 128;
+
+/*
+ Rate of the passes of a code-block that rate control includes in
+ a single layer at threshold thresh, as make_layer_simple selects them
+ */
+static uint64_t included_rate(tcd_cblk_enc_t *cblk, double thresh) {
+	uint32_t included = 0;
+	for (uint32_t passno = 0; passno < cblk->num_passes_encoded; ++passno) {
+		tcd_pass_t *pass = cblk->passes + passno;
+		uint32_t dr = pass->rate;
+		double dd = pass->distortiondec;
+		if (included) {
+			dr -= cblk->passes[included - 1].rate;
+			dd -= cblk->passes[included - 1].distortiondec;
+		}
+		if (!dr) {
+			if (dd != 0)
+				included = passno + 1;
+			continue;
+		}
+		if (thresh - dd / dr < DBL_EPSILON)
+			included = passno + 1;
+	}
+	return included ? cblk->passes[included - 1].rate : 0;
+}
+
+/*
+ Estimate the rate control threshold of a tile from a sample of its
+ code-blocks, coded in full: the smallest slope at which the sample,
+ scaled by the ratio of tile to sample area, fits in max_len bytes.
+ Returns 0 if the whole tile is expected to fit.
+ */
+static double estimate_slope_thresh(std::vector<tcd_cblk_enc_t*> *sample,
+		double scale, uint64_t max_len) {
+	double lo = DBL_MAX;
+	double hi = 0;
+	for (auto cblk : *sample) {
+		for (uint32_t passno = 0; passno < cblk->num_passes_encoded; ++passno) {
+			tcd_pass_t *pass = cblk->passes + passno;
+			uint32_t dr = pass->rate;
+			double dd = pass->distortiondec;
+			if (passno) {
+				dr -= cblk->passes[passno - 1].rate;
+				dd -= cblk->passes[passno - 1].distortiondec;
+			}
+			if (!dr || dd <= 0)
+				continue;
+			lo = std::min(lo, dd / dr);
+			hi = std::max(hi, dd / dr);
+		}
+	}
+	auto fits = [sample, scale, max_len](double thresh) {
+		uint64_t rate = 0;
+		for (auto cblk : *sample)
+			rate += included_rate(cblk, thresh);
+		return (double) rate * scale <= (double) max_len;
+	};
+	if (hi == 0 || fits(lo))
+		return 0;
+	/* bisect geometrically, as slopes span many orders of magnitude */
+	for (uint32_t i = 0; i < 32; ++i) {
+		double mid = sqrt(lo * hi);
+		if (fits(mid))
+			hi = mid;
+		else
+			lo = mid;
+	}
+	return hi;
+}
+
 bool Tier1::encodeCodeblocks(tcp_t *tcp, tcd_tile_t *tile,
-		const double *mct_norms, uint32_t mct_numcomps,	bool doRateControl) {
+		const double *mct_norms, uint32_t mct_numcomps,	bool doRateControl,
+		double slope_thresh, uint64_t max_len) {
 
 	uint32_t compno, resno, bandno, precno;
 	tile->distotile = 0;
@@ -91,18 +169,58 @@ bool Tier1::encodeCodeblocks(tcp_t *tcp, tcd_tile_t *tile,
 	}
 
 	T1Encoder encoder(tcp, tile, maxCblkW, maxCblkH, doRateControl);
+	if (doRateControl && !slope_thresh && max_len
+			&& blocks.size() >= min_sampled_blocks) {
+		std::vector<encodeBlockInfo*> sampleBlocks;
+		std::vector<encodeBlockInfo*> otherBlocks;
+		std::vector<tcd_cblk_enc_t*> sample;
+		uint64_t sampleArea = 0;
+		uint64_t area = 0;
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			auto cblk = blocks[i]->cblk;
+			uint64_t cblkArea = (uint64_t) (cblk->x1 - cblk->x0)
+					* (cblk->y1 - cblk->y0);
+			area += cblkArea;
+			if (i % sample_stride == 0) {
+				sampleBlocks.push_back(blocks[i]);
+				sample.push_back(cblk);
+				sampleArea += cblkArea;
+			} else {
+				otherBlocks.push_back(blocks[i]);
+			}
+		}
+		if (!encoder.encode(&sampleBlocks))
+			return false;
+		if (sampleArea)
+			slope_thresh = estimate_slope_thresh(&sample,
+					(double) area / (double) sampleArea, max_len);
+		blocks.swap(otherBlocks);
+	}
+	for (auto block : blocks)
+		block->min_slope = slope_thresh * slope_safety_factor;
 	return encoder.encode(&blocks);
 }
 
 bool Tier1::prepareDecodeCodeblocks(tcd_tilecomp_t *tilec, tccp_t *tccp,
+		layer_refinement_comp_t *refinement, uint32_t numres,
 		std::vector<decodeBlockInfo*> *blocks) {
 	uint32_t resno, bandno, precno;
 	if (!tile_buf_alloc_component_data_decode(tilec->buf)) {
 		GROK_ERROR( "Not enough memory for tile data");
 		return false;
 	}
+	uint32_t tile_width = tilec->x1 - tilec->x0;
+	uint64_t tile_area = (uint64_t) tile_width * (tilec->y1 - tilec->y0);
+	int32_t *tile_origin = tile_buf_get_ptr(tilec->buf, 0, 0, 0, 0);
+	if (refinement && refinement->coeffs.size() != tile_area) {
+		/* geometry changed: nothing cached is usable */
+		refinement->coeffs.assign(tile_area, 0);
+		refinement->cblk_state.clear();
+	}
+	uint64_t cblk_index = 0;
 
-	for (resno = 0; resno < tilec->minimum_num_resolutions; ++resno) {
+	numres = std::min(numres, tilec->minimum_num_resolutions);
+	for (resno = 0; resno < numres; ++resno) {
 		tcd_resolution_t *res = &tilec->resolutions[resno];
 
 		for (bandno = 0; bandno < res->numbands; ++bandno) {
@@ -124,8 +242,10 @@ bool Tier1::prepareDecodeCodeblocks(tcd_tilecomp_t *tilec, tccp_t *tccp,
 					/* check if block overlaps with decode region */
 					cblk_rect = rect_t(x, y, x + (1 << tccp->cblkw),
 							y + (1 << tccp->cblkh));
-					if (!tile_buf_hit_test(tilec->buf, &cblk_rect))
+					if (!tile_buf_hit_test_band(tilec->buf, resno, bandno,
+							&cblk_rect))
 						continue;
+					uint64_t k = cblk_index++;
 
 					x -= band->x0;
 					y -= band->y0;
@@ -151,8 +271,37 @@ bool Tier1::prepareDecodeCodeblocks(tcd_tilecomp_t *tilec, tccp_t *tccp,
 					block->tilec = tilec;
 					block->x = x;
 					block->y = y;
-					block->tiledp = tile_buf_get_ptr(tilec->buf, resno, bandno,
-							(uint32_t) x, (uint32_t) y);
+					/* narrow buffers are written through tile_buf_get_narrow_ptr */
+					if (!tilec->buf->narrow)
+						block->tiledp = tile_buf_get_ptr(tilec->buf, resno,
+								bandno, (uint32_t) x, (uint32_t) y);
+					if (refinement) {
+						/* compressed bytes and passes read so far
+						 * identify the decoded state of the block */
+						layer_refinement_cblk_t state(0, 0);
+						for (uint32_t segno = 0; segno < cblk->numSegments;
+								++segno) {
+							state.len += cblk->segs[segno].len;
+							state.passes += cblk->segs[segno].numPassesRead;
+						}
+						if (k >= refinement->cblk_state.size())
+							refinement->cblk_state.resize(k + 1);
+						int32_t *cachedp = &refinement->coeffs[0]
+								+ (block->tiledp - tile_origin);
+						if (refinement->cblk_state[k] == state) {
+							/* no new data: restore previous coefficients */
+							uint32_t cblk_w = cblk->x1 - cblk->x0;
+							uint32_t cblk_h = cblk->y1 - cblk->y0;
+							for (uint32_t j = 0; j < cblk_h; ++j)
+								memcpy(block->tiledp + (uint64_t) j * tile_width,
+										cachedp + (uint64_t) j * tile_width,
+										cblk_w * sizeof(int32_t));
+							delete block;
+							continue;
+						}
+						refinement->cblk_state[k] = state;
+						block->cachedp = cachedp;
+					}
 					blocks->push_back(block);
 
 				}
@@ -162,10 +311,4 @@ bool Tier1::prepareDecodeCodeblocks(tcd_tilecomp_t *tilec, tccp_t *tccp,
 	return true;
 }
 
-bool Tier1::decodeCodeblocks(tcp_t *tcp, uint16_t blockw, uint16_t blockh,
-		std::vector<decodeBlockInfo*> *blocks) {
-	T1Decoder decoder(tcp, blockw, blockh);
-	return decoder.decode(blocks);
-}
-
 }
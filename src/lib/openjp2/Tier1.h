@@ -26,13 +26,19 @@ namespace grk {
 class Tier1 {
 public:
 
+	/**
+	 Encode all code-blocks of a tile.
+	 With rate control, passes far below the final rate control threshold
+	 slope_thresh are not coded. If slope_thresh is unknown (zero), it is
+	 estimated from a sample of code-blocks coded in full, as the threshold
+	 at which the tile fits in max_len bytes; a zero max_len codes all passes.
+	 */
 	bool encodeCodeblocks(tcp_t *tcp, tcd_tile_t *tile, const double *mct_norms,
-			uint32_t mct_numcomps, bool doRateControl);
+			uint32_t mct_numcomps, bool doRateControl, double slope_thresh,
+			uint64_t max_len);
 
 	bool prepareDecodeCodeblocks(tcd_tilecomp_t *tilec, tccp_t *tccp,
-			std::vector<decodeBlockInfo*> *blocks);
-
-	bool decodeCodeblocks(tcp_t *tcp, uint16_t blockw, uint16_t blockh,
+			layer_refinement_comp_t *refinement, uint32_t numres,
 			std::vector<decodeBlockInfo*> *blocks);
 
 };
@@ -0,0 +1,98 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+#include "grok_includes.h"
+
+namespace grk {
+
+TileCache* TileCache::instance() {
+	static TileCache cache;
+	return &cache;
+}
+
+void TileCache::set_capacity(uint64_t max_bytes) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cache.set_capacity(max_bytes);
+}
+
+bool TileCache::enabled() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_cache.capacity() != 0;
+}
+
+TileCacheEntryPtr TileCache::get(const std::string &key) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto l_entry = m_cache.get(key);
+	if (l_entry)
+		m_hits++;
+	else
+		m_misses++;
+	return l_entry;
+}
+
+void TileCache::put(const std::string &key, TileCacheEntryPtr entry) {
+	if (!entry)
+		return;
+	uint64_t l_cost = sizeof(TileCacheEntry);
+	for (auto &d : entry->data)
+		l_cost += d.size() * sizeof(int32_t);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_cache.put(key, entry, l_cost);
+}
+
+void TileCache::get_stats(grk_tile_cache_stats_t *stats) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	stats->hits = m_hits;
+	stats->misses = m_misses;
+	stats->num_tiles = m_cache.size();
+	stats->num_bytes = m_cache.cost();
+}
+
+bool TileCache::copy_to_image(const TileCacheEntry *entry,
+		grk_image_t *image) {
+	if (entry->comps.size() > image->numcomps)
+		return false;
+	grk_image_all_components_data_free(image);
+	image->numcomps = (uint32_t) entry->comps.size();
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto l_comp = image->comps + compno;
+		*l_comp = entry->comps[compno];
+		l_comp->data = nullptr;
+		l_comp->owns_data = false;
+		if (!grk_image_single_component_data_alloc(l_comp))
+			return false;
+		memcpy(l_comp->data, entry->data[compno].data(),
+				entry->data[compno].size() * sizeof(int32_t));
+	}
+	return true;
+}
+
+TileCacheEntryPtr TileCache::create_entry(grk_image_t *image) {
+	auto l_entry = std::make_shared<TileCacheEntry>();
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto l_comp = image->comps + compno;
+		if (!l_comp->data)
+			return nullptr;
+		l_entry->comps.push_back(*l_comp);
+		l_entry->comps.back().data = nullptr;
+		l_entry->data.emplace_back(l_comp->data,
+				l_comp->data + (uint64_t) l_comp->w * l_comp->h);
+	}
+	return l_entry;
+}
+
+}
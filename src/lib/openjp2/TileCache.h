@@ -0,0 +1,87 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "LRUCache.h"
+
+namespace grk {
+
+/**
+ Decoded tile, as returned by a previous call to grk_get_decoded_tile
+ */
+struct TileCacheEntry {
+	/** image components: data pointers are not used */
+	std::vector<grk_image_comp_t> comps;
+	/** decoded samples of each component */
+	std::vector<std::vector<int32_t> > data;
+};
+
+typedef std::shared_ptr<const TileCacheEntry> TileCacheEntryPtr;
+
+/**
+ Process-wide LRU cache of decoded tiles, with a budget in bytes.
+
+ Entries are immutable once inserted, so a decompressor may keep
+ using an entry after it has been evicted.
+ */
+class TileCache {
+public:
+	static TileCache* instance();
+
+	/**
+	 * Set budget in bytes. Zero disables and clears the cache.
+	 */
+	void set_capacity(uint64_t max_bytes);
+	bool enabled();
+
+	/**
+	 * Get a decoded tile, and count the hit or miss
+	 */
+	TileCacheEntryPtr get(const std::string &key);
+	void put(const std::string &key, TileCacheEntryPtr entry);
+	void get_stats(grk_tile_cache_stats_t *stats);
+
+	/**
+	 * Copy a decoded tile into the components of an image
+	 */
+	static bool copy_to_image(const TileCacheEntry *entry,
+			grk_image_t *image);
+
+	/**
+	 * Create an entry from the components of a decoded image
+	 *
+	 * @return nullptr if the image has components without data
+	 */
+	static TileCacheEntryPtr create_entry(grk_image_t *image);
+
+private:
+	TileCache() :
+			m_hits(0), m_misses(0) {
+	}
+	LRUCache<TileCacheEntryPtr> m_cache;
+	uint64_t m_hits;
+	uint64_t m_misses;
+	std::mutex m_mutex;
+};
+
+}
@@ -55,8 +55,10 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
+#include "CPUArch.h"
 #include "grok_includes.h"
 #include "Tier1.h"
+#include "T1Decoder.h"
 #include <memory>
 
 namespace grk {
@@ -422,6 +424,7 @@ bool TileProcessor::pcrd_bisect_simple(uint64_t *p_data_written, uint64_t len) {
 	}
 
 	double upperBound = max_slope;
+	m_prev_min_slope = 0;
 	for (layno = 0; layno < tcd_tcp->numlayers; layno++) {
 		if (layer_needs_rate_control(layno)) {
 			double lowerBound = min_slope;
@@ -483,6 +486,10 @@ bool TileProcessor::pcrd_bisect_simple(uint64_t *p_data_written, uint64_t len) {
 			t2_destroy(t2);
 
 			make_layer_simple(layno, goodthresh, true);
+			// passes below the final layer's threshold are never included,
+			// so T1 can skip them for the next tile
+			if (layno == tcd_tcp->numlayers - 1 && skips_discarded_passes())
+				m_prev_min_slope = goodthresh;
 			cumdisto[layno] =
 					(layno == 0) ?
 							tcd_tile->distolayer[0] :
@@ -492,10 +499,11 @@ bool TileProcessor::pcrd_bisect_simple(uint64_t *p_data_written, uint64_t len) {
 			upperBound = lowerBound - 1;
 		} else {
 			//todo: shouldn't need rate-distortion slope calculations to make this last layer
+			// this layer takes all remaining passes. A small tile can get a
+			// non-positive rate before its last layer, so keep going:
+			// later layers must be made too, with no passes, or their pass
+			// counts are left over from the previous tile
 			make_layer_simple(layno, 0, true);
-			assert(layno == tcd_tcp->numlayers - 1);
-			// this has to be the last layer, so return 
-			return true;
 		}
 	}
 	return true;
@@ -710,9 +718,32 @@ bool TileProcessor::init(grk_image_t *p_image, cp_t *p_cp) {
 
 /* ----------------------------------------------------------------------- */
 
+/**
+ * Check if tile component must be decoded : either it was selected for decoding,
+ * or it is an input to the inverse multiple component transform
+ * of a selected component.
+ */
+static bool decode_needs_component(cp_t *p_cp, tcp_t *p_tcp, uint32_t numcomps,
+		uint32_t compno) {
+	if (j2k_decodes_component(p_cp, compno))
+		return true;
+	if (!p_tcp->mct || numcomps < 3)
+		return false;
+	/* custom MCT mixes all components, while RCT/ICT mix the first three */
+	uint32_t l_mct_numcomps = (p_tcp->mct == 2) ? numcomps : 3;
+	if (compno >= l_mct_numcomps)
+		return false;
+	for (uint32_t i = 0; i < l_mct_numcomps; ++i) {
+		if (j2k_decodes_component(p_cp, i))
+			return true;
+	}
+	return false;
+}
+
 inline bool TileProcessor::init_tile(uint32_t tile_no,
 		grk_image_t *output_image, bool isEncoder, float fraction,
-		size_t sizeof_block) {
+		size_t sizeof_block, const grk_decode_area_t *areas,
+		uint32_t num_areas) {
 	uint32_t (*l_gain_ptr)(uint8_t) = nullptr;
 	uint32_t compno, resno, bandno, precno;
 	tcp_t *l_tcp = nullptr;
@@ -789,6 +820,9 @@ inline bool TileProcessor::init_tile(uint32_t tile_no,
 			return false;
 		}
 		l_image_comp->resno_decoded = 0;
+		l_tilec->skip_decode = !isEncoder
+				&& !decode_needs_component(l_cp, l_tcp, l_tile->numcomps,
+						compno);
 		/* border of each l_tile component (global) */
 		l_tilec->x0 = ceildiv<uint32_t>(l_tile->x0, l_image_comp->dx);
 		l_tilec->y0 = ceildiv<uint32_t>(l_tile->y0, l_image_comp->dy);
@@ -1107,7 +1141,7 @@ inline bool TileProcessor::init_tile(uint32_t tile_no,
 		if (!tile_buf_create_component(l_tilec, isEncoder,
 				l_tccp->qmfbid ? false : true, 1 << l_tccp->cblkw,
 				1 << l_tccp->cblkh, output_image, l_image_comp->dx,
-				l_image_comp->dy)) {
+				l_image_comp->dy, areas, num_areas)) {
 			return false;
 		}
 		l_tilec->buf->data_size_needed = l_tile_data_size;
@@ -1131,13 +1165,14 @@ inline bool TileProcessor::init_tile(uint32_t tile_no,
 
 bool TileProcessor::init_encode_tile(uint32_t tile_no) {
 	return init_tile(tile_no, nullptr, true, 1.0F,
-			sizeof(tcd_cblk_enc_t));
+			sizeof(tcd_cblk_enc_t), nullptr, 0);
 }
 
 bool TileProcessor::init_decode_tile(grk_image_t *output_image,
-		uint32_t tile_no) {
+		uint32_t tile_no, const grk_decode_area_t *areas,
+		uint32_t num_areas) {
 	return init_tile(tile_no, output_image, false, 0.5F,
-			sizeof(tcd_cblk_dec_t));
+			sizeof(tcd_cblk_dec_t), areas, num_areas);
 
 }
 
@@ -1157,6 +1192,11 @@ uint64_t TileProcessor::get_decoded_tile_size() {
 	l_img_comp = image->comps;
 
 	for (i = 0; i < image->numcomps; ++i) {
+		if (!j2k_decodes_component(cp, i)) {
+			++l_img_comp;
+			++l_tile_comp;
+			continue;
+		}
 		l_size_comp = (l_img_comp->prec + 7) >> 3;
 
 		if (l_size_comp == 3) {
@@ -1274,6 +1314,7 @@ bool TileProcessor::decode_tile(seg_buf_t *src_buf, uint32_t tile_no) {
 	}
 
 	if (doT1) {
+		set_narrow_buffers(use_narrow_buffers());
 		if (!t1_decode()) {
 			return false;
 		}
@@ -1284,6 +1325,11 @@ bool TileProcessor::decode_tile(seg_buf_t *src_buf, uint32_t tile_no) {
 		if (!dwt_decode()) {
 			return false;
 		}
+		/* the inverse DWT does not fit in 16 bits: MCT needs all components
+		 * to have the same sample width, so all of them are widened */
+		if (narrow_buffers_overflowed() && !widen_narrow_buffers()) {
+			return false;
+		}
 		if (!mct_decode()) {
 			return false;
 		}
@@ -1332,6 +1378,11 @@ bool TileProcessor::update_tile_data(uint8_t *p_dest,
 	l_img_comp = image->comps;
 
 	for (i = 0; i < image->numcomps; ++i) {
+		if (!j2k_decodes_component(cp, i)) {
+			++l_img_comp;
+			++l_tilec;
+			continue;
+		}
 		l_size_comp = (l_img_comp->prec + 7) >> 3;
 		l_res = l_tilec->resolutions + l_img_comp->resno_decoded;
 		l_width = (l_res->x1 - l_res->x0);
@@ -1424,6 +1475,9 @@ void TileProcessor::free_tile() {
 	tcd_precinct_t *l_precinct = nullptr;
 	size_t l_nb_resolutions;
 
+	delete m_t1_decoder;
+	m_t1_decoder = nullptr;
+
 	if (!tile) {
 		return;
 	}
@@ -1500,17 +1554,101 @@ bool TileProcessor::t1_decode() {
 	tccp_t *l_tccp = tcp->tccps;
 	std::vector<decodeBlockInfo*> blocks;
 	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
+	auto refinement = tcp->m_refinement;
+	if (refinement)
+		refinement->comps.resize(l_tile->numcomps);
 	for (compno = 0; compno < l_tile->numcomps; ++compno) {
-		if (!t1_wrap->prepareDecodeCodeblocks(l_tile_comp, l_tccp, &blocks)) {
+		if (!l_tile_comp->skip_decode
+				&& !t1_wrap->prepareDecodeCodeblocks(l_tile_comp, l_tccp,
+						refinement ? &refinement->comps[compno] : nullptr,
+						l_tile_comp->minimum_num_resolutions, &blocks)) {
 			return false;
 		}
 		++l_tile_comp;
 		++l_tccp;
 	}
+	return t1_decode_blocks(&blocks);
+}
+
+bool TileProcessor::t1_decode_blocks(std::vector<decodeBlockInfo*> *blocks) {
 	// !!! assume that code block dimensions do not change over components
-	return t1_wrap->decodeCodeblocks(tcp,
-			(uint16_t) tcp->tccps->cblkw,
-			(uint16_t) tcp->tccps->cblkh, &blocks);
+	auto l_cblkw = (uint16_t) tcp->tccps->cblkw;
+	auto l_cblkh = (uint16_t) tcp->tccps->cblkh;
+	if (!m_t1_decoder || !m_t1_decoder->isCompatible(l_cblkw, l_cblkh)) {
+		delete m_t1_decoder;
+		m_t1_decoder = new T1Decoder(tcp, l_cblkw, l_cblkh);
+	}
+	return m_t1_decoder->decode(blocks);
+}
+
+bool TileProcessor::use_narrow_buffers() {
+	if (current_plugin_tile || tcp->m_refinement || tcp->mct == 2)
+		return false;
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		tcd_tilecomp_t *l_tile_comp = tile->comps + compno;
+		tccp_t *l_tccp = tcp->tccps + compno;
+		if (l_tile_comp->skip_decode)
+			continue;
+		if (l_tccp->qmfbid != 1 || l_tccp->roishift
+				|| tile_buf_is_decode_region(l_tile_comp->buf))
+			return false;
+		/* T1 then produces coefficients in [-8191, 8191], and DC level shifted
+		 * samples are clamped to at most 14 bits of precision */
+		for (uint32_t resno = 0; resno < l_tile_comp->numresolutions; ++resno) {
+			auto l_res = l_tile_comp->resolutions + resno;
+			for (uint32_t bandno = 0; bandno < l_res->numbands; ++bandno) {
+				if (l_res->bands[bandno].numbps > 13)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+void TileProcessor::set_narrow_buffers(bool narrow) {
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		auto l_buf = tile->comps[compno].buf;
+		l_buf->narrow = narrow && !tile->comps[compno].skip_decode;
+		l_buf->narrow_overflow_resno = 0;
+	}
+}
+
+bool TileProcessor::narrow_buffers_overflowed() {
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		if (tile->comps[compno].buf->narrow_overflow_resno)
+			return true;
+	}
+	return false;
+}
+
+bool TileProcessor::widen_narrow_buffers() {
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		tcd_tilecomp_t *l_tile_comp = tile->comps + compno;
+		auto l_buf = l_tile_comp->buf;
+		if (!l_buf->narrow)
+			continue;
+		uint32_t l_resno = l_buf->narrow_overflow_resno;
+		if (!tile_buf_widen(l_buf)) {
+			GROK_ERROR("Not enough memory for tile data");
+			return false;
+		}
+		if (!l_resno)
+			continue;
+		/* the inverse DWT stopped after resolution l_resno: code-blocks of higher
+		 * resolutions are untouched, and only the ones it consumed are decoded again */
+		std::vector<decodeBlockInfo*> blocks;
+		Tier1 t1_wrap;
+		if (!t1_wrap.prepareDecodeCodeblocks(l_tile_comp, tcp->tccps + compno,
+				nullptr, l_resno + 1, &blocks) || !t1_decode_blocks(&blocks)) {
+			return false;
+		}
+		dwt53 dwt;
+		if (!dwt.decode(l_tile_comp, image->comps[compno].resno_decoded + 1,
+				Scheduler::g_TS.GetNumTaskThreads())) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool TileProcessor::dwt_decode() {
@@ -1521,6 +1659,8 @@ bool TileProcessor::dwt_decode() {
 		tcd_tilecomp_t *l_tile_comp = l_tile->comps + compno;
 		tccp_t *l_tccp = tcp->tccps + compno;
 		grk_image_comp_t *l_img_comp = image->comps + compno;
+		if (l_tile_comp->skip_decode)
+			continue;
 		if (l_tccp->qmfbid == 1) {
 			dwt53 dwt;
 			if (!dwt.decode(l_tile_comp, l_img_comp->resno_decoded + 1,
@@ -1540,13 +1680,35 @@ bool TileProcessor::dwt_decode() {
 
 	return rc;
 }
+/**
+ * Get the region of the tile component buffer holding decoded samples,
+ * relative to the tile origin, at the decoded resolution
+ */
+static void get_decoded_region(tcd_tilecomp_t *tilec, grk_image_comp_t *img_comp,
+		uint32_t *x0, uint32_t *y0, uint32_t *x1, uint32_t *y1) {
+	uint32_t scaledTileX0 = uint_ceildivpow2(
+			(uint32_t) tilec->buf->tile_dim.x0, img_comp->decodeScaleFactor);
+	uint32_t scaledTileY0 = uint_ceildivpow2(
+			(uint32_t) tilec->buf->tile_dim.y0, img_comp->decodeScaleFactor);
+
+	*x0 = uint_ceildivpow2((uint32_t) tilec->buf->dim.x0,
+			img_comp->decodeScaleFactor) - scaledTileX0;
+	*y0 = uint_ceildivpow2((uint32_t) tilec->buf->dim.y0,
+			img_comp->decodeScaleFactor) - scaledTileY0;
+	*x1 = uint_ceildivpow2((uint32_t) tilec->buf->dim.x1,
+			img_comp->decodeScaleFactor) - scaledTileX0;
+	*y1 = uint_ceildivpow2((uint32_t) tilec->buf->dim.y1,
+			img_comp->decodeScaleFactor) - scaledTileY0;
+}
+
 bool TileProcessor::mct_decode() {
 	tcd_tile_t *l_tile = tile;
 	tcp_t *l_tcp = tcp;
 	tcd_tilecomp_t *l_tile_comp = l_tile->comps;
 	uint64_t l_samples, i;
 
-	if (!l_tcp->mct) {
+	/* all MCT inputs are skipped together, and always include component 0 */
+	if (!l_tcp->mct || l_tile_comp->skip_decode) {
 		return true;
 	}
 
@@ -1566,7 +1728,21 @@ bool TileProcessor::mct_decode() {
 			GROK_ERROR(
 					"Tiles don't all have the same dimension. Skip the MCT step.");
 			return false;
-		} else if (l_tcp->mct == 2) {
+		}
+
+		/* only the decoded region is transformed: at reduced resolution,
+		 * or for a decode window, it is much smaller than the tile */
+		uint32_t x0, y0, x1, y1;
+		get_decoded_region(l_tile_comp, image->comps, &x0, &y0, &x1, &y1);
+		uint64_t l_stride = l_tile_comp->x1 - l_tile_comp->x0;
+		uint64_t l_width = x1 - x0;
+		uint32_t l_rows = y1 - y0;
+		if (l_width == l_stride) {
+			l_width *= l_rows;
+			l_rows = l_rows ? 1 : 0;
+		}
+
+		if (l_tcp->mct == 2) {
 			uint8_t **l_data;
 
 			if (!l_tcp->m_mct_decoding_matrix) {
@@ -1579,41 +1755,52 @@ bool TileProcessor::mct_decode() {
 				return false;
 			}
 
-			for (i = 0; i < l_tile->numcomps; ++i) {
-				l_data[i] = (uint8_t*) tile_buf_get_ptr(l_tile_comp->buf, 0, 0,
-						0, 0);
-				++l_tile_comp;
-			}
-
-			if (!mct_decode_custom(/* MCT data */
-			(uint8_t*) l_tcp->m_mct_decoding_matrix,
-			/* size of components */
-			l_samples,
-			/* components */
-			l_data,
-			/* nb of components (i.e. size of pData) */
-			l_tile->numcomps,
-			/* tells if the data is signed */
-			image->comps->sgnd)) {
-				grok_free(l_data);
-				return false;
+			for (uint32_t j = 0; j < l_rows; ++j) {
+				uint64_t l_offset = x0 + (y0 + j) * l_stride;
+				for (i = 0; i < l_tile->numcomps; ++i)
+					l_data[i] = (uint8_t*) (tile_buf_get_ptr(
+							l_tile->comps[i].buf, 0, 0, 0, 0) + l_offset);
+
+				if (!mct_decode_custom(/* MCT data */
+				(uint8_t*) l_tcp->m_mct_decoding_matrix,
+				/* size of components */
+				l_width,
+				/* components */
+				l_data,
+				/* nb of components (i.e. size of pData) */
+				l_tile->numcomps,
+				/* tells if the data is signed */
+				image->comps->sgnd)) {
+					grok_free(l_data);
+					return false;
+				}
 			}
 
 			grok_free(l_data);
 		} else {
-			if (l_tcp->tccps->qmfbid == 1) {
-				grk::mct_decode(tile_buf_get_ptr(l_tile->comps[0].buf, 0, 0, 0, 0),
-						tile_buf_get_ptr(l_tile->comps[1].buf, 0, 0, 0, 0),
-						tile_buf_get_ptr(l_tile->comps[2].buf, 0, 0, 0, 0),
-						l_samples);
-			} else {
-				grk::mct_decode_real(
-						(float*) tile_buf_get_ptr(l_tile->comps[0].buf, 0, 0, 0,
-								0),
-						(float*) tile_buf_get_ptr(l_tile->comps[1].buf, 0, 0, 0,
-								0),
-						(float*) tile_buf_get_ptr(l_tile->comps[2].buf, 0, 0, 0,
-								0), l_samples);
+			for (uint32_t j = 0; j < l_rows; ++j) {
+				uint64_t l_offset = x0 + (y0 + j) * l_stride;
+				if (l_tile_comp->buf->narrow) {
+					grk::mct_decode_narrow(
+							tile_buf_get_narrow_ptr(l_tile->comps[0].buf, 0, 0, 0,
+									0) + l_offset,
+							tile_buf_get_narrow_ptr(l_tile->comps[1].buf, 0, 0, 0,
+									0) + l_offset,
+							tile_buf_get_narrow_ptr(l_tile->comps[2].buf, 0, 0, 0,
+									0) + l_offset, l_width);
+					continue;
+				}
+				int32_t *c0 = tile_buf_get_ptr(l_tile->comps[0].buf, 0, 0, 0, 0)
+						+ l_offset;
+				int32_t *c1 = tile_buf_get_ptr(l_tile->comps[1].buf, 0, 0, 0, 0)
+						+ l_offset;
+				int32_t *c2 = tile_buf_get_ptr(l_tile->comps[2].buf, 0, 0, 0, 0)
+						+ l_offset;
+				if (l_tcp->tccps->qmfbid == 1)
+					grk::mct_decode(c0, c1, c2, l_width);
+				else
+					grk::mct_decode_real((float*) c0, (float*) c1, (float*) c2,
+							l_width);
 			}
 		}
 	} else {
@@ -1625,6 +1812,57 @@ bool TileProcessor::mct_decode() {
 	return true;
 }
 
+/**
+ DC level shift and clamp the 16 bit samples of a narrow tile buffer,
+ widening them in place to 32 bits. Each 32 bit sample occupies the bytes of
+ the 16 bit sample with twice its index, so that samples are widened
+ from last to first, and a block of samples is loaded before it is stored.
+ The buffer is first grown to hold 32 bit samples, and then holds
+ regular 32 bit samples.
+ */
+static bool dc_level_shift_decode_narrow(tile_buf_component_t *buf,
+		uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, int32_t shift,
+		int32_t min, int32_t max) {
+	int64_t width = buf->tile_dim.x1 - buf->tile_dim.x0;
+	if (width < 0 || width > UINT32_MAX) {
+		GROK_ERROR("Invalid tile width %lld", (long long) width);
+		return false;
+	}
+	if (!tile_buf_alloc_component_data_wide(buf)) {
+		GROK_ERROR("Not enough memory for tile data");
+		return false;
+	}
+	uint32_t stride = (uint32_t) width;
+	int16_t *src = tile_buf_get_narrow_ptr(buf, 0, 0, 0, 0);
+	int32_t *dest = tile_buf_get_ptr(buf, 0, 0, 0, 0);
+	for (uint32_t j = y1; j-- > y0;) {
+		uint64_t row = (uint64_t) j * stride;
+		uint32_t i = x1;
+#ifdef __SSE2__
+		const __m128i vshift = _mm_set1_epi16((int16_t) shift);
+		const __m128i vmin = _mm_set1_epi16((int16_t) min);
+		const __m128i vmax = _mm_set1_epi16((int16_t) max);
+		while (i >= x0 + 8) {
+			i -= 8;
+			__m128i v = _mm_loadu_si128((const __m128i*) (src + row + i));
+			// saturated sums lie outside [min, max], and clamp as the exact sums do
+			v = _mm_min_epi16(_mm_max_epi16(_mm_adds_epi16(v, vshift), vmin),
+					vmax);
+			_mm_storeu_si128((__m128i*) (dest + row + i + 4),
+					_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+			_mm_storeu_si128((__m128i*) (dest + row + i),
+					_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+		}
+#endif
+		while (i > x0) {
+			--i;
+			dest[row + i] = int_clamp(src[row + i] + shift, min, max);
+		}
+	}
+	buf->narrow = false;
+	return true;
+}
+
 bool TileProcessor::dc_level_shift_decode() {
 	uint32_t compno = 0;
 	for (compno = 0; compno < tile->numcomps; compno++) {
@@ -1633,22 +1871,11 @@ bool TileProcessor::dc_level_shift_decode() {
 		tcd_tilecomp_t *l_tile_comp = tile->comps + compno;
 		tccp_t *l_tccp = tcp->tccps + compno;
 		grk_image_comp_t *l_img_comp = image->comps + compno;
+		if (l_tile_comp->skip_decode)
+			continue;
 
-		uint32_t scaledTileX0 = uint_ceildivpow2(
-				(uint32_t) l_tile_comp->buf->tile_dim.x0,
-				l_img_comp->decodeScaleFactor);
-		uint32_t scaledTileY0 = uint_ceildivpow2(
-				(uint32_t) l_tile_comp->buf->tile_dim.y0,
-				l_img_comp->decodeScaleFactor);
-
-		uint32_t x0 = (uint_ceildivpow2((uint32_t) l_tile_comp->buf->dim.x0,
-				l_img_comp->decodeScaleFactor) - scaledTileX0);
-		uint32_t y0 = (uint_ceildivpow2((uint32_t) l_tile_comp->buf->dim.y0,
-				l_img_comp->decodeScaleFactor) - scaledTileY0);
-		uint32_t x1 = (uint_ceildivpow2((uint32_t) l_tile_comp->buf->dim.x1,
-				l_img_comp->decodeScaleFactor) - scaledTileX0);
-		uint32_t y1 = (uint_ceildivpow2((uint32_t) l_tile_comp->buf->dim.y1,
-				l_img_comp->decodeScaleFactor) - scaledTileY0);
+		uint32_t x0, y0, x1, y1;
+		get_decoded_region(l_tile_comp, l_img_comp, &x0, &y0, &x1, &y1);
 
 		uint32_t l_stride = (l_tile_comp->x1 - l_tile_comp->x0) - (x1 - x0);
 
@@ -1660,6 +1887,13 @@ bool TileProcessor::dc_level_shift_decode() {
 			l_max = (1 << l_img_comp->prec) - 1;
 		}
 
+		if (l_tile_comp->buf->narrow) {
+			if (!dc_level_shift_decode_narrow(l_tile_comp->buf, x0, y0, x1, y1,
+					l_tccp->m_dc_level_shift, l_min, l_max))
+				return false;
+			continue;
+		}
+
 		int32_t *l_current_ptr = tile_buf_get_ptr(l_tile_comp->buf, 0, 0, 0, 0);
 		l_current_ptr += x0 + y0 * (l_tile_comp->x1 - l_tile_comp->x0);
 
@@ -1901,8 +2135,52 @@ bool TileProcessor::t1_encode() {
 
 	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
 
-	return t1_wrap->encodeCodeblocks(l_tcp, tile, l_mct_norms,
-			l_mct_numcomps, needs_rate_control());
+	// neighbouring tiles have similar statistics, so bit planes far below
+	// the previous tile's final threshold will almost certainly be discarded.
+	// The first tile estimates its threshold from a sample of its code-blocks.
+	double l_slope_thresh = 0;
+	uint64_t l_max_len = 0;
+	if (skips_discarded_passes()) {
+		l_slope_thresh = m_prev_min_slope;
+		l_max_len = (uint64_t) ceil(l_tcp->rates[l_tcp->numlayers - 1]);
+	}
+	if (!t1_wrap->encodeCodeblocks(l_tcp, tile, l_mct_norms, l_mct_numcomps,
+			needs_rate_control(), l_slope_thresh, l_max_len))
+		return false;
+
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		tcd_tilecomp_t *tilec = tile->comps + compno;
+		for (uint32_t resno = 0; resno < tilec->numresolutions; ++resno) {
+			tcd_resolution_t *res = tilec->resolutions + resno;
+			for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
+				tcd_band_t *band = res->bands + bandno;
+				for (uint32_t precno = 0; precno < res->pw * res->ph;
+						++precno) {
+					tcd_precinct_t *prc = band->precincts + precno;
+					for (uint32_t cblkno = 0; cblkno < prc->cw * prc->ch;
+							++cblkno) {
+						tcd_cblk_enc_t *cblk = prc->cblks.enc + cblkno;
+						// a cleanup pass for the first bit plane, and three
+						// passes for each of the others
+						uint32_t l_num_passes =
+								cblk->numbps ? 3 * cblk->numbps - 2 : 0;
+						m_num_passes_coded += cblk->num_passes_encoded;
+						m_num_passes_skipped += l_num_passes
+								- cblk->num_passes_encoded;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool TileProcessor::skips_discarded_passes() {
+	auto enc_params = &cp->m_specific_param.m_enc;
+	return enc_params->m_disto_alloc && !enc_params->m_fixed_quality
+			&& enc_params->rateControlAlgorithm == 0
+			&& !enc_params->m_code_all_passes
+			&& layer_needs_rate_control(tcp->numlayers - 1);
 }
 
 bool TileProcessor::t2_encode(GrokStream *p_stream,
@@ -60,6 +60,9 @@
 
 namespace grk {
 
+class T1Decoder;
+struct decodeBlockInfo;
+
 // code segment (code block can be encoded into multiple segments)
 struct tcd_seg_t {
 	tcd_seg_t() {
@@ -68,6 +71,7 @@ struct tcd_seg_t {
 	void clear() {
 		dataindex = 0;
 		numpasses = 0;
+		numPassesRead = 0;
 		len = 0;
 		maxpasses = 0;
 		numPassesInPacket = 0;
@@ -75,6 +79,7 @@ struct tcd_seg_t {
 	}
 	uint32_t dataindex;		// segment data offset in contiguous memory block
 	uint32_t numpasses;				// number of passes in segment
+	uint32_t numPassesRead;		// number of passes in segment whose data has been read
 	uint32_t len;
 	uint32_t maxpasses;				// maximum number of passes in segment
 	uint32_t numPassesInPacket;	// number of passes in segment from current packet
@@ -298,6 +303,7 @@ struct tcd_tilecomp_t {
 #endif
 	uint64_t numpix;
 	tile_buf_component_t *buf;
+	bool skip_decode; /* component is not needed for the decoded output */
 };
 
 // tile
@@ -311,10 +317,68 @@ struct tcd_tile_t {
 	uint32_t packno; /* packet number */
 };
 
+/**
+ * Decoded state of a code-block: compressed bytes and coding passes read.
+ * Cached coefficients are only valid for a block whose state is unchanged.
+ */
+struct layer_refinement_cblk_t {
+	layer_refinement_cblk_t() :
+			len(UINT32_MAX), passes(UINT32_MAX) {
+	}
+	layer_refinement_cblk_t(uint32_t l, uint32_t p) :
+			len(l), passes(p) {
+	}
+	bool operator==(const layer_refinement_cblk_t &rhs) const {
+		return len == rhs.len && passes == rhs.passes;
+	}
+	uint32_t len;
+	uint32_t passes;
+};
+
+/**
+ * Decoded code-block coefficients of a tile component, retained for layer refinement
+ */
+struct layer_refinement_comp_t {
+	/* decoded (pre-DWT) coefficients, laid out like the tile component buffer */
+	std::vector<int32_t> coeffs;
+	/* decoded state of each code-block, in T1 scan order */
+	std::vector<layer_refinement_cblk_t> cblk_state;
+};
+
+/**
+ * Tile state retained between decodes when refining quality layers,
+ * so that more layers can be decoded without re-reading the stream,
+ * and code-blocks that receive no new compressed data are not decoded again
+ */
+struct layer_refinement_t {
+	layer_refinement_t() :
+			tile_data(nullptr), num_layers_decoded(0), truncated(false), end_of_data(
+					false), ppm_data(nullptr), ppm_len(0), ppt_data(nullptr), ppt_len(
+					0) {
+	}
+	~layer_refinement_t() {
+		delete tile_data;
+	}
+	/* compressed tile data */
+	seg_buf_t *tile_data;
+	uint32_t num_layers_decoded;
+	/* growing stream: the last tile-part has not fully arrived yet */
+	bool truncated;
+	/* growing stream: T2 stopped at the end of the data that has arrived */
+	bool end_of_data;
+	/* packed packet headers for this tile, as they were before T2 consumed them */
+	uint8_t *ppm_data;
+	size_t ppm_len;
+	uint8_t *ppt_data;
+	size_t ppt_len;
+	std::vector<layer_refinement_comp_t> comps;
+};
+
 
 bool tile_buf_create_component(tcd_tilecomp_t *tilec, bool isEncoder,
 		bool irreversible, uint32_t cblkw, uint32_t cblkh,
-		grk_image_t *output_image, uint32_t dx, uint32_t dy);
+		grk_image_t *output_image, uint32_t dx, uint32_t dy,
+		const grk_decode_area_t *areas, uint32_t num_areas);
 
 /**
  Tile coder/decoder
@@ -329,10 +393,14 @@ struct TileProcessor {
 			  tile(nullptr),
 			  image(nullptr),
 			  current_plugin_tile(nullptr),
+			  m_num_passes_coded(0),
+			  m_num_passes_skipped(0),
 			  cp(nullptr),
 			  tcp(nullptr),
 			  tcd_tileno(0),
-			  m_is_decoder(isDecoder)
+			  m_is_decoder(isDecoder),
+			  m_prev_min_slope(0),
+			  m_t1_decoder(nullptr)
 	{}
 
 	~TileProcessor(){
@@ -353,11 +421,15 @@ struct TileProcessor {
 	 * @param	output_image output image - stores the decode region of interest
 	 * @param	tile_no	the index of the tile received in sequence. This not necessarily lead to the
 	 * tile at index tile_no.
+	 * @param	areas		areas within the decode region that are needed, or nullptr
+	 * if the whole region is needed
+	 * @param	num_areas	number of areas
 	 *
 	 * @return	true if the remaining data is sufficient.
 	 */
 	bool init_decode_tile(grk_image_t *output_image,
-			uint32_t tile_no);
+			uint32_t tile_no, const grk_decode_area_t *areas,
+			uint32_t num_areas);
 
 	/**
 	 * Gets the maximum tile size that will be taken by the tile once decoded.
@@ -428,6 +500,10 @@ struct TileProcessor {
 	/** image header */
 	grk_image_t *image;
 	grok_plugin_tile_t *current_plugin_tile;
+	/** code-block passes coded by T1, and passes that were not coded
+	 * because rate control was expected to discard them */
+	uint64_t m_num_passes_coded;
+	uint64_t m_num_passes_skipped;
 
 private:
 	/** coding parameters */
@@ -438,13 +514,20 @@ private:
 	uint32_t tcd_tileno;
 	/** indicate if the tcd is a decoder. */
 	bool m_is_decoder;
+	/** smallest rate-distortion slope kept by rate control
+	 * for the previously encoded tile (0 if unknown) */
+	double m_prev_min_slope;
+	/** code-block decoder, with its per-thread scratch buffers,
+	 * kept across tiles (and streams) with the same nominal code-block size */
+	T1Decoder *m_t1_decoder;
 
 	/**
 	 * Initializes tile coding/decoding
 	 */
 	 inline bool init_tile(uint32_t tile_no,
 			grk_image_t *output_image, bool isEncoder, float fraction,
-			size_t sizeof_block);
+			size_t sizeof_block, const grk_decode_area_t *areas,
+			uint32_t num_areas);
 
 	/**
 	 * Deallocates the decoding data of the given precinct.
@@ -466,6 +549,25 @@ private:
 
 	 bool t1_decode();
 
+	 bool t1_decode_blocks(std::vector<decodeBlockInfo*> *blocks);
+
+	/**
+	 Check whether the current tile can be decoded with 16 bit samples:
+	 reversible, no ROI, whole tile, and sub-band magnitudes of at most 13 bits.
+	 */
+	 bool use_narrow_buffers();
+
+	 void set_narrow_buffers(bool narrow);
+
+	 bool narrow_buffers_overflowed();
+
+	/**
+	 Widen all narrow tile buffers to 32 bit samples. A tile component whose
+	 inverse DWT overflowed is decoded again, from the code-blocks of the
+	 resolutions that the transform had already consumed.
+	 */
+	 bool widen_narrow_buffers();
+
 	 bool dwt_decode();
 
 	 bool mct_decode();
@@ -480,6 +582,13 @@ private:
 
 	 bool t1_encode();
 
+	/**
+	 Check whether T1 may skip passes that rate control is expected to
+	 discard: bisection rate control, with a rate for the last layer.
+	 Fixed quality needs the full tile distortion, so it codes every pass.
+	 */
+	 bool skips_discarded_passes();
+
 	 bool t2_encode(GrokStream *p_stream,
 			uint64_t *p_data_written, uint64_t max_dest_size,
 			grk_codestream_info_t *p_cstr_info);
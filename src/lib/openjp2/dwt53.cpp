@@ -113,6 +113,474 @@ namespace grk {
 #define GROK_SS_(i) ((i)<0?GROK_S(0):((i)>=d_n?GROK_S(d_n-1):GROK_S(i)))
 #define GROK_DD_(i) ((i)<0?GROK_D(0):((i)>=s_n?GROK_D(s_n-1):GROK_D(i)))
 
+/*
+ Strip based vertical transform.
+
+ Rather than gathering one column at a time with a stride of one row,
+ the vertical passes process strips of adjacent columns: each row segment of
+ a strip is read and written as a single contiguous vector, and lifting
+ is carried out on whole row segments. Only rh row segments of the strip are
+ buffered, and each tile row is touched once per strip rather than once per column.
+
+ This is cache blocking only, not a line-based transform: the whole tile
+ component is still held in the tile buffer while it is transformed, so
+ peak memory is unchanged.
+
+ Two lane widths are supported:
+
+ 1. wide: 32 bit lanes, valid for all reversible data
+
+ 2. narrow: 16 bit lanes, for the inverse transform only. If every value loaded
+ into a strip lies in [-8192, 8191], then all lifting intermediates fit in 16 bits:
+ neighbour sums plus rounding stay within +-16384, updated even samples within +-12288,
+ their sums within +-24576 and updated odd samples within +-20480. Inverse lifting
+ in 16 bit lanes is then identical to the 32 bit path, and strips are twice as wide.
+ The range is checked on every load, and a strip that does not fit
+ is transformed with wide lanes instead. Sub-band magnitude bits (numbps) are only used
+ to decide whether the narrow path is worth trying: with at most 13 bits,
+ coefficients are within range (10 bit reversible data with two guard bits).
+
+ The tile buffer itself holds either 32 bit samples, or 16 bit samples for
+ narrow tiles (see TileProcessor::use_narrow_buffers). Narrow storage is
+ loaded directly into 16 bit lanes; a strip that fails the range check is
+ widened to 32 bit lanes, and its results are checked on the way back
+ into 16 bit storage. If any of them does not fit, the transform stops after
+ that resolution, and TileProcessor widens the tile component and decodes
+ again only the code-blocks of that resolution and the ones below it.
+
+ All lane types occupy one SIMD register per row segment, so a strip buffer
+ of rh vectors serves any of them.
+ */
+#if defined(__AVX2__)
+#define GROK_DWT53_STRIP
+typedef __m256i dwt53_vec_t;
+
+struct dwt53_ops32 {
+	static inline dwt53_vec_t add(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm256_add_epi32(a, b);
+	}
+	static inline dwt53_vec_t sub(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm256_sub_epi32(a, b);
+	}
+	static inline dwt53_vec_t sra1(dwt53_vec_t a) {
+		return _mm256_srai_epi32(a, 1);
+	}
+	static inline dwt53_vec_t sra2(dwt53_vec_t a) {
+		return _mm256_srai_epi32(a, 2);
+	}
+	static inline dwt53_vec_t two(void) {
+		return _mm256_set1_epi32(2);
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		ARG_NOT_USED(overflow);
+		return true;
+	}
+};
+
+struct dwt53_ops16 {
+	static inline dwt53_vec_t add(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm256_add_epi16(a, b);
+	}
+	static inline dwt53_vec_t sub(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm256_sub_epi16(a, b);
+	}
+	static inline dwt53_vec_t sra1(dwt53_vec_t a) {
+		return _mm256_srai_epi16(a, 1);
+	}
+	static inline dwt53_vec_t sra2(dwt53_vec_t a) {
+		return _mm256_srai_epi16(a, 2);
+	}
+	static inline dwt53_vec_t two(void) {
+		return _mm256_set1_epi16(2);
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		ARG_NOT_USED(overflow);
+		return true;
+	}
+};
+
+/* 32 bit lanes, 32 bit storage */
+struct dwt53_wide: dwt53_ops32 {
+	typedef int32_t sample_t;
+	static const uint32_t cols = 8;
+	static inline dwt53_vec_t load(const int32_t *p) {
+		return _mm256_loadu_si256((const __m256i*) p);
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p) {
+		_mm256_storeu_si256((__m256i*) p, v);
+	}
+	static inline dwt53_vec_t load(const int32_t *p, dwt53_vec_t *range) {
+		ARG_NOT_USED(range);
+		return load(p);
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		ARG_NOT_USED(range);
+		return true;
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		store(v, p);
+	}
+};
+
+/* 16 bit lanes, 32 bit storage */
+struct dwt53_narrow: dwt53_ops16 {
+	typedef int32_t sample_t;
+	static const uint32_t cols = 16;
+	// range is the OR of all loaded values biased by 8192: they lie
+	// in [-8192, 8191] if and only if no bit above bit 13 is set
+	static inline dwt53_vec_t load(const int32_t *p, dwt53_vec_t *range) {
+		__m256i lo = _mm256_loadu_si256((const __m256i*) p);
+		__m256i hi = _mm256_loadu_si256((const __m256i*) (p + 8));
+		const __m256i bias = _mm256_set1_epi32(8192);
+		*range = _mm256_or_si256(*range,
+				_mm256_or_si256(_mm256_add_epi32(lo, bias),
+						_mm256_add_epi32(hi, bias)));
+		// packs operates on 128 bit lanes, so restore sample order
+		return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+				_MM_SHUFFLE(3, 1, 2, 0));
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		return _mm256_testz_si256(range, _mm256_set1_epi32(~0x3FFF)) != 0;
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		_mm256_storeu_si256((__m256i*) p,
+				_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)));
+		_mm256_storeu_si256((__m256i*) (p + 8),
+				_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)));
+	}
+};
+
+/* 16 bit lanes, 16 bit storage */
+struct dwt53_narrow16: dwt53_ops16 {
+	typedef int16_t sample_t;
+	static const uint32_t cols = 16;
+	// range is the OR of all loaded values biased by 8192: they lie
+	// in [-8192, 8191] if and only if neither of the top two bits is set
+	static inline dwt53_vec_t load(const int16_t *p, dwt53_vec_t *range) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) p);
+		*range = _mm256_or_si256(*range,
+				_mm256_add_epi16(v, _mm256_set1_epi16(8192)));
+		return v;
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		return _mm256_testz_si256(range, _mm256_set1_epi16((int16_t) 0xC000))
+				!= 0;
+	}
+	static inline void store(dwt53_vec_t v, int16_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		_mm256_storeu_si256((__m256i*) p, v);
+	}
+};
+
+/* 32 bit lanes, 16 bit storage */
+struct dwt53_wide16: dwt53_ops32 {
+	typedef int16_t sample_t;
+	static const uint32_t cols = 8;
+	static inline dwt53_vec_t load(const int16_t *p, dwt53_vec_t *range) {
+		ARG_NOT_USED(range);
+		return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) p));
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		ARG_NOT_USED(range);
+		return true;
+	}
+	// overflow is the OR of all stored values biased by 32768: they fit
+	// in 16 bits if and only if no bit above bit 15 is set
+	static inline void store(dwt53_vec_t v, int16_t *p, dwt53_vec_t *overflow) {
+		*overflow = _mm256_or_si256(*overflow,
+				_mm256_add_epi32(v, _mm256_set1_epi32(32768)));
+		_mm_storeu_si128((__m128i*) p,
+				_mm_packs_epi32(_mm256_castsi256_si128(v),
+						_mm256_extracti128_si256(v, 1)));
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		return _mm256_testz_si256(overflow, _mm256_set1_epi32(~0xFFFF)) != 0;
+	}
+};
+#elif defined(__SSE2__)
+#define GROK_DWT53_STRIP
+typedef __m128i dwt53_vec_t;
+
+struct dwt53_ops32 {
+	static inline dwt53_vec_t add(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm_add_epi32(a, b);
+	}
+	static inline dwt53_vec_t sub(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm_sub_epi32(a, b);
+	}
+	static inline dwt53_vec_t sra1(dwt53_vec_t a) {
+		return _mm_srai_epi32(a, 1);
+	}
+	static inline dwt53_vec_t sra2(dwt53_vec_t a) {
+		return _mm_srai_epi32(a, 2);
+	}
+	static inline dwt53_vec_t two(void) {
+		return _mm_set1_epi32(2);
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		ARG_NOT_USED(overflow);
+		return true;
+	}
+};
+
+struct dwt53_ops16 {
+	static inline dwt53_vec_t add(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm_add_epi16(a, b);
+	}
+	static inline dwt53_vec_t sub(dwt53_vec_t a, dwt53_vec_t b) {
+		return _mm_sub_epi16(a, b);
+	}
+	static inline dwt53_vec_t sra1(dwt53_vec_t a) {
+		return _mm_srai_epi16(a, 1);
+	}
+	static inline dwt53_vec_t sra2(dwt53_vec_t a) {
+		return _mm_srai_epi16(a, 2);
+	}
+	static inline dwt53_vec_t two(void) {
+		return _mm_set1_epi16(2);
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		ARG_NOT_USED(overflow);
+		return true;
+	}
+};
+
+/* true if no bit of mask is set in v */
+static inline bool dwt53_testz(dwt53_vec_t v, dwt53_vec_t mask) {
+	return _mm_movemask_epi8(
+			_mm_cmpeq_epi32(_mm_and_si128(v, mask), _mm_setzero_si128()))
+			== 0xFFFF;
+}
+
+/* 32 bit lanes, 32 bit storage */
+struct dwt53_wide: dwt53_ops32 {
+	typedef int32_t sample_t;
+	static const uint32_t cols = 4;
+	static inline dwt53_vec_t load(const int32_t *p) {
+		return _mm_loadu_si128((const __m128i*) p);
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p) {
+		_mm_storeu_si128((__m128i*) p, v);
+	}
+	static inline dwt53_vec_t load(const int32_t *p, dwt53_vec_t *range) {
+		ARG_NOT_USED(range);
+		return load(p);
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		ARG_NOT_USED(range);
+		return true;
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		store(v, p);
+	}
+};
+
+/* 16 bit lanes, 32 bit storage */
+struct dwt53_narrow: dwt53_ops16 {
+	typedef int32_t sample_t;
+	static const uint32_t cols = 8;
+	// range is the OR of all loaded values biased by 8192: they lie
+	// in [-8192, 8191] if and only if no bit above bit 13 is set
+	static inline dwt53_vec_t load(const int32_t *p, dwt53_vec_t *range) {
+		__m128i lo = _mm_loadu_si128((const __m128i*) p);
+		__m128i hi = _mm_loadu_si128((const __m128i*) (p + 4));
+		const __m128i bias = _mm_set1_epi32(8192);
+		*range = _mm_or_si128(*range,
+				_mm_or_si128(_mm_add_epi32(lo, bias), _mm_add_epi32(hi, bias)));
+		return _mm_packs_epi32(lo, hi);
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		return dwt53_testz(range, _mm_set1_epi32(~0x3FFF));
+	}
+	static inline void store(dwt53_vec_t v, int32_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		_mm_storeu_si128((__m128i*) p,
+				_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+		_mm_storeu_si128((__m128i*) (p + 4),
+				_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+	}
+};
+
+/* 16 bit lanes, 16 bit storage */
+struct dwt53_narrow16: dwt53_ops16 {
+	typedef int16_t sample_t;
+	static const uint32_t cols = 8;
+	// range is the OR of all loaded values biased by 8192: they lie
+	// in [-8192, 8191] if and only if neither of the top two bits is set
+	static inline dwt53_vec_t load(const int16_t *p, dwt53_vec_t *range) {
+		__m128i v = _mm_loadu_si128((const __m128i*) p);
+		*range = _mm_or_si128(*range, _mm_add_epi16(v, _mm_set1_epi16(8192)));
+		return v;
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		return dwt53_testz(range, _mm_set1_epi16((int16_t) 0xC000));
+	}
+	static inline void store(dwt53_vec_t v, int16_t *p, dwt53_vec_t *overflow) {
+		ARG_NOT_USED(overflow);
+		_mm_storeu_si128((__m128i*) p, v);
+	}
+};
+
+/* 32 bit lanes, 16 bit storage */
+struct dwt53_wide16: dwt53_ops32 {
+	typedef int16_t sample_t;
+	static const uint32_t cols = 4;
+	static inline dwt53_vec_t load(const int16_t *p, dwt53_vec_t *range) {
+		ARG_NOT_USED(range);
+		__m128i v = _mm_loadl_epi64((const __m128i*) p);
+		return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+	}
+	static inline bool in_range(dwt53_vec_t range) {
+		ARG_NOT_USED(range);
+		return true;
+	}
+	// overflow is the OR of all stored values biased by 32768: they fit
+	// in 16 bits if and only if no bit above bit 15 is set
+	static inline void store(dwt53_vec_t v, int16_t *p, dwt53_vec_t *overflow) {
+		*overflow = _mm_or_si128(*overflow,
+				_mm_add_epi32(v, _mm_set1_epi32(32768)));
+		_mm_storel_epi64((__m128i*) p, _mm_packs_epi32(v, v));
+	}
+	static inline bool no_overflow(dwt53_vec_t overflow) {
+		return dwt53_testz(overflow, _mm_set1_epi32(~0xFFFF));
+	}
+};
+#endif
+
+#ifdef GROK_DWT53_STRIP
+/* lane types to try first, and to fall back to, for each storage type */
+template<typename S> struct dwt53_lanes;
+template<> struct dwt53_lanes<int32_t> {
+	typedef dwt53_narrow narrow;
+	typedef dwt53_wide wide;
+};
+template<> struct dwt53_lanes<int16_t> {
+	typedef dwt53_narrow16 narrow;
+	typedef dwt53_wide16 wide;
+};
+
+/* <summary>                                             */
+/* Forward 5-3 wavelet transform of a vertical strip.    */
+/* </summary>                                            */
+template<typename T> static void dwt53_encode_strip(int32_t *tiledp,
+		dwt53_vec_t *a, uint32_t x, int32_t d_n, int32_t s_n, uint8_t cas) {
+	int32_t i;
+	int32_t rh = d_n + s_n;
+	for (i = 0; i < rh; ++i)
+		a[i] = T::load(tiledp + (size_t) i * x);
+
+	if (!cas) {
+		if ((d_n > 0) || (s_n > 1)) {
+			for (i = 0; i < d_n; i++)
+				GROK_D(i) = T::sub(GROK_D(i),
+						T::sra1(T::add(GROK_S_(i), GROK_S_(i + 1))));
+			for (i = 0; i < s_n; i++)
+				GROK_S(i) = T::add(GROK_S(i),
+						T::sra2(T::add(T::add(GROK_D_(i - 1), GROK_D_(i)), T::two())));
+		}
+	} else {
+		if (!s_n && d_n == 1)
+			GROK_S(0) = T::add(GROK_S(0), GROK_S(0));
+		else {
+			for (i = 0; i < d_n; i++)
+				GROK_S(i) = T::sub(GROK_S(i),
+						T::sra1(T::add(GROK_DD_(i), GROK_DD_(i - 1))));
+			for (i = 0; i < s_n; i++)
+				GROK_D(i) = T::add(GROK_D(i),
+						T::sra2(T::add(T::add(GROK_SS_(i), GROK_SS_(i + 1)), T::two())));
+		}
+	}
+	/* forward lazy transform */
+	for (i = 0; i < s_n; ++i)
+		T::store(a[(i << 1) + cas], tiledp + (size_t) i * x);
+	for (i = 0; i < d_n; ++i)
+		T::store(a[(i << 1) + 1 - cas], tiledp + (size_t) (s_n + i) * x);
+}
+
+/* <summary>                                             */
+/* Inverse 5-3 wavelet transform of a vertical strip.    */
+/* Caller guarantees that the strip has at least two rows. */
+/* Returns false, leaving the strip untouched, if the     */
+/* strip does not fit in the lane type. Sets overflow     */
+/* if a result does not fit in the storage type.          */
+/* </summary>                                            */
+template<typename T> static bool dwt53_decode_strip(
+		typename T::sample_t *tiledp, dwt53_vec_t *a, uint32_t x, int32_t d_n,
+		int32_t s_n, uint8_t cas, bool *overflow) {
+	int32_t i;
+	int32_t rh = d_n + s_n;
+	dwt53_vec_t range;
+	memset(&range, 0, sizeof(range));
+	/* inverse lazy transform */
+	for (i = 0; i < s_n; ++i)
+		a[(i << 1) + cas] = T::load(tiledp + (size_t) i * x, &range);
+	for (i = 0; i < d_n; ++i)
+		a[(i << 1) + 1 - cas] = T::load(tiledp + (size_t) (s_n + i) * x,
+				&range);
+	if (!T::in_range(range))
+		return false;
+
+	if (!cas) {
+		if ((d_n > 0) || (s_n > 1)) {
+			for (i = 0; i < s_n; i++)
+				GROK_S(i) = T::sub(GROK_S(i),
+						T::sra2(T::add(T::add(GROK_D_(i - 1), GROK_D_(i)), T::two())));
+			for (i = 0; i < d_n; i++)
+				GROK_D(i) = T::add(GROK_D(i),
+						T::sra1(T::add(GROK_S_(i), GROK_S_(i + 1))));
+		}
+	} else {
+		for (i = 0; i < s_n; i++)
+			GROK_D(i) = T::sub(GROK_D(i),
+					T::sra2(T::add(T::add(GROK_SS_(i), GROK_SS_(i + 1)), T::two())));
+		for (i = 0; i < d_n; i++)
+			GROK_S(i) = T::add(GROK_S(i),
+					T::sra1(T::add(GROK_DD_(i), GROK_DD_(i - 1))));
+	}
+	dwt53_vec_t overflow_bits;
+	memset(&overflow_bits, 0, sizeof(overflow_bits));
+	for (i = 0; i < rh; ++i)
+		T::store(a[i], tiledp + (size_t) i * x, &overflow_bits);
+	if (!T::no_overflow(overflow_bits))
+		*overflow = true;
+	return true;
+}
+#endif
+
+/*
+ Copy transformed samples back to the tile buffer. 16 bit storage
+ records whether any sample did not fit.
+ */
+static inline void dwt53_put(int32_t *p, int32_t v, bool *overflow) {
+	ARG_NOT_USED(overflow);
+	*p = v;
+}
+static inline void dwt53_put(int16_t *p, int32_t v, bool *overflow) {
+	if (v != (int16_t) v)
+		*overflow = true;
+	*p = (int16_t) v;
+}
+static inline void dwt53_put_row(int32_t *dest, const int32_t *src,
+		uint32_t n, bool *overflow) {
+	ARG_NOT_USED(overflow);
+	memcpy(dest, src, n * sizeof(int32_t));
+}
+static void dwt53_put_row(int16_t *dest, const int32_t *src, uint32_t n,
+		bool *overflow) {
+	// OR of all values biased by 32768: they fit in 16 bits
+	// if and only if no bit above bit 15 is set
+	uint32_t bits = 0;
+	for (uint32_t i = 0; i < n; ++i) {
+		bits |= (uint32_t) (src[i] + 32768);
+		dest[i] = (int16_t) src[i];
+	}
+	if (bits & ~0xFFFFU)
+		*overflow = true;
+}
+
 /**
  Forward wavelet transform in 2-D.
  Apply a reversible DWT transform to a component of an image.
@@ -163,6 +631,15 @@ bool dwt53::encode(tcd_tilecomp_t *tilec) {
 	if (!bj) {
 		return false;
 	}
+#ifdef GROK_DWT53_STRIP
+	auto stripMem = (dwt53_vec_t*) grok_aligned_malloc(
+			max_resolution(tilec->resolutions, tilec->numresolutions)
+					* sizeof(dwt53_vec_t));
+	if (!stripMem) {
+		grok_free(bj);
+		return false;
+	}
+#endif
 
 	while (num_decomps--) {
 		uint32_t rw1; /* width of the resolution level once lower than computed one                                       */
@@ -182,7 +659,13 @@ bool dwt53::encode(tcd_tilecomp_t *tilec) {
 		s_n = rh1;
 		d_n = rh - rh1;
 
-		for (uint32_t j = 0; j < rw; ++j) {
+		uint32_t j = 0;
+#ifdef GROK_DWT53_STRIP
+		for (; j + dwt53_wide::cols <= rw; j += dwt53_wide::cols)
+			dwt53_encode_strip<dwt53_wide>(a + j, stripMem, w, (int32_t) d_n,
+					(int32_t) s_n, cas_col);
+#endif
+		for (; j < rw; ++j) {
 			aj = a + j;
 			for (k = 0; k < rh; ++k) {
 				bj[k] = aj[k * w];
@@ -204,6 +687,9 @@ bool dwt53::encode(tcd_tilecomp_t *tilec) {
 		--l_last_res;
 	}
 	grok_free(bj);
+#ifdef GROK_DWT53_STRIP
+	grok_aligned_free(stripMem);
+#endif
 #ifdef DEBUG_LOSSLESS_DWT
 	memcpy(after, a, rw_full * rh_full * sizeof(int32_t));
 	dwt53 dwt;
@@ -263,22 +749,35 @@ bool dwt53::decode(tcd_tilecomp_t *tilec, uint32_t numres,
 	}
 	if (tile_buf_is_decode_region(tilec->buf))
 		return region_decode(tilec, numres, numThreads);
+	if (tilec->buf->narrow)
+		return decode_tile(tilec, numres, numThreads,
+				tile_buf_get_narrow_ptr(tilec->buf, 0, 0, 0, 0));
+
+	return decode_tile(tilec, numres, numThreads,
+			tile_buf_get_ptr(tilec->buf, 0, 0, 0, 0));
+}
 
+template<typename S> bool dwt53::decode_tile(tcd_tilecomp_t *tilec,
+		uint32_t numres, uint32_t numThreads, S *tileBuf) {
 	std::vector<std::thread> dwtWorkers;
 	int rc = 0;
-	auto tileBuf = (int32_t*) tile_buf_get_ptr(tilec->buf, 0, 0, 0, 0);
+	std::atomic<uint32_t> overflow_resno(0);
+	bool narrow = is_narrow(tilec, numres);
 	Barrier decode_dwt_barrier(numThreads);
 	Barrier decode_dwt_calling_barrier(numThreads + 1);
 
 	for (auto threadId = 0U; threadId < numThreads; threadId++) {
 		dwtWorkers.push_back(
 				std::thread(
-						[tilec, numres, &rc, tileBuf, &decode_dwt_barrier,
+						[tilec, numres, &rc, &overflow_resno, tileBuf,
+								&decode_dwt_barrier,
 								&decode_dwt_calling_barrier, threadId,
-								numThreads, this]() {
+								numThreads, narrow, this]() {
 							auto numResolutions = numres;
 							dwt_t h;
 							dwt_t v;
+							void *stripMem = nullptr;
+							bool thread_overflow = false;
 
 							tcd_resolution_t *tr = tilec->resolutions;
 
@@ -295,9 +794,18 @@ bool dwt53::decode(tcd_tilecomp_t *tilec, uint32_t numres,
 							}
 
 							v.mem = h.mem;
+#ifdef GROK_DWT53_STRIP
+							stripMem = grok_aligned_malloc(
+									max_resolution(tr, numResolutions)
+											* sizeof(dwt53_vec_t));
+							if (!stripMem) {
+								rc++;
+								goto cleanup;
+							}
+#endif
 
 							while (--numResolutions) {
-								int32_t *restrict tiledp = tileBuf;
+								S *restrict tiledp = tileBuf;
 
 								++tr;
 								h.s_n = rw;
@@ -313,8 +821,8 @@ bool dwt53::decode(tcd_tilecomp_t *tilec, uint32_t numres,
 										numThreads) {
 									interleave_h(&h, &tiledp[j * w]);
 									decode_line(&h);
-									memcpy(&tiledp[j * w], h.mem,
-											rw * sizeof(int32_t));
+									dwt53_put_row(&tiledp[j * w], h.mem, rw,
+											&thread_overflow);
 								}
 
 								v.d_n = (int32_t) (rh - v.s_n);
@@ -322,18 +830,56 @@ bool dwt53::decode(tcd_tilecomp_t *tilec, uint32_t numres,
 
 								decode_dwt_barrier.arrive_and_wait();
 
-								for (uint32_t j = threadId; j < rw; j +=
-										numThreads) {
+								uint32_t j = threadId;
+#ifdef GROK_DWT53_STRIP
+								if (rh > 1) {
+									typedef typename dwt53_lanes<S>::narrow narrow_t;
+									typedef typename dwt53_lanes<S>::wide wide_t;
+									auto buf = (dwt53_vec_t*) stripMem;
+									uint32_t cols =
+											narrow ? narrow_t::cols : wide_t::cols;
+									uint32_t numStrips = rw / cols;
+									for (uint32_t g = threadId; g < numStrips;
+											g += numThreads) {
+										auto strip = tiledp + g * cols;
+										if (narrow
+												&& dwt53_decode_strip<narrow_t>(
+														strip, buf, w,
+														(int32_t) v.d_n,
+														(int32_t) v.s_n, v.cas,
+														&thread_overflow))
+											continue;
+										for (uint32_t k = 0; k < cols; k +=
+												wide_t::cols)
+											dwt53_decode_strip<wide_t>(strip + k,
+													buf, w, (int32_t) v.d_n,
+													(int32_t) v.s_n, v.cas,
+													&thread_overflow);
+									}
+									j += numStrips * cols;
+								}
+#endif
+								for (; j < rw; j += numThreads) {
 									interleave_v(&v, &tiledp[j], (int32_t) w);
 									decode_line(&v);
 									for (uint32_t k = 0; k < rh; ++k) {
-										tiledp[k * w + j] = v.mem[k];
+										dwt53_put(&tiledp[k * w + j], v.mem[k],
+												&thread_overflow);
 									}
 								}
+								/* stop at the first resolution that overflows, before
+								 * its results are consumed by the next one */
+								auto resno = (uint32_t) (tr - tilec->resolutions);
+								if (thread_overflow)
+									overflow_resno = resno;
 								decode_dwt_barrier.arrive_and_wait();
+								if (overflow_resno == resno)
+									break;
 							}
 							cleanup: if (h.mem)
 								grok_aligned_free(h.mem);
+							if (stripMem)
+								grok_aligned_free(stripMem);
 							decode_dwt_calling_barrier.arrive_and_wait();
 
 						}));
@@ -343,10 +889,28 @@ bool dwt53::decode(tcd_tilecomp_t *tilec, uint32_t numres,
 	for (auto &t : dwtWorkers) {
 		t.join();
 	}
+	tilec->buf->narrow_overflow_resno = overflow_resno;
 	return rc == 0 ? true : false;
 
 }
 
+bool dwt53::is_narrow(tcd_tilecomp_t *tilec, uint32_t numres) {
+#ifdef GROK_DWT53_STRIP
+	for (uint32_t resno = 0; resno < numres; ++resno) {
+		auto res = tilec->resolutions + resno;
+		for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
+			if (res->bands[bandno].numbps > 13)
+				return false;
+		}
+	}
+	return true;
+#else
+	ARG_NOT_USED(tilec);
+	ARG_NOT_USED(numres);
+	return false;
+#endif
+}
+
 /* <summary>                            */
 /* Inverse 5-3 wavelet transform in 1-D. */
 /* </summary>                           */
@@ -381,8 +945,8 @@ void dwt53::decode_line(dwt_t *v) {
 	/* <summary>                             */
 	/* Inverse lazy transform (vertical).    */
 	/* </summary>                            */
-void dwt53::interleave_v(dwt_t *v, int32_t *a, int32_t x) {
-	int32_t *ai = a;
+template<typename S> void dwt53::interleave_v(dwt_t *v, S *a, int32_t x) {
+	S *ai = a;
 	int32_t *bi = v->mem + v->cas;
 	int32_t i = (int32_t) v->s_n;
 	while (i--) {
@@ -403,8 +967,8 @@ void dwt53::interleave_v(dwt_t *v, int32_t *a, int32_t x) {
 /* <summary>                             */
 /* Inverse lazy transform (horizontal).  */
 /* </summary>                            */
-void dwt53::interleave_h(dwt_t *h, int32_t *a) {
-	int32_t *ai = a;
+template<typename S> void dwt53::interleave_h(dwt_t *h, S *a) {
+	S *ai = a;
 	int32_t *bi = h->mem + h->cas;
 	int32_t i = (int32_t) h->s_n;
 	while (i--) {
@@ -77,6 +77,7 @@ public:
 	/**
 	 Forward wavelet transform in 2-D.
 	 Apply a reversible DWT transform to a component of an image.
+	 The whole tile component must be held in the tile buffer.
 	 @param tilec Tile component information (current tile)
 	 */
 	bool encode(tcd_tilecomp_t *tilec);
@@ -84,6 +85,7 @@ public:
 	/**
 	 Inverse wavelet transform in 2-D.
 	 Apply a reversible inverse DWT transform to a component of an image.
+	 The whole tile component must be held in the tile buffer.
 	 @param tilec Tile component information (current tile)
 	 @param numres Number of resolution levels to decode
 	 */
@@ -101,8 +103,24 @@ public:
 private:
 	void encode_line(int32_t *a, int32_t d_n, int32_t s_n, uint8_t cas);
 	void decode_line(dwt_t *v);
-	void interleave_v(dwt_t *v, int32_t *a, int32_t x);
-	void interleave_h(dwt_t *h, int32_t *a);
+	template<typename S> void interleave_v(dwt_t *v, S *a, int32_t x);
+	template<typename S> void interleave_h(dwt_t *h, S *a);
+	/**
+	 Inverse wavelet transform in 2-D of a whole tile component,
+	 stored as 32 bit or, for narrow tiles, 16 bit samples.
+	 If a 16 bit result does not fit, stops after that resolution and
+	 sets tilec->buf->narrow_overflow_resno to it.
+	 */
+	template<typename S> bool decode_tile(tcd_tilecomp_t *tilec,
+			uint32_t numres, uint32_t numThreads, S *tileBuf);
+	/**
+	 Check whether all sub-band coefficients of the resolutions to be decoded
+	 fit in 14 bits, so that inverse lifting is likely to fit in 16 bit lanes.
+	 Each strip is still range checked before narrow lifting.
+	 @param tilec Tile component information (current tile)
+	 @param numres Number of resolution levels to decode
+	 */
+	bool is_narrow(tcd_tilecomp_t *tilec, uint32_t numres);
 	void region_decode_1d(dwt53_t *buffer);
 	/**
 	 Inverse lazy transform (horizontal)
@@ -221,6 +221,8 @@ grk_codec_t* GRK_CALLCONV grk_create_decompress(GRK_CODEC_FORMAT p_format) {
 
 		l_codec->m_codec_data.m_decompression.set_decode_area = (bool (*)(void*,
 				grk_image_t*, uint32_t, uint32_t, uint32_t, uint32_t)) j2k_set_decode_area;
+		l_codec->m_codec_data.m_decompression.set_decode_areas = (bool (*)(void*,
+				const grk_decode_area_t*, uint32_t)) j2k_set_decode_areas;
 
 		l_codec->m_codec_data.m_decompression.get_decoded_tile = (bool (*)(
 				void *p_codec, GrokStream *p_cio, grk_image_t *p_image, uint32_t tile_index)) j2k_get_tile;
@@ -228,6 +230,12 @@ grk_codec_t* GRK_CALLCONV grk_create_decompress(GRK_CODEC_FORMAT p_format) {
 		l_codec->m_codec_data.m_decompression.set_decoded_resolution_factor =
 				(bool (*)(void *p_codec, uint32_t res_factor)) j2k_set_decoded_resolution_factor;
 
+		l_codec->m_codec_data.m_decompression.decode_layers = (bool (*)(
+				void *p_codec, grk_image_t *p_image, uint32_t num_layers)) j2k_decode_layers;
+
+		l_codec->m_codec_data.m_decompression.decode_update = (bool (*)(
+				void *p_codec, GrokStream *p_cio, grk_image_t *p_image)) j2k_decode_update;
+
 		l_codec->m_codec = j2k_create_decompress();
 
 		if (!l_codec->m_codec) {
@@ -261,6 +269,8 @@ grk_codec_t* GRK_CALLCONV grk_create_decompress(GRK_CODEC_FORMAT p_format) {
 				grk_dparameters_t*)) jp2_setup_decoder;
 		l_codec->m_codec_data.m_decompression.set_decode_area = (bool (*)(void*,
 				grk_image_t*, uint32_t, uint32_t, uint32_t, uint32_t)) jp2_set_decode_area;
+		l_codec->m_codec_data.m_decompression.set_decode_areas = (bool (*)(void*,
+				const grk_decode_area_t*, uint32_t)) jp2_set_decode_areas;
 
 		l_codec->m_codec_data.m_decompression.get_decoded_tile = (bool (*)(
 				void *p_codec, GrokStream *p_cio, grk_image_t *p_image, uint32_t tile_index)) jp2_get_tile;
@@ -268,6 +278,12 @@ grk_codec_t* GRK_CALLCONV grk_create_decompress(GRK_CODEC_FORMAT p_format) {
 		l_codec->m_codec_data.m_decompression.set_decoded_resolution_factor =
 				(bool (*)(void *p_codec, uint32_t res_factor)) jp2_set_decoded_resolution_factor;
 
+		l_codec->m_codec_data.m_decompression.decode_layers = (bool (*)(
+				void *p_codec, grk_image_t *p_image, uint32_t num_layers)) jp2_decode_layers;
+
+		l_codec->m_codec_data.m_decompression.decode_update = (bool (*)(
+				void *p_codec, GrokStream *p_cio, grk_image_t *p_image)) jp2_decode_update;
+
 		l_codec->m_codec = jp2_create(true);
 		if (!l_codec->m_codec) {
 			grok_free(l_codec);
@@ -318,11 +334,44 @@ bool GRK_CALLCONV grk_read_header_ex(grk_stream_t *p_stream,
 			return false;
 		}
 
-		return l_codec->m_codec_data.m_decompression.read_header(l_stream,
-				l_codec->m_codec, header_info, p_image);
+		auto l_cache = HeaderCache::instance();
+		if (l_stream->m_identity.empty() || !l_cache->enabled())
+			return l_codec->m_codec_data.m_decompression.read_header(l_stream,
+					l_codec->m_codec, header_info, p_image);
+
+		/* cache hit: parse the cached header bytes, and then carry on
+		 * with the file stream from the first tile-part */
+		auto l_entry = l_cache->get(l_stream->m_identity);
+		if (l_entry) {
+			auto l_header_stream = (GrokStream*) create_buffer_stream(
+					(uint8_t*) l_entry->header.data(), l_entry->header.size(),
+					false, true);
+			if (!l_header_stream)
+				return false;
+			bool l_rc = l_codec->m_codec_data.m_decompression.read_header(
+					l_header_stream, l_codec->m_codec, header_info, p_image);
+			grk_stream_destroy((grk_stream_t*) l_header_stream);
+			return l_rc && l_stream->seek(l_entry->header.size());
+		}
+
+		/* cache miss: read header from file, then store the header bytes */
+		if (!l_codec->m_codec_data.m_decompression.read_header(l_stream,
+				l_codec->m_codec, header_info, p_image))
+			return false;
+		uint64_t l_header_len = l_stream->tell();
+		auto l_new_entry = std::make_shared<HeaderCacheEntry>();
+		l_new_entry->header.resize(l_header_len);
+		if (l_stream->seek(0)
+				&& l_stream->read(l_new_entry->header.data(), l_header_len)
+						== l_header_len)
+			l_cache->put(l_stream->m_identity, l_new_entry);
+		return l_stream->seek(l_header_len);
 	}
 	return false;
 }
+void GRK_CALLCONV grk_set_header_cache_size(uint32_t num_entries) {
+	HeaderCache::instance()->set_capacity(num_entries);
+}
 
 bool GRK_CALLCONV grk_decode(grk_codec_t *p_codec, grok_plugin_tile_t *tile,
 		grk_stream_t *p_stream, grk_image_t *p_image) {
@@ -337,6 +386,113 @@ bool GRK_CALLCONV grk_decode(grk_codec_t *p_codec, grok_plugin_tile_t *tile,
 	}
 	return false;
 }
+static grk_decode_area_t grk_decode_area_union(const grk_decode_area_t &a,
+		const grk_decode_area_t &b) {
+	return {std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1),
+			std::max(a.y1, b.y1)};
+}
+
+/**
+ * Copy an area of a decoded image into a new image
+ */
+static grk_image_t* grk_crop_decoded_image(const grk_image_t *p_image,
+		const grk_decode_area_t &area) {
+	auto l_image = grk_image_create0();
+	if (!l_image)
+		return nullptr;
+	grk_copy_image_header(p_image, l_image);
+	if (!l_image->comps) {
+		grk_image_destroy(l_image);
+		return nullptr;
+	}
+	memcpy(l_image->capture_resolution, p_image->capture_resolution,
+			sizeof(p_image->capture_resolution));
+	memcpy(l_image->display_resolution, p_image->display_resolution,
+			sizeof(p_image->display_resolution));
+	l_image->x0 = area.x0;
+	l_image->y0 = area.y0;
+	l_image->x1 = area.x1;
+	l_image->y1 = area.y1;
+	for (uint32_t compno = 0; compno < l_image->numcomps; ++compno) {
+		auto l_src = p_image->comps + compno;
+		auto l_dest = l_image->comps + compno;
+		uint32_t l_reduce = l_src->decodeScaleFactor;
+		l_dest->x0 = ceildiv<uint32_t>(area.x0, l_src->dx);
+		l_dest->y0 = ceildiv<uint32_t>(area.y0, l_src->dy);
+		uint32_t l_x0 = uint_ceildivpow2(l_dest->x0, l_reduce);
+		uint32_t l_y0 = uint_ceildivpow2(l_dest->y0, l_reduce);
+		l_dest->w = uint_ceildivpow2(ceildiv<uint32_t>(area.x1, l_src->dx),
+				l_reduce) - l_x0;
+		l_dest->h = uint_ceildivpow2(ceildiv<uint32_t>(area.y1, l_src->dy),
+				l_reduce) - l_y0;
+		l_dest->owns_data = false;
+		if (!l_src->data)
+			continue;
+		if (!grk_image_single_component_data_alloc(l_dest)) {
+			grk_image_destroy(l_image);
+			return nullptr;
+		}
+		/* offset of area in source component */
+		uint32_t l_off_x = l_x0 - uint_ceildivpow2(l_src->x0, l_reduce);
+		uint32_t l_off_y = l_y0 - uint_ceildivpow2(l_src->y0, l_reduce);
+		for (uint32_t j = 0; j < l_dest->h; ++j)
+			memcpy(l_dest->data + (uint64_t) j * l_dest->w,
+					l_src->data + l_off_x
+							+ (uint64_t) (l_off_y + j) * l_src->w,
+					l_dest->w * sizeof(int32_t));
+	}
+	return l_image;
+}
+
+bool GRK_CALLCONV grk_decode_areas(grk_codec_t *p_codec,
+		grk_stream_t *p_stream, grk_image_t *p_image,
+		const grk_decode_area_t *areas, uint32_t num_areas,
+		grk_image_t **p_area_images) {
+	if (!p_codec || !p_stream || !p_image || !areas || !num_areas
+			|| !p_area_images)
+		return false;
+	codec_private_t *l_codec = (codec_private_t*) p_codec;
+	GrokStream *l_stream = (GrokStream*) p_stream;
+	if (!l_codec->is_decompressor)
+		return false;
+	for (uint32_t i = 0; i < num_areas; ++i) {
+		auto &l_area = areas[i];
+		p_area_images[i] = nullptr;
+		if (l_area.x0 >= l_area.x1 || l_area.y0 >= l_area.y1
+				|| l_area.x0 < p_image->x0 || l_area.y0 < p_image->y0
+				|| l_area.x1 > p_image->x1 || l_area.y1 > p_image->y1) {
+			GROK_ERROR(
+					"Decode area %d (%d,%d,%d,%d) is empty, or outside of image area (%d,%d,%d,%d)",
+					i, l_area.x0, l_area.y0, l_area.x1, l_area.y1, p_image->x0,
+					p_image->y0, p_image->x1, p_image->y1);
+			return false;
+		}
+	}
+
+	/* decode the bounding box of all areas in one pass: only tiles and code-blocks
+	 * needed by at least one area are decoded, then each area is cropped from it */
+	grk_decode_area_t l_bounds = areas[0];
+	for (uint32_t i = 1; i < num_areas; ++i)
+		l_bounds = grk_decode_area_union(l_bounds, areas[i]);
+	auto l_decompression = &l_codec->m_codec_data.m_decompression;
+	bool l_rc = l_decompression->set_decode_area(l_codec->m_codec, p_image,
+			l_bounds.x0, l_bounds.y0, l_bounds.x1, l_bounds.y1)
+			&& l_decompression->set_decode_areas(l_codec->m_codec, areas,
+					num_areas)
+			&& l_decompression->decode(l_codec->m_codec, nullptr, l_stream,
+					p_image);
+	for (uint32_t i = 0; i < num_areas && l_rc; ++i) {
+		p_area_images[i] = grk_crop_decoded_image(p_image, areas[i]);
+		l_rc = p_area_images[i] != nullptr;
+	}
+	if (!l_rc) {
+		for (uint32_t i = 0; i < num_areas; ++i) {
+			grk_image_destroy(p_area_images[i]);
+			p_area_images[i] = nullptr;
+		}
+	}
+	return l_rc;
+}
 bool GRK_CALLCONV grk_set_decode_area(grk_codec_t *p_codec,
 		grk_image_t *p_image, uint32_t start_x, uint32_t start_y,
 		uint32_t end_x, uint32_t end_y) {
@@ -400,6 +556,35 @@ bool GRK_CALLCONV grk_get_decoded_tile(grk_codec_t *p_codec,
 	}
 	return false;
 }
+
+void GRK_CALLCONV grk_set_tile_cache_size(uint64_t max_bytes) {
+	TileCache::instance()->set_capacity(max_bytes);
+}
+void GRK_CALLCONV grk_get_tile_cache_stats(grk_tile_cache_stats_t *stats) {
+	if (stats)
+		TileCache::instance()->get_stats(stats);
+}
+
+bool GRK_CALLCONV grk_decode_layers(grk_codec_t *p_codec,
+		grk_image_t *p_image, uint32_t num_layers) {
+	codec_private_t *l_codec = (codec_private_t*) p_codec;
+	if (!l_codec || !p_image || !l_codec->is_decompressor) {
+		return false;
+	}
+	return l_codec->m_codec_data.m_decompression.decode_layers(
+			l_codec->m_codec, p_image, num_layers);
+}
+
+bool GRK_CALLCONV grk_decode_update(grk_codec_t *p_codec,
+		grk_stream_t *p_stream, grk_image_t *p_image) {
+	codec_private_t *l_codec = (codec_private_t*) p_codec;
+	if (!l_codec || !p_stream || !p_image || !l_codec->is_decompressor) {
+		return false;
+	}
+	return l_codec->m_codec_data.m_decompression.decode_update(
+			l_codec->m_codec, (GrokStream*) p_stream, p_image);
+}
+
 bool GRK_CALLCONV grk_set_decoded_resolution_factor(grk_codec_t *p_codec,
 		uint32_t res_factor) {
 	codec_private_t *l_codec = (codec_private_t*) p_codec;
@@ -435,6 +620,8 @@ grk_codec_t* GRK_CALLCONV grk_create_compress(GRK_CODEC_FORMAT p_format) {
 				(void (*)(void*)) j2k_destroy;
 		l_codec->m_codec_data.m_compression.setup_encoder =
 				(bool (*)(void*, grk_cparameters_t*, grk_image_t*)) j2k_setup_encoder;
+		l_codec->m_codec_data.m_compression.get_compress_stats =
+				(bool (*)(void*, grk_compress_stats_t*)) j2k_get_compress_stats;
 		l_codec->m_codec = j2k_create_compress();
 		if (!l_codec->m_codec) {
 			grok_free(l_codec);
@@ -455,6 +642,8 @@ grk_codec_t* GRK_CALLCONV grk_create_compress(GRK_CODEC_FORMAT p_format) {
 				(void (*)(void*)) jp2_destroy;
 		l_codec->m_codec_data.m_compression.setup_encoder =
 				(bool (*)(void*, grk_cparameters_t*, grk_image_t*)) jp2_setup_encoder;
+		l_codec->m_codec_data.m_compression.get_compress_stats =
+				(bool (*)(void*, grk_compress_stats_t*)) jp2_get_compress_stats;
 
 		l_codec->m_codec = jp2_create(false);
 		if (!l_codec->m_codec) {
@@ -546,6 +735,17 @@ bool GRK_CALLCONV grk_end_compress(grk_codec_t *p_codec,
 	}
 	return false;
 }
+bool GRK_CALLCONV grk_get_compress_stats(grk_codec_t *p_codec,
+		grk_compress_stats_t *stats) {
+	if (p_codec && stats) {
+		codec_private_t *l_codec = (codec_private_t*) p_codec;
+		if (!l_codec->is_decompressor) {
+			return l_codec->m_codec_data.m_compression.get_compress_stats(
+					l_codec->m_codec, stats);
+		}
+	}
+	return false;
+}
 bool GRK_CALLCONV grk_end_decompress(grk_codec_t *p_codec,
 		grk_stream_t *p_stream) {
 	if (p_codec && p_stream) {
@@ -670,6 +870,59 @@ static void grok_free_file(void *p_user_data) {
 		fclose((FILE*) p_user_data);
 }
 
+/**
+ * Read source for a pipe, or any other file that cannot seek.
+ * Everything read from the pipe is retained, so that the stream
+ * can seek back within the data read so far.
+ */
+struct pipe_source_t {
+	pipe_source_t(FILE *p_file, bool ownsFile) :
+			file(p_file), owns_file(ownsFile), off(0) {
+	}
+	~pipe_source_t() {
+		if (owns_file)
+			fclose(file);
+	}
+	/* read from the pipe until the spool holds len bytes, or the pipe ends */
+	void fill(uint64_t len) {
+		if (len <= spool.size())
+			return;
+		size_t l_old = spool.size();
+		spool.resize((size_t) len);
+		size_t l_nb_read = fread(spool.data() + l_old, 1, (size_t) len - l_old,
+				file);
+		spool.resize(l_old + l_nb_read);
+	}
+	FILE *file;
+	bool owns_file;
+	std::vector<uint8_t> spool;
+	uint64_t off;
+};
+
+static size_t grok_read_from_pipe(void *p_buffer, size_t nb_bytes,
+		pipe_source_t *p_pipe) {
+	p_pipe->fill(p_pipe->off + nb_bytes);
+	if (p_pipe->off >= p_pipe->spool.size())
+		return (size_t) -1;
+	size_t l_nb_read = std::min<size_t>(nb_bytes,
+			p_pipe->spool.size() - (size_t) p_pipe->off);
+	memcpy(p_buffer, p_pipe->spool.data() + p_pipe->off, l_nb_read);
+	p_pipe->off += l_nb_read;
+	return l_nb_read;
+}
+
+/* like fseek, a seek may go past the data read so far: nothing is read
+ * from the pipe until the data is needed, since the writer may not have
+ * sent it yet */
+static bool grok_seek_in_pipe(uint64_t nb_bytes, pipe_source_t *p_pipe) {
+	p_pipe->off = nb_bytes;
+	return true;
+}
+
+static void grok_free_pipe(void *p_user_data) {
+	delete (pipe_source_t*) p_user_data;
+}
+
 grk_stream_t* GRK_CALLCONV grk_stream_create_default_file_stream(
 		const char *fname, bool p_is_read_stream) {
 	return grk_stream_create_file_stream(fname, stream_chunk_size,
@@ -698,12 +951,28 @@ grk_stream_t* GRK_CALLCONV grk_stream_create_file_stream(const char *fname,
 			fclose(p_file);
 		return nullptr;
 	}
+	if (p_is_read_stream && GROK_FSEEK(p_file, 0, SEEK_CUR)) {
+		/* pipe: length is unknown until set with grk_stream_set_user_data_length */
+		grk_stream_set_user_data(l_stream,
+				(void*) new pipe_source_t(p_file, !stdin_stdout),
+				grok_free_pipe);
+		grk_stream_set_user_data_length(l_stream, INT64_MAX);
+		grk_stream_set_read_function(l_stream,
+				(grk_stream_read_fn) grok_read_from_pipe);
+		grk_stream_set_seek_function(l_stream,
+				(grk_stream_seek_fn) grok_seek_in_pipe);
+		return l_stream;
+	}
 	grk_stream_set_user_data(l_stream, (void*) p_file,
 			(grk_stream_free_user_data_fn) (
 					stdin_stdout ? nullptr : grok_free_file));
-	if (p_is_read_stream)
+	if (p_is_read_stream) {
 		grk_stream_set_user_data_length(l_stream,
 				grk_get_data_length_from_file(p_file));
+		if (!stdin_stdout)
+			((GrokStream*) l_stream)->m_identity = header_cache_file_identity(
+					fileno(p_file));
+	}
 	grk_stream_set_read_function(l_stream,
 			(grk_stream_read_fn) grok_read_from_file);
 	grk_stream_set_write_function(l_stream,
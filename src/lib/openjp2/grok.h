@@ -485,12 +485,32 @@ typedef struct grk_cparameters {
 	double display_resolution[2];
 
 	uint32_t rateControlAlgorithm; // 0: bisect with all truncation points,  1: bisect with only feasible truncation points
+	/** code every code-block pass. By default, bisection rate control
+	 does not code passes far below the expected truncation threshold,
+	 which is taken from the previous tile, or estimated from a sample of
+	 code-blocks for the first tile */
+	bool code_all_passes;
 	uint32_t numThreads;
 	int32_t deviceId;
 	uint32_t duration; //seconds
 	uint32_t kernelBuildOptions;
 	uint32_t repeats;
 	bool verbose;
+	/**
+	 Buffer input: if not null, samples are read directly from this
+	 caller-supplied 8 or 16 bit buffer while filling tile buffers,
+	 and image component data is not used (it may be null).
+	 All components must share the image dimensions, with no sub-sampling,
+	 and component precision must not exceed input_prec.
+	 */
+	void *input_buffer;
+	/** number of bytes between the start of two consecutive rows of input buffer */
+	uint64_t input_stride;
+	/** bits per input sample : either 8 or 16 */
+	uint32_t input_prec;
+	/** true if components are interleaved; otherwise, component planes
+	 of input_stride * image height bytes follow one another */
+	bool input_interleaved;
 } grk_cparameters_t;
 
 /**
@@ -612,6 +632,60 @@ typedef struct grk_header_info {
 
 } grk_header_info_t;
 
+/**
+ * Decoded samples of one image component, for a region of the output image
+ * */
+typedef struct grk_decoded_region_comp {
+	/** left boundary of region, relative to (reduced) component origin */
+	uint32_t x0;
+	/** top boundary of region, relative to (reduced) component origin */
+	uint32_t y0;
+	/** region width */
+	uint32_t w;
+	/** region height */
+	uint32_t h;
+	/** number of samples between the start of two consecutive rows */
+	uint32_t stride;
+	/** precision */
+	uint32_t prec;
+	/** true if samples are signed */
+	bool sgnd;
+	/** decoded samples: only valid for the duration of the sink callback */
+	const int32_t *data;
+} grk_decoded_region_comp_t;
+
+/**
+ * Region of the output image that has been fully decoded
+ * */
+typedef struct grk_decoded_region {
+	/** index of the tile that the region belongs to */
+	uint32_t tile_index;
+	/** number of components */
+	uint32_t numcomps;
+	/** components */
+	grk_decoded_region_comp_t *comps;
+} grk_decoded_region_t;
+
+/**
+ * Area of the image to decode, in reference grid coordinates
+ * */
+typedef struct grk_decode_area {
+	uint32_t x0;
+	uint32_t y0;
+	uint32_t x1;
+	uint32_t y1;
+} grk_decode_area_t;
+
+/**
+ * Callback that receives each decoded region in streaming decode mode.
+ *
+ * @param region		decoded region
+ * @param user_data		user data passed in with decompression parameters
+ * @return false to abort decoding
+ */
+typedef bool (*grk_decode_sink_fn)(grk_decoded_region_t *region,
+		void *user_data);
+
 /**
  * Decompression parameters
  * */
@@ -624,6 +698,15 @@ typedef struct grk_dparameters {
 	 if == 0 or not used, image is decoded to the full resolution
 	 */
 	uint32_t cp_reduce;
+	/**
+	 Thumbnail: if true, cp_reduce is ignored and only the lowest resolution
+	 common to all components is decoded. Packets of higher resolutions are skipped
+	 without being parsed when the codestream allows it (resolution-major progression,
+	 or PLT markers). Precinct and code-block structures are still set up for all
+	 resolutions of each decoded tile, so tile setup cost and memory are those of a
+	 full resolution decode.
+	 */
+	bool thumbnail;
 	/**
 	 Set the maximum number of quality layers to decode.
 	 If there are less quality layers than the specified number, all the quality layers are decoded.
@@ -657,6 +740,72 @@ typedef struct grk_dparameters {
 	uint32_t nb_tile_to_decode;
 	uint32_t flags;
 	uint32_t numThreads;
+	/**
+	 Streaming decode: if not null, each tile is passed to this callback
+	 as soon as it is decoded, and then released. Output image components
+	 are not allocated, so memory use is bounded by a single tile,
+	 rather than by the full image.
+	 Note: JP2 palettes are not applied in this mode.
+	 */
+	grk_decode_sink_fn sink;
+	/** user data passed to sink callback */
+	void *sink_user_data;
+	/**
+	 Streaming decode: limit on the decoded sample data of a single tile,
+	 in bytes. A tile that needs more fails to decode; decoding is not
+	 throttled to fit. Since tiles are decoded one at a time, this also
+	 bounds the tile buffers held at once. It does not include compressed
+	 data, code block buffers, or the output image.
+	 if == 0, then there is no limit
+	 */
+	uint64_t max_tile_memory;
+	/**
+	 Interleaved output: if not null, decoded samples are written directly
+	 into this caller-supplied buffer, with components interleaved,
+	 and output image components are not allocated.
+	 All components must share the same dimensions, and samples are not rescaled,
+	 so component precision must not exceed interleaved_prec.
+	 Samples are written unsigned, so signed components are rejected.
+	 Note: JP2 palettes are not applied in this mode.
+	 */
+	void *interleaved_buffer;
+	/** size in bytes of interleaved buffer: must be at least
+	 interleaved_stride * (height - 1) + width * number of components * (interleaved_prec / 8)*/
+	uint64_t interleaved_buffer_len;
+	/** number of bytes between the start of two consecutive rows of interleaved buffer */
+	uint64_t interleaved_stride;
+	/** bits per interleaved sample : either 8 or 16 */
+	uint32_t interleaved_prec;
+	/**
+	 Component subset decode: if != 0, then only the listed components are decoded,
+	 and the output image contains only these components, in increasing index order.
+	 Other components are skipped at T2, and are not passed through T1, DWT or DC shift,
+	 unless they are needed to invert a multiple component transform.
+	 Note: JP2 palettes and channel definitions are not applied in this mode.
+	 The subset only applies to the next image read by the decompressor
+	 (see grk_read_header).
+	 if == 0, then all components are decoded
+	 */
+	uint32_t numcomps_to_decode;
+	/** indices of components to decode (array of numcomps_to_decode entries,
+	 copied by the library during decoder setup) */
+	uint32_t *comps_to_decode;
+	/**
+	 Layer refinement: if true, compressed tile data and decoded code-block coefficients
+	 are retained after decoding, so that more quality layers can later be decoded
+	 with grk_decode_layers. The input stream must stay open until the codec is destroyed.
+	 */
+	bool layer_refinement;
+	/**
+	 Growing stream: the codestream is still arriving while it is decoded.
+	 grk_decode decodes the data available so far, and grk_decode_update
+	 continues from there once more data has been appended. Tile data is retained
+	 as with layer_refinement. The source may be a file being appended to, or a pipe
+	 opened with grk_stream_create_file_stream; in both cases, the length of the data
+	 that has arrived is set with grk_stream_set_user_data_length.
+	 Codestreams with PPM or PPT markers are not supported.
+	 */
+	bool growing_stream;
 } grk_dparameters_t;
 
 typedef enum grk_prec_mode {
@@ -812,6 +961,31 @@ typedef struct grk_image_comp {
 	uint16_t alpha;
 } grk_image_comp_t;
 
+/**
+ * Decoded tile cache statistics
+ */
+typedef struct grk_tile_cache_stats {
+	/** number of tiles found in cache */
+	uint64_t hits;
+	/** number of tiles not found in cache */
+	uint64_t misses;
+	/** number of tiles held in cache */
+	uint64_t num_tiles;
+	/** number of bytes held in cache */
+	uint64_t num_bytes;
+} grk_tile_cache_stats_t;
+
+/**
+ * Compressor statistics
+ */
+typedef struct grk_compress_stats {
+	/** number of code-block passes coded */
+	uint64_t passes_coded;
+	/** number of code-block passes not coded, because rate control
+	 was expected to discard them */
+	uint64_t passes_skipped;
+} grk_compress_stats_t;
+
 /**
  * Defines image data and characteristics
  * */
@@ -1271,6 +1445,8 @@ GRK_API void GRK_CALLCONV grk_stream_set_user_data(grk_stream_t *p_stream,
 
 /**
  * Sets the length of the user data for the stream.
+ * For a read stream on a file that is still being written, the length can be
+ * increased as data arrives (see grk_decode_update).
  *
  * @param p_stream    the stream to modify
  * @param data_length length of the user_data.
@@ -1286,7 +1462,9 @@ GRK_API void GRK_CALLCONV grk_stream_set_user_data_length(
 GRK_API grk_stream_t* GRK_CALLCONV grk_stream_create_default_file_stream(
 		const char *fname, bool p_is_read_stream);
 
-/** Create a stream from a file identified with its filename with a specific buffer size
+/** Create a stream from a file identified with its filename with a specific buffer size.
+ * A read stream may also be created on a pipe (for example a named pipe): data read
+ * from the pipe is retained in memory, so that the stream can still seek.
  * @param fname             the filename of the file to stream
  * @param p_buffer_size     size of the chunk used to stream
  * @param p_is_read_stream  whether the stream is a read stream (true) or not (false)
@@ -1391,6 +1569,15 @@ GRK_API bool GRK_CALLCONV grk_setup_decoder(grk_codec_t *p_codec,
 /**
  * Decodes an image header.
  *
+ * A decompressor may be reused for a sequence of images (for example, the frames
+ * of a motion sequence): once an image has been decoded, call this function
+ * again with the next stream. Decoding parameters set with grk_setup_decoder
+ * are kept, and so are the decoder's tile structures and working buffers,
+ * which saves their allocation for every image. The decode area must be set again.
+ * A component subset (comps_to_decode) only applies to the image whose header is
+ * read next after grk_setup_decoder: later images are decoded with all components,
+ * unless grk_setup_decoder selects a subset again.
+ *
  * @param	p_stream		the jpeg2000 stream.
  * @param	p_codec			the jpeg2000 codec to read.
  * @param	p_image			the image structure initialized with the characteristics of encoded image.
@@ -1414,6 +1601,22 @@ GRK_API bool GRK_CALLCONV grk_read_header_ex(grk_stream_t *p_stream,
 		grk_codec_t *p_codec, grk_header_info_t *header_info,
 		grk_image_t **p_image);
 
+/**
+ * Sets the number of image headers kept in the process-wide header cache.
+ *
+ * When the cache is enabled, headers read from file streams and memory mapped
+ * file streams are cached, keyed by file identity (device, inode, size and
+ * modification time). A decompressor that later reads the header of the same
+ * file parses it from memory, and, once one decode has walked the whole
+ * code stream, also gets the positions of all tile-parts, so that decoding
+ * a region seeks directly to the tile-parts of that region.
+ * The cache may be shared by decompressors running on different threads.
+ *
+ * @param	num_entries		maximum number of cached headers. Zero (the default)
+ *							disables the cache and releases all cached headers.
+ */
+GRK_API void GRK_CALLCONV grk_set_header_cache_size(uint32_t num_entries);
+
 /**
  * Sets the given area to be decoded. This function should be called right after grk_read_header and before any tile header reading.
  *
@@ -1503,6 +1706,32 @@ typedef struct grok_plugin_tile {
 GRK_API bool GRK_CALLCONV grk_decode(grk_codec_t *p_decompressor,
 		grok_plugin_tile_t *tile, grk_stream_t *p_stream, grk_image_t *p_image);
 
+/**
+ * Decode several areas of an image at once, for example a viewport together
+ * with the prefetch areas around it.
+ *
+ * All areas are decoded in a single pass over the codestream: tiles and
+ * code-blocks that none of the areas need are skipped, and code-blocks
+ * shared by several areas go through T2, T1 and the inverse DWT only once.
+ * One image is then returned for each area, cropped from the decoded
+ * bounding box of all areas. The bounding box is held in p_image, so its
+ * size, and not the size of the areas, sets the memory used.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_stream			input stream
+ * @param p_image 			image returned by grk_read_header. It receives the
+ * 							bounding box of all areas, which is only defined within the areas.
+ * @param areas				areas to decode, in reference grid coordinates
+ * @param num_areas			number of areas
+ * @param p_area_images		array of num_areas images, that receives the decoded image
+ * 							of each area. Images must be destroyed with grk_image_destroy
+ * @return 					true if success, otherwise false
+ * */
+GRK_API bool GRK_CALLCONV grk_decode_areas(grk_codec_t *p_decompressor,
+		grk_stream_t *p_stream, grk_image_t *p_image,
+		const grk_decode_area_t *areas, uint32_t num_areas,
+		grk_image_t **p_area_images);
+
 /**
  * Get the decoded tile from the codec
  *
@@ -1516,6 +1745,65 @@ GRK_API bool GRK_CALLCONV grk_decode(grk_codec_t *p_decompressor,
 GRK_API bool GRK_CALLCONV grk_get_decoded_tile(grk_codec_t *p_codec,
 		grk_stream_t *p_stream, grk_image_t *p_image, uint32_t tile_index);
 
+/**
+ * Sets the budget, in bytes, of the process-wide cache of tiles decoded by
+ * grk_get_decoded_tile.
+ *
+ * Tiles are cached for file streams and memory mapped file streams, keyed by
+ * file identity, tile index, decode area, resolution reduction, number of quality
+ * layers and decoded components. When the same tile is requested again, for
+ * example while panning back and forth in a viewer, its samples are copied from
+ * the cache instead of being decoded. Least recently used tiles are evicted once
+ * the budget is exceeded. The cache may be shared by decompressors running
+ * on different threads. Tiles decoded to a sink or to an interleaved buffer
+ * are not cached.
+ *
+ * @param	max_bytes		cache budget. Zero (the default) disables the cache
+ * 							and releases all cached tiles.
+ */
+GRK_API void GRK_CALLCONV grk_set_tile_cache_size(uint64_t max_bytes);
+
+/**
+ * Gets the statistics of the decoded tile cache
+ *
+ * @param	stats			statistics
+ */
+GRK_API void GRK_CALLCONV grk_get_tile_cache_stats(
+		grk_tile_cache_stats_t *stats);
+
+/**
+ * Refine an image decoded by grk_decode, by decoding a different number of quality layers.
+ * The decoder must have been set up with layer_refinement enabled.
+ * Compressed data is not read again from the stream; only tiles whose number of decoded layers
+ * changes are decoded, and only code-blocks that receive new compressed data go through T1.
+ * Not supported together with component subset decoding, or with JP2 palettes and channel definitions.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_image			image returned by grk_decode
+ * @param	num_layers		number of quality layers to decode (0 : all layers)
+ *
+ * @return					true if success, otherwise false
+ */
+GRK_API bool GRK_CALLCONV grk_decode_layers(grk_codec_t *p_codec,
+		grk_image_t *p_image, uint32_t num_layers);
+
+/**
+ * Update an image decoded by grk_decode from a growing stream, after more of the
+ * codestream has become available. The decoder must have been set up with growing_stream
+ * enabled, and the new stream length must have been set with grk_stream_set_user_data_length.
+ * Decoding resumes where the previous call stopped: tiles that were already complete are
+ * not decoded again, and within a tile that receives more data, only code-blocks
+ * that receive new compressed data go through T1.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_stream		the stream passed to grk_decode
+ * @param	p_image			image returned by grk_decode
+ *
+ * @return					true if success, otherwise false
+ */
+GRK_API bool GRK_CALLCONV grk_decode_update(grk_codec_t *p_codec,
+		grk_stream_t *p_stream, grk_image_t *p_image);
+
 /**
  * Set the resolution factor of the decoded image
  * @param	p_codec			the jpeg2000 codec.
@@ -1641,6 +1929,16 @@ GRK_API bool GRK_CALLCONV grk_start_compress(grk_codec_t *p_codec,
 GRK_API bool GRK_CALLCONV grk_end_compress(grk_codec_t *p_codec,
 		grk_stream_t *p_stream);
 
+/**
+ * Gets the statistics of the tiles compressed so far
+ * @param p_codec 		Compressor handle
+ * @param stats 		statistics
+ *
+ * @return 				Returns true if successful, returns false otherwise
+ */
+GRK_API bool GRK_CALLCONV grk_get_compress_stats(grk_codec_t *p_codec,
+		grk_compress_stats_t *stats);
+
 /**
  * Encode an image into a JPEG-2000 codestream
  * @param p_codec 		compressor handle
@@ -94,6 +94,10 @@ struct codec_private_t {
 					uint32_t start_x, uint32_t end_x, uint32_t start_y,
 					uint32_t end_y);
 
+			/** Set decode areas function handler */
+			bool (*set_decode_areas)(void *p_codec,
+					const grk_decode_area_t *areas, uint32_t num_areas);
+
 			/** Get tile function */
 			bool (*get_decoded_tile)(void *p_codec, GrokStream *p_cio,
 					grk_image_t *p_image,
@@ -102,6 +106,14 @@ struct codec_private_t {
 			/** Set the decoded resolution factor */
 			bool (*set_decoded_resolution_factor)(void *p_codec,
 					uint32_t res_factor);
+
+			/** Decode a different number of quality layers into previously decoded image */
+			bool (*decode_layers)(void *p_codec, grk_image_t *p_image,
+					uint32_t num_layers);
+
+			/** Continue decoding a growing stream into previously decoded image */
+			bool (*decode_update)(void *p_codec, GrokStream *p_cio,
+					grk_image_t *p_image);
 		} m_decompression;
 
 		/**
@@ -123,6 +135,9 @@ struct codec_private_t {
 
 			bool (*setup_encoder)(void *p_codec, grk_cparameters_t *p_param,
 					grk_image_t *p_image);
+
+			bool (*get_compress_stats)(void *p_codec,
+					grk_compress_stats_t *stats);
 		} m_compression;
 	} m_codec_data;
 	/** FIXME DOC*/
@@ -188,6 +188,8 @@ static inline long grok_lrintf(float f) {
 #include "BitIO.h"
 #include "GrokStream.h"
 #include "EncodedTileData.h"
+#include "HeaderCache.h"
+#include "TileCache.h"
 
 #include "image.h"
 #include "invert.h"
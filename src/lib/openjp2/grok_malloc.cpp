@@ -61,6 +61,9 @@
 
 namespace grk {
 
+// 32 byte alignment allows aligned AVX2 loads and stores
+const size_t default_alignment = 32U;
+
 static inline void* grk_aligned_alloc_n(size_t alignment, size_t size) {
 	void *ptr;
 
@@ -222,10 +225,10 @@ void* grok_calloc(size_t num, size_t size) {
 }
 
 void* grok_aligned_malloc(size_t size) {
-	return grk_aligned_alloc_n(16U, size);
+	return grk_aligned_alloc_n(default_alignment, size);
 }
 void* grok_aligned_realloc(void *ptr, size_t size) {
-	return grok_aligned_realloc_n(ptr, 16U, size);
+	return grok_aligned_realloc_n(ptr, default_alignment, size);
 }
 
 void grok_aligned_free(void *ptr) {
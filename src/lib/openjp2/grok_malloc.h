@@ -83,7 +83,7 @@ void* grok_malloc(size_t size);
 void* grok_calloc(size_t numOfElements, size_t sizeOfElements);
 
 /**
- Allocate memory aligned to a 16 byte boundary
+ Allocate memory aligned to a 32 byte boundary
  @param size Bytes to allocate
  @return a void pointer to the allocated space, or nullptr if there is insufficient memory available
  */
@@ -74,7 +74,7 @@ tcp_t::tcp_t() :
 				0), numpocs(0), ppt_markers_count(0), ppt_markers(nullptr), ppt_data(
 				nullptr), ppt_buffer(nullptr), ppt_data_size(0), ppt_len(0), tccps(
 				nullptr), m_current_tile_part_number(-1), m_nb_tile_parts(0), m_tile_data(
-				nullptr), mct_norms(nullptr), m_mct_decoding_matrix(nullptr), m_mct_coding_matrix(
+				nullptr), m_packet_lengths(nullptr), m_refinement(nullptr), mct_norms(nullptr), m_mct_decoding_matrix(nullptr), m_mct_coding_matrix(
 				nullptr), m_mct_records(nullptr), m_nb_mct_records(0), m_nb_max_mct_records(
 				0), m_mcc_records(nullptr), m_nb_mcc_records(0), m_nb_max_mcc_records(
 				0), cod(0), ppt(0), POC(0)
@@ -120,6 +120,53 @@ static void j2k_transfer_image_data(grk_image_t *src, grk_image_t *dest) {
 	}
 }
 
+/**
+ Remove components that were not selected for decoding from image,
+ keeping the selected components in increasing index order
+ */
+static void j2k_remove_unselected_components(cp_t *p_cp, grk_image_t *image) {
+	if (!p_cp->m_specific_param.m_dec.m_numcomps_to_decode || !image->comps)
+		return;
+	uint32_t numcomps = 0;
+	for (uint32_t compno = 0; compno < image->numcomps; compno++) {
+		grk_image_comp_t *comp = image->comps + compno;
+		if (!j2k_decodes_component(p_cp, compno)) {
+			grk_image_single_component_data_free(comp);
+			continue;
+		}
+		if (numcomps != compno)
+			image->comps[numcomps] = *comp;
+		numcomps++;
+	}
+	image->numcomps = numcomps;
+}
+
+/**
+ Validate component selection against the image read from the main header
+ */
+static bool j2k_check_decode_components(j2k_t *p_j2k, grk_image_t *p_image) {
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	if (!l_dec->m_numcomps_to_decode)
+		return true;
+	uint32_t l_numcomps = p_j2k->m_private_image->numcomps;
+	if (p_image->numcomps != l_numcomps) {
+		GROK_ERROR(
+				"Output image has %d components, but codestream has %d components",
+				p_image->numcomps, l_numcomps);
+		return false;
+	}
+	/* indices are sorted, so the last one is the largest */
+	uint32_t l_max_compno = l_dec->m_comps_to_decode[l_dec->m_numcomps_to_decode
+			- 1];
+	if (l_max_compno >= l_numcomps) {
+		GROK_ERROR(
+				"Invalid component index %d : image only has %d components",
+				l_max_compno, l_numcomps);
+		return false;
+	}
+	return true;
+}
+
 /**
  * Sets up the procedures to do on reading header. Developers wanting to extend the library can add their own reading procedures.
  */
@@ -220,6 +267,38 @@ static bool j2k_exec(j2k_t *p_j2k, std::vector<j2k_procedure> *p_procedure_list,
  */
 static bool j2k_update_rates(j2k_t *p_j2k, GrokStream *p_stream);
 
+/**
+ * Sets the decoder state to the one expected at the start of a codestream.
+ *
+ * @param       p_j2k                   J2K codec.
+ */
+static void j2k_init_decoder_state(j2k_t *p_j2k);
+
+/**
+ * Releases everything read from the previous codestream, so that the decoder
+ * can be bound to a new one. Decoding parameters, the tile processor and
+ * its buffers are kept, to be reused by the next codestream.
+ *
+ * @param       p_j2k                   J2K codec.
+ */
+static void j2k_reset_decompress(j2k_t *p_j2k);
+
+/**
+ * Clears the areas set with j2k_set_decode_areas.
+ *
+ * @param       p_j2k                   J2K codec.
+ */
+static void j2k_clear_decode_areas(j2k_t *p_j2k);
+
+/**
+ * Checks if a tile intersects one of the areas set with j2k_set_decode_areas,
+ * or if there are no such areas.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       tileno                  tile index.
+ */
+static bool j2k_tile_in_decode_areas(j2k_t *p_j2k, uint32_t tileno);
+
 /**
  * Copies the decoding tile parameters onto all the tile parameters.
  * Creates also the tile decoder.
@@ -383,9 +462,22 @@ static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream);
 
 static bool j2k_pre_write_tile(j2k_t *p_j2k, uint32_t tile_index);
 
-static bool j2k_copy_decoded_tile_to_output_image(TileProcessor *p_tcd, uint8_t *p_data,
+static bool j2k_copy_decoded_tile_to_output_image(cp_t *p_cp, TileProcessor *p_tcd, uint8_t *p_data,
 		grk_image_t *p_output_image, bool clearOutputOnInit);
 
+/**
+ * Pass the region of the current decoded tile that overlaps the output image
+ * to the user: either to the decode sink, or to the interleaved output buffer.
+ *
+ * @param p_j2k	J2K codec
+ * @param tile_index	index of decoded tile
+ * @return false if the sink aborted decoding
+ */
+static bool j2k_stream_decoded_tile(j2k_t *p_j2k, uint32_t tile_index);
+
+static void j2k_interleave_decoded_region(j2k_t *p_j2k,
+		grk_decoded_region_t *region);
+
 static void get_tile_dimensions(grk_image_t *l_image, tcd_tilecomp_t *l_tilec,
 		grk_image_comp_t *l_img_comp, uint32_t *l_size_comp, uint32_t *l_width,
 		uint32_t *l_height, uint32_t *l_offset_x, uint32_t *l_offset_y,
@@ -393,6 +485,11 @@ static void get_tile_dimensions(grk_image_t *l_image, tcd_tilecomp_t *l_tilec,
 
 static void j2k_get_tile_data(TileProcessor *p_tcd, uint8_t *p_data);
 
+/**
+ * Fill tile component buffers directly from the 8/16 bit user input buffer
+ */
+static void j2k_copy_input_buffer_to_tile(j2k_t *p_j2k);
+
 static bool j2k_post_write_tile(j2k_t *p_j2k, GrokStream *p_stream);
 
 /**
@@ -3011,10 +3108,14 @@ static bool j2k_read_plm(j2k_t *p_j2k, uint8_t *p_header_data,
  */
 static bool j2k_read_plt(j2k_t *p_j2k, uint8_t *p_header_data,
 		uint16_t header_size) {
-	(void) p_j2k;
 	assert(p_header_data != nullptr);
 	assert(p_j2k != nullptr);
-	
+
+	/* packet lengths let T2 skip unwanted packets without parsing their headers */
+	auto l_tcp = p_j2k->m_cp.tcps + p_j2k->m_current_tile_number;
+	bool l_store = !p_j2k->m_cp.m_specific_param.m_dec.m_layer_refinement;
+	if (l_store && !l_tcp->m_packet_lengths)
+		l_tcp->m_packet_lengths = new std::vector<uint32_t>();
 
 	if (header_size < 1) {
 		GROK_ERROR( "Error reading PLT marker");
@@ -3039,6 +3140,8 @@ static bool j2k_read_plt(j2k_t *p_j2k, uint8_t *p_header_data,
 			l_packet_len <<= 7;
 		} else {
 			/* store packet length and proceed to next packet */
+			if (l_store)
+				l_tcp->m_packet_lengths->push_back(l_packet_len);
 			l_packet_len = 0;
 		}
 	}
@@ -3074,6 +3177,11 @@ static bool j2k_read_ppm(j2k_t *p_j2k, uint8_t *p_header_data,
 	}
 
 	l_cp = &(p_j2k->m_cp);
+	if (l_cp->m_specific_param.m_dec.m_growing_stream) {
+		GROK_ERROR(
+				"PPM marker is not supported when decoding a growing stream");
+		return false;
+	}
 	l_cp->ppm = 1;
 
 	/* Z_ppm */
@@ -3298,6 +3406,11 @@ static bool j2k_read_ppt(j2k_t *p_j2k, uint8_t *p_header_data,
 				"Error reading PPT marker: packet header have been previously found in the main header (PPM marker).");
 		return false;
 	}
+	if (l_cp->m_specific_param.m_dec.m_growing_stream) {
+		GROK_ERROR(
+				"PPT marker is not supported when decoding a growing stream");
+		return false;
+	}
 
 	l_tcp = &(l_cp->tcps[p_j2k->m_current_tile_number]);
 	l_tcp->ppt = 1;
@@ -3655,7 +3768,9 @@ static bool j2k_read_sot(j2k_t *p_j2k, uint8_t *p_header_data,
 				< p_j2k->m_specific_param.m_decoder.m_start_tile_x)
 				|| (l_tile_x >= p_j2k->m_specific_param.m_decoder.m_end_tile_x)
 				|| (l_tile_y < p_j2k->m_specific_param.m_decoder.m_start_tile_y)
-				|| (l_tile_y >= p_j2k->m_specific_param.m_decoder.m_end_tile_y);
+				|| (l_tile_y >= p_j2k->m_specific_param.m_decoder.m_end_tile_y)
+				|| !j2k_tile_in_decode_areas(p_j2k,
+						p_j2k->m_current_tile_number);
 	} else {
 		assert(p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec >= 0);
 		p_j2k->m_specific_param.m_decoder.m_skip_data =
@@ -3795,6 +3910,19 @@ static bool j2k_write_sod(j2k_t *p_j2k, TileProcessor *p_tile_coder,
 	return true;
 }
 
+/**
+ * Growing stream: a last tile-part whose length is not signalled (Psot == 0)
+ * runs up to the EOC marker. Packet data never contains 0xFFD9, so tile data
+ * that ends with it holds the complete tile-part, followed by EOC.
+ */
+static bool j2k_tile_data_ends_with_eoc(seg_buf_t *p_tile_data) {
+	if (p_tile_data->segments.empty())
+		return false;
+	auto l_seg = p_tile_data->segments.back();
+	return l_seg->len >= 2 && l_seg->buf[l_seg->len - 2] == 0xFF
+			&& l_seg->buf[l_seg->len - 1] == 0xD9;
+}
+
 static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 	assert(p_j2k != nullptr);
 	
@@ -3802,9 +3930,18 @@ static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 
 	// note: we subtract 2 to account for SOD marker
 	tcp_t *l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+	bool l_growing = p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream;
+	uint64_t l_missing = 0;
 	if (p_j2k->m_specific_param.m_decoder.m_last_tile_part) {
-		p_j2k->m_specific_param.m_decoder.tile_part_data_length =
-				(uint64_t) (p_stream->get_number_byte_left() - 2);
+		if (l_growing) {
+			/* tile-part runs to the end of the stream, which is still growing */
+			p_j2k->m_specific_param.m_decoder.tile_part_data_length =
+					(uint64_t) p_stream->get_number_byte_left();
+			l_missing = UINT64_MAX;
+		} else {
+			p_j2k->m_specific_param.m_decoder.tile_part_data_length =
+					(uint64_t) (p_stream->get_number_byte_left() - 2);
+		}
 	} else {
 		if (p_j2k->m_specific_param.m_decoder.tile_part_data_length >= 2)
 			p_j2k->m_specific_param.m_decoder.tile_part_data_length -= 2;
@@ -3814,10 +3951,15 @@ static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 		// check that there are enough bytes in stream to fill tile data
 		if ((int64_t) p_j2k->m_specific_param.m_decoder.tile_part_data_length
 				> bytesLeftInStream) {
-			GROK_WARN(
-					"Tile part length size %lld inconsistent with stream length %lld\n",
-					p_j2k->m_specific_param.m_decoder.tile_part_data_length,
-					p_stream->get_number_byte_left());
+			if (l_growing)
+				l_missing =
+						p_j2k->m_specific_param.m_decoder.tile_part_data_length
+								- (uint64_t) bytesLeftInStream;
+			else
+				GROK_WARN(
+						"Tile part length size %lld inconsistent with stream length %lld\n",
+						p_j2k->m_specific_param.m_decoder.tile_part_data_length,
+						p_stream->get_number_byte_left());
 
 			// sanitize tile_part_data_length
 			p_j2k->m_specific_param.m_decoder.tile_part_data_length =
@@ -3852,6 +3994,14 @@ static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 	}
 	size_t l_current_read_size = 0;
 	if (p_j2k->m_specific_param.m_decoder.tile_part_data_length) {
+		if (!l_tcp->m_tile_data && l_tcp->m_refinement
+				&& l_tcp->m_refinement->tile_data) {
+			/* tile has already been decoded from its earlier tile-parts:
+			 * add this tile-part to the retained data */
+			l_tcp->m_tile_data = l_tcp->m_refinement->tile_data;
+			l_tcp->m_refinement->tile_data = nullptr;
+			l_tcp->m_tile_data->rewind();
+		}
 		if (!l_tcp->m_tile_data)
 			l_tcp->m_tile_data = new seg_buf_t();
 
@@ -3871,6 +4021,16 @@ static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 		}
 		l_current_read_size = p_stream->read(zeroCopy ? nullptr : buff, len);
 		l_tcp->m_tile_data->add_segment(buff, len, !zeroCopy);
+		if (l_missing == UINT64_MAX && l_current_read_size == len
+				&& j2k_tile_data_ends_with_eoc(l_tcp->m_tile_data)) {
+			/* tile-part is complete: EOC is read as the next marker */
+			if (!l_tcp->m_tile_data->trim_last_segment(2)
+					|| !p_stream->seek((uint64_t) p_stream->tell() - 2))
+				return false;
+			p_j2k->m_specific_param.m_decoder.tile_part_data_length -= 2;
+			l_current_read_size -= 2;
+			l_missing = 0;
+		}
 
 	}
 	if (l_current_read_size
@@ -3879,6 +4039,23 @@ static bool j2k_read_sod(j2k_t *p_j2k, GrokStream *p_stream) {
 	} else {
 		p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_TPHSOT;
 	}
+	if (l_growing) {
+		if (!l_tcp->m_refinement)
+			l_tcp->m_refinement = new layer_refinement_t();
+		l_tcp->m_refinement->truncated = l_missing != 0;
+		if (l_missing) {
+			/* rest of the tile-part is read when more data arrives */
+			p_j2k->m_specific_param.m_decoder.m_truncated_tile =
+					(int32_t) p_j2k->m_current_tile_number;
+			p_j2k->m_specific_param.m_decoder.m_truncated_bytes = l_missing;
+			p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_NEOC;
+		} else {
+			/* next tile-part starts here */
+			p_j2k->m_specific_param.m_decoder.m_truncated_tile = -1;
+			p_j2k->m_specific_param.m_decoder.m_resume_pos = p_stream->tell();
+			p_j2k->m_specific_param.m_decoder.m_resume_tile = -1;
+		}
+	}
 	return true;
 }
 
@@ -5162,7 +5339,49 @@ void j2k_setup_decoder(void *j2k_void, grk_dparameters_t *parameters) {
 	j2k_t *j2k = (j2k_t*) j2k_void;
 	if (j2k && parameters) {
 		j2k->m_cp.m_specific_param.m_dec.m_layer = parameters->cp_layer;
-		j2k->m_cp.m_specific_param.m_dec.m_reduce = parameters->cp_reduce;
+		j2k->m_cp.m_specific_param.m_dec.m_reduce =
+				parameters->thumbnail ? 0 : parameters->cp_reduce;
+		j2k->m_cp.m_specific_param.m_dec.m_thumbnail = parameters->thumbnail;
+		j2k->m_cp.m_specific_param.m_dec.m_sink = parameters->sink;
+		j2k->m_cp.m_specific_param.m_dec.m_sink_user_data =
+				parameters->sink_user_data;
+		j2k->m_cp.m_specific_param.m_dec.m_max_tile_memory =
+				parameters->max_tile_memory;
+		j2k->m_cp.m_specific_param.m_dec.m_interleaved_buffer =
+				(uint8_t*) parameters->interleaved_buffer;
+		j2k->m_cp.m_specific_param.m_dec.m_interleaved_buffer_len =
+				parameters->interleaved_buffer_len;
+		j2k->m_cp.m_specific_param.m_dec.m_interleaved_stride =
+				parameters->interleaved_stride;
+		j2k->m_cp.m_specific_param.m_dec.m_interleaved_prec =
+				parameters->interleaved_prec;
+		j2k->m_cp.m_specific_param.m_dec.m_growing_stream =
+				parameters->growing_stream;
+		/* a growing stream retains tile data, as for layer refinement */
+		j2k->m_cp.m_specific_param.m_dec.m_layer_refinement =
+				parameters->layer_refinement || parameters->growing_stream;
+		/* a selection from an earlier call is replaced, or cleared if there is none */
+		auto l_dec = &j2k->m_cp.m_specific_param.m_dec;
+		grok_free(l_dec->m_comps_to_decode);
+		l_dec->m_comps_to_decode = nullptr;
+		l_dec->m_numcomps_to_decode = 0;
+		l_dec->m_comps_to_decode_used = false;
+		if (parameters->numcomps_to_decode && parameters->comps_to_decode) {
+			l_dec->m_comps_to_decode = (uint32_t*) grok_malloc(
+					parameters->numcomps_to_decode * sizeof(uint32_t));
+			if (!l_dec->m_comps_to_decode) {
+				GROK_ERROR(
+						"Not enough memory to store components to decode; all components will be decoded");
+				return;
+			}
+			memcpy(l_dec->m_comps_to_decode, parameters->comps_to_decode,
+					parameters->numcomps_to_decode * sizeof(uint32_t));
+			auto l_begin = l_dec->m_comps_to_decode;
+			auto l_end = l_begin + parameters->numcomps_to_decode;
+			std::sort(l_begin, l_end);
+			l_dec->m_numcomps_to_decode = (uint32_t) (std::unique(l_begin,
+					l_end) - l_begin);
+		}
 	}
 }
 
@@ -5444,6 +5663,40 @@ bool j2k_setup_encoder(j2k_t *p_j2k, grk_cparameters_t *parameters,
 		}
 	}
 
+	if (parameters->input_buffer) {
+		uint32_t bytes_per_sample = parameters->input_prec >> 3;
+		if (parameters->input_prec != 8 && parameters->input_prec != 16) {
+			GROK_ERROR(
+					"Input buffer precision %d must be either 8 or 16",
+					parameters->input_prec);
+			return false;
+		}
+		uint64_t min_stride = (uint64_t) (image->x1 - image->x0)
+				* bytes_per_sample;
+		if (parameters->input_interleaved)
+			min_stride *= image->numcomps;
+		if (parameters->input_stride < min_stride) {
+			GROK_ERROR("Input buffer stride %llu is less than %llu",
+					(unsigned long long) parameters->input_stride,
+					(unsigned long long) min_stride);
+			return false;
+		}
+		for (i = 0; i < image->numcomps; ++i) {
+			auto comp = image->comps + i;
+			if (comp->dx != 1 || comp->dy != 1) {
+				GROK_ERROR(
+						"Input buffer does not support sub-sampled components");
+				return false;
+			}
+			if (comp->prec > parameters->input_prec) {
+				GROK_ERROR(
+						"Component %d precision %d exceeds input buffer precision %d",
+						i, comp->prec, parameters->input_prec);
+				return false;
+			}
+		}
+	}
+
 	if ((parameters->numresolution == 0)
 			|| (parameters->numresolution > GRK_J2K_MAXRLVLS)) {
 		GROK_ERROR(
@@ -5616,6 +5869,13 @@ bool j2k_setup_encoder(j2k_t *p_j2k, grk_cparameters_t *parameters,
 			& 1u;
 	cp->m_specific_param.m_enc.rateControlAlgorithm =
 			parameters->rateControlAlgorithm;
+	cp->m_specific_param.m_enc.m_code_all_passes = parameters->code_all_passes;
+	cp->m_specific_param.m_enc.m_input_buffer =
+			(uint8_t*) parameters->input_buffer;
+	cp->m_specific_param.m_enc.m_input_stride = parameters->input_stride;
+	cp->m_specific_param.m_enc.m_input_prec = parameters->input_prec;
+	cp->m_specific_param.m_enc.m_input_interleaved =
+			parameters->input_interleaved;
 
 	/* tiles */
 	cp->tdx = parameters->cp_tdx;
@@ -6013,12 +6273,80 @@ bool j2k_end_decompress(j2k_t *p_j2k, GrokStream *p_stream) {
 	return true;
 }
 
+static void j2k_init_decoder_state(j2k_t *p_j2k) {
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+
+	l_decoder->m_state = J2K_DEC_STATE_NONE;
+	l_decoder->tile_part_data_length = 0;
+	l_decoder->m_start_tile_x = 0;
+	l_decoder->m_start_tile_y = 0;
+	l_decoder->m_end_tile_x = 0;
+	l_decoder->m_end_tile_y = 0;
+	l_decoder->m_tile_ind_to_dec = -1;
+	l_decoder->m_last_sot_read_pos = 0;
+	l_decoder->m_last_tile_part = false;
+	l_decoder->ready_to_decode_tile_part_data = 0;
+	l_decoder->m_discard_tiles = 0;
+	l_decoder->m_skip_data = 0;
+#ifdef GRK_DISABLE_TPSOT_FIX
+	l_decoder->m_nb_tile_parts_correction_checked = 1;
+#else
+	l_decoder->m_nb_tile_parts_correction_checked = 0;
+#endif
+	l_decoder->m_nb_tile_parts_correction = 0;
+	l_decoder->m_resume_pos = 0;
+	l_decoder->m_resume_tile = -1;
+	l_decoder->m_truncated_tile = -1;
+	l_decoder->m_truncated_bytes = 0;
+}
+
+static void j2k_reset_decompress(j2k_t *p_j2k) {
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+
+	/* coding parameters belong to the codestream, decoding parameters to the user */
+	auto l_dec = p_j2k->m_cp.m_specific_param.m_dec;
+	j2k_cp_destroy(&p_j2k->m_cp);
+	memset(&p_j2k->m_cp, 0, sizeof(cp_t));
+	/* except for a component selection, which belongs to the previous codestream
+	 unless the decoder was set up again since */
+	if (l_dec.m_comps_to_decode_used) {
+		grok_free(l_dec.m_comps_to_decode);
+		l_dec.m_comps_to_decode = nullptr;
+		l_dec.m_numcomps_to_decode = 0;
+	}
+	p_j2k->m_cp.m_specific_param.m_dec = l_dec;
+	p_j2k->m_cp.m_is_decoder = 1;
+
+	j2k_tcp_destroy(l_decoder->m_default_tcp);
+	delete l_decoder->m_default_tcp;
+	l_decoder->m_default_tcp = new tcp_t();
+
+	j2k_destroy_cstr_index(p_j2k->cstr_index);
+	p_j2k->cstr_index = j2k_create_cstr_index();
+
+	grk_image_destroy(p_j2k->m_private_image);
+	p_j2k->m_private_image = nullptr;
+	grk_image_destroy(p_j2k->m_output_image);
+	p_j2k->m_output_image = nullptr;
+	j2k_clear_decode_areas(p_j2k);
+
+	p_j2k->m_procedure_list->clear();
+	p_j2k->m_validation_list->clear();
+	p_j2k->m_current_tile_number = 0;
+
+	j2k_init_decoder_state(p_j2k);
+}
+
 bool j2k_read_header(GrokStream *p_stream, j2k_t *p_j2k,
 		grk_header_info_t *header_info, grk_image_t **p_image) {
 
 	assert(p_j2k != nullptr);
 	assert(p_stream != nullptr);
 	
+	/* the decoder has already read a codestream: rebind it to this one */
+	if (p_j2k->m_specific_param.m_decoder.m_state != J2K_DEC_STATE_NONE)
+		j2k_reset_decompress(p_j2k);
+	p_j2k->m_cp.m_specific_param.m_dec.m_comps_to_decode_used = true;
 
 	/* create an empty image header */
 	p_j2k->m_private_image = grk_image_create0();
@@ -6591,6 +6919,21 @@ static bool j2k_read_header_procedure(j2k_t *p_j2k, GrokStream *p_stream) {
 		GROK_ERROR( "Failed to merge PPM data");
 		return false;
 	}
+	/* thumbnail: discard all resolutions above the lowest one common to all components.
+	 * Tile setup still builds precincts and code-blocks for every resolution,
+	 * since higher resolution packet headers may have to be parsed to be skipped */
+	if (p_j2k->m_cp.m_specific_param.m_dec.m_thumbnail) {
+		auto l_image = p_j2k->m_private_image;
+		auto l_tccps = p_j2k->m_specific_param.m_decoder.m_default_tcp->tccps;
+		uint32_t l_reduce = l_tccps[0].numresolutions - 1;
+		for (uint32_t i = 1; i < l_image->numcomps; ++i)
+			l_reduce = std::min<uint32_t>(l_reduce,
+					l_tccps[i].numresolutions - 1);
+		p_j2k->m_cp.m_specific_param.m_dec.m_reduce = l_reduce;
+		for (uint32_t i = 0; i < l_image->numcomps; ++i)
+			l_image->comps[i].decodeScaleFactor = l_reduce;
+		grk_image_comp_header_update(l_image, &p_j2k->m_cp);
+	}
 	// event_msg( EVT_INFO, "Main header has been correctly decoded.");
 	if (p_j2k->cstr_index) {
 		/* Position of the last element if the main header */
@@ -6755,6 +7098,18 @@ static bool j2k_copy_default_tcp_and_create_tcd(j2k_t *p_j2k,
 		++l_tcp;
 	}
 
+	/* A tile decoder left by the previous codestream is reused, along with
+	 * the memory it holds, if the number of components is unchanged */
+	if (p_j2k->m_tcd) {
+		if (p_j2k->m_tcd->tile
+				&& p_j2k->m_tcd->tile->numcomps == l_image->numcomps) {
+			p_j2k->m_tcd->image = l_image;
+			return true;
+		}
+		delete p_j2k->m_tcd;
+		p_j2k->m_tcd = nullptr;
+	}
+
 	/* Create the current tile decoder*/
 	p_j2k->m_tcd = new TileProcessor(true);
 
@@ -6797,6 +7152,12 @@ void j2k_destroy(j2k_t *p_j2k) {
 			p_j2k->m_specific_param.m_decoder.m_header_data = nullptr;
 			p_j2k->m_specific_param.m_decoder.m_header_data_size = 0;
 		}
+		grok_free(p_j2k->m_specific_param.m_decoder.m_tile_data);
+		p_j2k->m_specific_param.m_decoder.m_tile_data = nullptr;
+		p_j2k->m_specific_param.m_decoder.m_tile_data_size = 0;
+		grok_free(p_j2k->m_cp.m_specific_param.m_dec.m_comps_to_decode);
+		p_j2k->m_cp.m_specific_param.m_dec.m_comps_to_decode = nullptr;
+		j2k_clear_decode_areas(p_j2k);
 	} else {
 
 		if (p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
@@ -6938,11 +7299,15 @@ static void j2k_tcp_destroy(tcp_t *p_tcp) {
 
 	j2k_tcp_data_destroy(p_tcp);
 
+	delete p_tcp->m_refinement;
+	p_tcp->m_refinement = nullptr;
 }
 
 static void j2k_tcp_data_destroy(tcp_t *p_tcp) {
 	delete p_tcp->m_tile_data;
 	p_tcp->m_tile_data = nullptr;
+	delete p_tcp->m_packet_lengths;
+	p_tcp->m_packet_lengths = nullptr;
 }
 
 static void j2k_cp_destroy(cp_t *p_cp) {
@@ -7091,6 +7456,31 @@ static bool j2k_need_nb_tile_parts_correction(GrokStream *p_stream,
 	return true;
 }
 
+/**
+ * Report a stream that ends before the end of a marker segment. This is expected,
+ * and not an error, while decoding a growing stream.
+ */
+static void j2k_stream_too_short(j2k_t *p_j2k) {
+	if (!p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream)
+		GROK_ERROR( "Stream too short");
+}
+
+/**
+ * Growing stream: the available data ends inside a tile-part header.
+ * Forget the partially read tile-part, so that it is read again from
+ * its SOT marker when more data arrives.
+ */
+static void j2k_wait_for_data(j2k_t *p_j2k) {
+	auto l_dec = &p_j2k->m_specific_param.m_decoder;
+	if (l_dec->m_resume_tile >= 0) {
+		--p_j2k->m_cp.tcps[l_dec->m_resume_tile].m_current_tile_part_number;
+		l_dec->m_resume_tile = -1;
+	}
+	l_dec->ready_to_decode_tile_part_data = 0;
+	l_dec->m_skip_data = 0;
+	l_dec->m_state = J2K_DEC_STATE_NEOC;
+}
+
 bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 		uint64_t *data_size, uint32_t *p_tile_x0, uint32_t *p_tile_y0,
 		uint32_t *p_tile_x1, uint32_t *p_tile_y1, uint32_t *p_nb_comps,
@@ -7099,6 +7489,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 	uint32_t l_marker_size;
 	const grk_dec_memory_marker_handler_t *l_marker_handler = nullptr;
 	tcp_t *l_tcp = nullptr;
+	bool l_growing = p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream;
 
 	assert(p_stream != nullptr);
 	assert(p_j2k != nullptr);
@@ -7121,7 +7512,18 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 		/* Try to read until the Start Of Data is detected */
 		while (l_current_marker != J2K_MS_SOD) {
 
+			/* remember where the tile-part starts, so that reading
+			 * can resume there when more data arrives */
+			if (l_growing && l_current_marker == J2K_MS_SOT) {
+				p_j2k->m_specific_param.m_decoder.m_resume_pos =
+						p_stream->tell() - 2;
+				p_j2k->m_specific_param.m_decoder.m_resume_tile = -1;
+			}
+
 			if (p_stream->get_number_byte_left() == 0) {
+				/* wait for the rest of the tile-part header */
+				if (l_growing)
+					return false;
 				p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_NEOC;
 				break;
 			}
@@ -7129,7 +7531,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 			/* Try to read 2 bytes (the marker size) from stream and copy them into the buffer */
 			if (p_stream->read(p_j2k->m_specific_param.m_decoder.m_header_data,
 					2) != 2) {
-				GROK_ERROR( "Stream too short");
+				j2k_stream_too_short(p_j2k);
 				return false;
 			}
 
@@ -7171,8 +7573,9 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 				/* Check enough bytes left in stream before allocation */
 				if ((int64_t) l_marker_size
 						> p_stream->get_number_byte_left()) {
-					GROK_ERROR(
-							"Marker size inconsistent with stream length");
+					if (!l_growing)
+						GROK_ERROR(
+								"Marker size inconsistent with stream length");
 					return false;
 				}
 				new_header_data = (uint8_t*) grok_realloc(
@@ -7195,7 +7598,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 			/* Try to read the rest of the marker segment from stream and copy them into the buffer */
 			if (p_stream->read(p_j2k->m_specific_param.m_decoder.m_header_data,
 					l_marker_size) != l_marker_size) {
-				GROK_ERROR( "Stream too short");
+				j2k_stream_too_short(p_j2k);
 				return false;
 			}
 
@@ -7230,6 +7633,9 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 
 			// Cache position of last SOT marker read
 			if (l_marker_handler->id == J2K_MS_SOT) {
+				if (l_growing)
+					p_j2k->m_specific_param.m_decoder.m_resume_tile =
+							(int32_t) p_j2k->m_current_tile_number;
 				uint32_t sot_pos = (uint32_t) p_stream->tell() - l_marker_size
 						- 4;
 				if (sot_pos
@@ -7243,7 +7649,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 				// Skip the rest of the tile part header
 				if (!p_stream->skip(
 						p_j2k->m_specific_param.m_decoder.tile_part_data_length)) {
-					GROK_ERROR( "Stream too short");
+					j2k_stream_too_short(p_j2k);
 					return false;
 				}
 				l_current_marker = J2K_MS_SOD; //We force current marker to equal SOD
@@ -7251,7 +7657,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 				// Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer
 				if (p_stream->read(
 						p_j2k->m_specific_param.m_decoder.m_header_data, 2) != 2) {
-					GROK_ERROR( "Stream too short");
+					j2k_stream_too_short(p_j2k);
 					return false;
 				}
 				// Read 2 bytes from the buffer as the new marker ID
@@ -7268,10 +7674,17 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 
 		/* If we didn't skip data before, we need to read the SOD marker*/
 		if (!p_j2k->m_specific_param.m_decoder.m_skip_data) {
+			/* wait until some tile-part data has arrived */
+			if (l_growing && p_stream->get_number_byte_left() == 0)
+				return false;
 			/* Try to read the SOD marker and skip data ? FIXME */
 			if (!j2k_read_sod(p_j2k, p_stream)) {
 				return false;
 			}
+			/* end of available data: decode what we have of this tile */
+			if (l_growing
+					&& p_j2k->m_specific_param.m_decoder.m_truncated_tile >= 0)
+				break;
 			if (p_j2k->m_specific_param.m_decoder.ready_to_decode_tile_part_data
 					&& !p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction_checked) {
 				/* Issue 254 */
@@ -7306,7 +7719,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 				/* Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer */
 				if (p_stream->read(
 						p_j2k->m_specific_param.m_decoder.m_header_data, 2) != 2) {
-					GROK_ERROR( "Stream too short");
+					j2k_stream_too_short(p_j2k);
 					return false;
 				}
 
@@ -7324,7 +7737,7 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 			/* Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer */
 			if (p_stream->read(p_j2k->m_specific_param.m_decoder.m_header_data,
 					2) != 2) {
-				GROK_ERROR( "Stream too short");
+				j2k_stream_too_short(p_j2k);
 				return false;
 			}
 			/* Read 2 bytes from buffer as the new marker ID */
@@ -7425,7 +7838,9 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 		return false;
 	}
 	if (!p_j2k->m_tcd->init_decode_tile( p_j2k->m_output_image,
-			p_j2k->m_current_tile_number)) {
+			p_j2k->m_current_tile_number,
+			p_j2k->m_specific_param.m_decoder.m_decode_areas,
+			p_j2k->m_specific_param.m_decoder.m_num_decode_areas)) {
 		GROK_ERROR( "Cannot decode tile %d\n",
 				p_j2k->m_current_tile_number);
 		return false;
@@ -7463,6 +7878,37 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
 		return false;
 	}
 
+	auto l_max_tile_memory =
+			p_j2k->m_cp.m_specific_param.m_dec.m_max_tile_memory;
+	if (l_max_tile_memory) {
+		uint64_t l_tile_memory = 0;
+		for (uint32_t compno = 0; compno < p_j2k->m_tcd->tile->numcomps;
+				++compno) {
+			auto l_tilec = p_j2k->m_tcd->tile->comps + compno;
+			if (!l_tilec->skip_decode)
+				l_tile_memory += l_tilec->buf->data_size_needed;
+		}
+		if (l_tile_memory > l_max_tile_memory) {
+			GROK_ERROR(
+					"Tile %d needs %llu bytes of decoded data, which exceeds the per-tile limit of %llu bytes",
+					tile_index, (unsigned long long)l_tile_memory,
+					(unsigned long long)l_max_tile_memory);
+			j2k_tcp_destroy(l_tcp);
+			return false;
+		}
+	}
+
+	/* remember packed packet headers before T2 consumes them */
+	if (p_j2k->m_cp.m_specific_param.m_dec.m_layer_refinement) {
+		if (!l_tcp->m_refinement)
+			l_tcp->m_refinement = new layer_refinement_t();
+		auto l_refinement = l_tcp->m_refinement;
+		l_refinement->ppm_data = p_j2k->m_cp.ppm_data;
+		l_refinement->ppm_len = p_j2k->m_cp.ppm_len;
+		l_refinement->ppt_data = l_tcp->ppt_data;
+		l_refinement->ppt_len = l_tcp->ppt_len;
+	}
+
 	if (!p_j2k->m_tcd->decode_tile(l_tcp->m_tile_data, tile_index)) {
 		j2k_tcp_destroy(l_tcp);
 		p_j2k->m_specific_param.m_decoder.m_state |= J2K_DEC_STATE_ERR;
@@ -7477,7 +7923,13 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
 		/* if p_data is not null, then copy decoded resolutions from tile data into p_data.
 		 Otherwise, simply copy tile data pointer to output image
 		 */
-		if (p_data) {
+		if (j2k_decodes_to_user(p_j2k)) {
+			if (!j2k_stream_decoded_tile(p_j2k, tile_index)) {
+				GROK_ERROR("Decode sink aborted decoding of tile %d",
+						tile_index);
+				return false;
+			}
+		} else if (p_data) {
 			if (!p_j2k->m_tcd->update_tile_data(p_data, data_size)) {
 				return false;
 			}
@@ -7490,6 +7942,8 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
 				uint32_t i, j;
 				tcd_tilecomp_t *tilec = p_j2k->m_tcd->tile->comps + compno;
 				grk_image_comp_t *comp = p_j2k->m_output_image->comps + compno;
+				if (!j2k_decodes_component(&p_j2k->m_cp, compno))
+					continue;
 
 				//transfer memory from tile component to output image
 				comp->data = tile_buf_get_ptr(tilec->buf, 0, 0, 0, 0);
@@ -7526,8 +7980,17 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
 			}
 		}
 
-		/* we only destroy the data, which will be re-read in read_tile_header*/
-		j2k_tcp_data_destroy(l_tcp);
+		if (l_tcp->m_refinement) {
+			/* keep compressed data for later layer refinement */
+			auto l_refinement = l_tcp->m_refinement;
+			delete l_refinement->tile_data;
+			l_refinement->tile_data = l_tcp->m_tile_data;
+			l_refinement->num_layers_decoded = l_tcp->num_layers_to_decode;
+			l_tcp->m_tile_data = nullptr;
+		} else {
+			/* we only destroy the data, which will be re-read in read_tile_header*/
+			j2k_tcp_data_destroy(l_tcp);
+		}
 
 		p_j2k->m_specific_param.m_decoder.ready_to_decode_tile_part_data = 0;
 		p_j2k->m_specific_param.m_decoder.m_state &= (~(J2K_DEC_STATE_DATA));
@@ -7542,8 +8005,14 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
 		// if EOC marker has not been read yet, then try to read the next marker (should be EOC or SOT)
 		if (p_j2k->m_specific_param.m_decoder.m_state != J2K_DEC_STATE_EOC) {
 
-			// not enough data for another marker : fail decode
+			// not enough data for another marker : fail decode,
+			// unless the stream is still growing
 			if (p_stream->read(l_data, 2) != 2) {
+				if (p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream) {
+					p_j2k->m_specific_param.m_decoder.m_state =
+							J2K_DEC_STATE_NEOC;
+					return true;
+				}
 				GROK_ERROR( "Stream too short");
 				return false;
 			}
@@ -7585,7 +8054,7 @@ bool j2k_decode_tile(j2k_t *p_j2k, uint32_t tile_index, uint8_t *p_data,
  This method copies a sub-region of this region into p_output_image (which stores data in 32 bit precision)
 
  */
-static bool j2k_copy_decoded_tile_to_output_image(TileProcessor *p_tcd, uint8_t *p_data,
+static bool j2k_copy_decoded_tile_to_output_image(cp_t *p_cp, TileProcessor *p_tcd, uint8_t *p_data,
 		grk_image_t *p_output_image, bool clearOutputOnInit) {
 	uint32_t i = 0, j = 0, k = 0;
 	grk_image_t *image_src = p_tcd->image;
@@ -7595,6 +8064,8 @@ static bool j2k_copy_decoded_tile_to_output_image(TileProcessor *p_tcd, uint8_t
 		tcd_tilecomp_t *tilec = p_tcd->tile->comps + i;
 		grk_image_comp_t *img_comp_src = image_src->comps + i;
 		grk_image_comp_t *img_comp_dest = p_output_image->comps + i;
+		if (!j2k_decodes_component(p_cp, i))
+			continue;
 
 		if (img_comp_dest->w * img_comp_dest->h == 0) {
 			GROK_ERROR(
@@ -7852,6 +8323,8 @@ bool j2k_set_decode_area(j2k_t *p_j2k, grk_image_t *p_image, uint32_t start_x,
 				"Need to decode the main header before setting decode area");
 		return false;
 	}
+	/* areas only apply to the decode area they were set for */
+	j2k_clear_decode_areas(p_j2k);
 
 	if (!start_x && !start_y && !end_x && !end_y) {
 		//event_msg( EVT_INFO, "No decoded area parameters, set the decoded area to the whole image");
@@ -7996,6 +8469,57 @@ bool j2k_set_decode_area(j2k_t *p_j2k, grk_image_t *p_image, uint32_t start_x,
 	return true;
 }
 
+static void j2k_clear_decode_areas(j2k_t *p_j2k) {
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+	grok_free(l_decoder->m_decode_areas);
+	l_decoder->m_decode_areas = nullptr;
+	l_decoder->m_num_decode_areas = 0;
+}
+
+bool j2k_set_decode_areas(j2k_t *p_j2k, const grk_decode_area_t *areas,
+		uint32_t num_areas) {
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+	j2k_clear_decode_areas(p_j2k);
+	if (!areas || !num_areas)
+		return true;
+	l_decoder->m_decode_areas = (grk_decode_area_t*) grok_malloc(
+			num_areas * sizeof(grk_decode_area_t));
+	if (!l_decoder->m_decode_areas) {
+		GROK_ERROR("Not enough memory to set decode areas");
+		return false;
+	}
+	memcpy(l_decoder->m_decode_areas, areas,
+			num_areas * sizeof(grk_decode_area_t));
+	l_decoder->m_num_decode_areas = num_areas;
+	return true;
+}
+
+static bool j2k_tile_in_decode_areas(j2k_t *p_j2k, uint32_t tileno) {
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+	if (!l_decoder->m_num_decode_areas)
+		return true;
+	auto l_cp = &p_j2k->m_cp;
+	auto l_image = p_j2k->m_private_image;
+	uint32_t l_tile_x = tileno % l_cp->tw;
+	uint32_t l_tile_y = tileno / l_cp->tw;
+	rect_t l_tile_rect = rect_t(
+			std::max<uint32_t>(l_cp->tx0 + l_tile_x * l_cp->tdx, l_image->x0),
+			std::max<uint32_t>(l_cp->ty0 + l_tile_y * l_cp->tdy, l_image->y0),
+			std::min<uint32_t>(l_cp->tx0 + (l_tile_x + 1) * l_cp->tdx,
+					l_image->x1),
+			std::min<uint32_t>(l_cp->ty0 + (l_tile_y + 1) * l_cp->tdy,
+					l_image->y1));
+	for (uint32_t i = 0; i < l_decoder->m_num_decode_areas; ++i) {
+		auto l_area = l_decoder->m_decode_areas + i;
+		rect_t l_area_rect = rect_t(l_area->x0, l_area->y0, l_area->x1,
+				l_area->y1);
+		if (l_tile_rect.clip(&l_area_rect, &l_area_rect)
+				&& l_area_rect.is_non_degenerate())
+			return true;
+	}
+	return false;
+}
+
 j2k_t* j2k_create_decompress(void) {
 	j2k_t *l_j2k = (j2k_t*) grok_calloc(1, sizeof(j2k_t));
 	if (!l_j2k) {
@@ -8005,10 +8529,6 @@ j2k_t* j2k_create_decompress(void) {
 	l_j2k->m_is_decoder = 1;
 	l_j2k->m_cp.m_is_decoder = 1;
 
-#ifdef GRK_DISABLE_TPSOT_FIX
-    l_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction_checked = 1;
-#endif
-
 	l_j2k->m_specific_param.m_decoder.m_default_tcp = new tcp_t();
 	if (!l_j2k->m_specific_param.m_decoder.m_default_tcp) {
 		j2k_destroy(l_j2k);
@@ -8024,9 +8544,7 @@ j2k_t* j2k_create_decompress(void) {
 
 	l_j2k->m_specific_param.m_decoder.m_header_data_size = default_header_size;
 
-	l_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = -1;
-
-	l_j2k->m_specific_param.m_decoder.m_last_sot_read_pos = 0;
+	j2k_init_decoder_state(l_j2k);
 
 	/* codestream index creation */
 	l_j2k->cstr_index = j2k_create_cstr_index();
@@ -9094,35 +9612,279 @@ static bool j2k_needs_copy_tile_data(j2k_t *p_j2k, uint32_t num_tiles) {
 	return copy_tile_data;
 }
 
+static bool j2k_stream_decoded_tile(j2k_t *p_j2k, uint32_t tile_index) {
+	auto l_tcd = p_j2k->m_tcd;
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	std::vector<grk_decoded_region_comp_t> l_comps;
+	bool l_empty = true;
+
+	for (uint32_t compno = 0; compno < p_j2k->m_output_image->numcomps;
+			++compno) {
+		if (!j2k_decodes_component(&p_j2k->m_cp, compno))
+			continue;
+		tcd_tilecomp_t *tilec = l_tcd->tile->comps + compno;
+		grk_image_comp_t *img_comp_src = l_tcd->image->comps + compno;
+		grk_image_comp_t *img_comp_dest = p_j2k->m_output_image->comps
+				+ compno;
+		tcd_resolution_t *res = tilec->resolutions
+				+ img_comp_src->resno_decoded;
+		l_comps.emplace_back();
+		auto region = &l_comps.back();
+		memset(region, 0, sizeof(grk_decoded_region_comp_t));
+		region->prec = img_comp_dest->prec;
+		region->sgnd = img_comp_dest->sgnd;
+		region->stride = tilec->x1 - tilec->x0;
+
+		/* intersect decoded resolution with output component window */
+		uint32_t x0_dest = uint_ceildivpow2(img_comp_dest->x0,
+				img_comp_dest->decodeScaleFactor);
+		uint32_t y0_dest = uint_ceildivpow2(img_comp_dest->y0,
+				img_comp_dest->decodeScaleFactor);
+		uint32_t x0 = std::max<uint32_t>(res->x0, x0_dest);
+		uint32_t y0 = std::max<uint32_t>(res->y0, y0_dest);
+		uint32_t x1 = std::min<uint32_t>(res->x1, x0_dest + img_comp_dest->w);
+		uint32_t y1 = std::min<uint32_t>(res->y1, y0_dest + img_comp_dest->h);
+		if (x1 <= x0 || y1 <= y0)
+			continue;
+		l_empty = false;
+		region->x0 = x0 - x0_dest;
+		region->y0 = y0 - y0_dest;
+		region->w = x1 - x0;
+		region->h = y1 - y0;
+		region->data = tile_buf_get_ptr(tilec->buf, 0, 0, 0, 0)
+				+ (x0 - res->x0) + (uint64_t) (y0 - res->y0) * region->stride;
+	}
+	if (l_empty)
+		return true;
+
+	grk_decoded_region_t l_region;
+	l_region.tile_index = tile_index;
+	l_region.numcomps = (uint32_t) l_comps.size();
+	l_region.comps = l_comps.data();
+
+	if (l_dec->m_interleaved_buffer) {
+		j2k_interleave_decoded_region(p_j2k, &l_region);
+		return true;
+	}
+	return l_dec->m_sink(&l_region, l_dec->m_sink_user_data);
+}
+
+bool j2k_decodes_to_user(j2k_t *p_j2k) {
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	return l_dec->m_sink || l_dec->m_interleaved_buffer;
+}
+
+bool j2k_decodes_component_subset(j2k_t *p_j2k) {
+	return p_j2k->m_cp.m_specific_param.m_dec.m_numcomps_to_decode != 0;
+}
+
+bool j2k_decodes_component(cp_t *p_cp, uint32_t compno) {
+	auto l_dec = &p_cp->m_specific_param.m_dec;
+	if (!l_dec->m_numcomps_to_decode)
+		return true;
+	return std::binary_search(l_dec->m_comps_to_decode,
+			l_dec->m_comps_to_decode + l_dec->m_numcomps_to_decode, compno);
+}
+
+template<typename T> static void j2k_interleave(grk_decoded_region_t *region,
+		uint8_t *dest, uint64_t stride) {
+	auto numcomps = region->numcomps;
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto comp = region->comps + compno;
+		if (!comp->data)
+			continue;
+		auto src = comp->data;
+		auto dest_row = dest + comp->y0 * stride
+				+ (uint64_t) comp->x0 * numcomps * sizeof(T);
+		for (uint32_t j = 0; j < comp->h; ++j) {
+			T *dest_ptr = (T*) dest_row + compno;
+			for (uint32_t i = 0; i < comp->w; ++i) {
+				*dest_ptr = (T) src[i];
+				dest_ptr += numcomps;
+			}
+			src += comp->stride;
+			dest_row += stride;
+		}
+	}
+}
+
+/**
+ * Write decoded region into user's interleaved buffer
+ *
+ * @param p_j2k		J2K codec
+ * @param region	decoded region
+ */
+static void j2k_interleave_decoded_region(j2k_t *p_j2k,
+		grk_decoded_region_t *region) {
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	if (l_dec->m_interleaved_prec == 8)
+		j2k_interleave<uint8_t>(region, l_dec->m_interleaved_buffer,
+				l_dec->m_interleaved_stride);
+	else
+		j2k_interleave<uint16_t>(region, l_dec->m_interleaved_buffer,
+				l_dec->m_interleaved_stride);
+}
+
+/**
+ * Validate interleaved output buffer against output image
+ *
+ * @param p_j2k		J2K codec
+ * @param p_image	output image
+ */
+static bool j2k_check_interleaved_output(j2k_t *p_j2k, grk_image_t *p_image) {
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	if (l_dec->m_interleaved_prec != 8 && l_dec->m_interleaved_prec != 16) {
+		GROK_ERROR("Interleaved output precision must be either 8 or 16 bits");
+		return false;
+	}
+	grk_image_comp_t *comp0 = nullptr;
+	uint32_t l_numcomps = 0;
+	for (uint32_t compno = 0; compno < p_image->numcomps; ++compno) {
+		if (!j2k_decodes_component(&p_j2k->m_cp, compno))
+			continue;
+		auto comp = p_image->comps + compno;
+		if (!comp0)
+			comp0 = comp;
+		l_numcomps++;
+		if (comp->w != comp0->w || comp->h != comp0->h) {
+			GROK_ERROR(
+					"Interleaved output requires all components to have the same dimensions");
+			return false;
+		}
+		if (comp->sgnd) {
+			GROK_ERROR(
+					"Interleaved output does not support signed component %d",
+					compno);
+			return false;
+		}
+		if (comp->prec > l_dec->m_interleaved_prec) {
+			GROK_ERROR(
+					"Component %d precision %d exceeds interleaved output precision %d",
+					compno, comp->prec, l_dec->m_interleaved_prec);
+			return false;
+		}
+	}
+	if (!comp0 || !comp0->w || !comp0->h)
+		return false;
+	uint64_t l_min_stride = (uint64_t) comp0->w * l_numcomps
+			* (l_dec->m_interleaved_prec / 8);
+	if (l_dec->m_interleaved_stride < l_min_stride) {
+		GROK_ERROR("Interleaved output stride %llu is less than minimum stride %llu",
+				(unsigned long long) l_dec->m_interleaved_stride,
+				(unsigned long long) l_min_stride);
+		return false;
+	}
+	uint64_t l_min_len = l_dec->m_interleaved_stride * (comp0->h - 1)
+			+ l_min_stride;
+	if (l_dec->m_interleaved_buffer_len < l_min_len) {
+		GROK_ERROR(
+				"Interleaved output buffer length %llu is less than required length %llu",
+				(unsigned long long) l_dec->m_interleaved_buffer_len,
+				(unsigned long long) l_min_len);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Checks if a tile intersects the decode area
+ */
+static bool j2k_tile_in_decode_area(j2k_t *p_j2k, uint32_t tileno) {
+	auto l_dec = &p_j2k->m_specific_param.m_decoder;
+	uint32_t l_tile_x = tileno % p_j2k->m_cp.tw;
+	uint32_t l_tile_y = tileno / p_j2k->m_cp.tw;
+	return l_tile_x >= l_dec->m_start_tile_x && l_tile_x < l_dec->m_end_tile_x
+			&& l_tile_y >= l_dec->m_start_tile_y
+			&& l_tile_y < l_dec->m_end_tile_y
+			&& j2k_tile_in_decode_areas(p_j2k, tileno);
+}
+
+/**
+ * Stores the positions of all tile-parts in the header cache entry of the stream,
+ * once the whole code stream has been walked
+ */
+static void j2k_cache_tile_parts(j2k_t *p_j2k, GrokStream *p_stream,
+		HeaderCacheEntryPtr p_entry) {
+	auto l_cstr_index = p_j2k->cstr_index;
+	/* tile-part positions are indexed as 32 bit values */
+	if (!p_entry || !l_cstr_index || !l_cstr_index->tile_index
+			|| p_stream->m_user_data_length > UINT32_MAX)
+		return;
+	auto l_entry = std::make_shared<HeaderCacheEntry>();
+	l_entry->header = p_entry->header;
+	uint32_t l_nb_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+	for (uint32_t tileno = 0; tileno < l_nb_tiles; ++tileno) {
+		auto l_tile_index = l_cstr_index->tile_index + tileno;
+		for (uint32_t i = 0; i < l_tile_index->marknum; ++i) {
+			if (l_tile_index->marker[i].type == J2K_MS_SOT)
+				l_entry->tile_parts.push_back(
+						{ (uint64_t) l_tile_index->marker[i].pos, tileno });
+		}
+	}
+	std::sort(l_entry->tile_parts.begin(), l_entry->tile_parts.end(),
+			[](const TilePartPos &a, const TilePartPos &b) {
+				return a.pos < b.pos;
+			});
+	HeaderCache::instance()->put(p_stream->m_identity, l_entry);
+}
+
 static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream) {
 	bool l_go_on = true;
 	uint32_t l_current_tile_no = 0;
-	uint64_t l_data_size = 0, l_max_data_size = 0;
+	uint64_t l_data_size = 0;
 	uint32_t l_nb_comps = 0;
 	uint8_t *l_current_data = nullptr;
 	uint32_t nr_tiles = 0;
 	uint32_t num_tiles_to_decode = p_j2k->m_cp.th * p_j2k->m_cp.tw;
 	bool clearOutputOnInit = false;
-	if (j2k_needs_copy_tile_data(p_j2k, num_tiles_to_decode)) {
-		l_current_data = (uint8_t*) grok_malloc(1);
-		if (!l_current_data) {
-			GROK_ERROR(
-					"Not enough memory to decode tiles");
-			return false;
-		}
-		l_max_data_size = 1;
+	bool l_growing = p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream;
+	auto l_decoder = &p_j2k->m_specific_param.m_decoder;
+	bool l_copy_tile_data = !j2k_decodes_to_user(p_j2k)
+			&& j2k_needs_copy_tile_data(p_j2k, num_tiles_to_decode);
+	if (l_copy_tile_data)
 		clearOutputOnInit = num_tiles_to_decode > 1;
-	}
 	uint32_t num_tiles_decoded = 0;
 
+	/* header cache: tile-part positions let us seek past tiles outside
+	 * of the decode area. PPM packet headers must be read in sequence */
+	HeaderCacheEntryPtr l_cache_entry;
+	if (!l_growing && !p_stream->m_identity.empty()
+			&& l_decoder->m_tile_ind_to_dec == -1)
+		l_cache_entry = HeaderCache::instance()->get(p_stream->m_identity);
+	bool l_seek_tile_parts = l_cache_entry
+			&& !l_cache_entry->tile_parts.empty() && !p_j2k->m_cp.ppm;
+	size_t l_next_tile_part = 0;
+
 	for (nr_tiles = 0; nr_tiles < num_tiles_to_decode; nr_tiles++) {
 		uint32_t l_tile_x0, l_tile_y0, l_tile_x1, l_tile_y1;
 		l_tile_x0 = l_tile_y0 = l_tile_x1 = l_tile_y1 = 0;
+
+		if (l_seek_tile_parts && l_decoder->m_state == J2K_DEC_STATE_TPHSOT) {
+			auto &l_tile_parts = l_cache_entry->tile_parts;
+			/* SOT marker has already been read */
+			uint64_t l_sot_pos = p_stream->tell() - 2;
+			while (l_next_tile_part < l_tile_parts.size()
+					&& (l_tile_parts[l_next_tile_part].pos < l_sot_pos
+							|| !j2k_tile_in_decode_area(p_j2k,
+									l_tile_parts[l_next_tile_part].tileno)))
+				l_next_tile_part++;
+			/* no more tile-parts in decode area */
+			if (l_next_tile_part == l_tile_parts.size())
+				break;
+			uint64_t l_pos = l_tile_parts[l_next_tile_part].pos;
+			if (l_pos != l_sot_pos && !p_stream->seek(l_pos + 2)) {
+				GROK_ERROR("Problem with seek function");
+				return false;
+			}
+		}
 		if (!j2k_read_tile_header(p_j2k, &l_current_tile_no, &l_data_size,
 				&l_tile_x0, &l_tile_y0, &l_tile_x1, &l_tile_y1, &l_nb_comps,
 				&l_go_on, p_stream)) {
-			if (l_current_data)
-				grok_free(l_current_data);
+			/* growing stream: data ends inside a tile-part header */
+			if (l_growing && p_stream->get_number_byte_left() == 0) {
+				j2k_wait_for_data(p_j2k);
+				break;
+			}
 			return false;
 		}
 
@@ -9130,25 +9892,28 @@ static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream) {
 			break;
 		}
 
-		if (l_current_data && (l_data_size > l_max_data_size)) {
-			uint8_t *l_new_current_data = (uint8_t*) grok_realloc(
-					l_current_data, l_data_size);
-			if (!l_new_current_data) {
-				grok_free(l_current_data);
-				GROK_ERROR(
-						"Not enough memory to decode tile %d/%d\n",
-						l_current_tile_no + 1, num_tiles_to_decode);
-				return false;
+		/* the tile data buffer is kept by the decoder, and only grows */
+		if (l_copy_tile_data) {
+			if (!l_decoder->m_tile_data
+					|| l_data_size > l_decoder->m_tile_data_size) {
+				grok_free(l_decoder->m_tile_data);
+				l_decoder->m_tile_data_size = 0;
+				l_decoder->m_tile_data = (uint8_t*) grok_malloc(
+						l_data_size ? l_data_size : 1);
+				if (!l_decoder->m_tile_data) {
+					GROK_ERROR(
+							"Not enough memory to decode tile %d/%d\n",
+							l_current_tile_no + 1, num_tiles_to_decode);
+					return false;
+				}
+				l_decoder->m_tile_data_size = l_data_size;
 			}
-			l_current_data = l_new_current_data;
-			l_max_data_size = l_data_size;
+			l_current_data = l_decoder->m_tile_data;
 		}
 
 		try {
 			if (!j2k_decode_tile(p_j2k, l_current_tile_no, l_current_data,
 					l_data_size, p_stream)) {
-				if (l_current_data)
-					grok_free(l_current_data);
 				GROK_ERROR( "Failed to decode tile %d/%d\n",
 						l_current_tile_no + 1, num_tiles_to_decode);
 				return false;
@@ -9158,8 +9923,6 @@ static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream) {
 			if (nr_tiles < num_tiles_to_decode - 1) {
 				GROK_ERROR(
 						"Stream too short, expected SOT");
-				if (l_current_data)
-					grok_free(l_current_data);
 				GROK_ERROR( "Failed to decode tile %d/%d\n",
 						l_current_tile_no + 1, num_tiles_to_decode);
 				return false;
@@ -9169,9 +9932,8 @@ static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream) {
 
 		/* copy from current data to output image, if necessary */
 		if (l_current_data) {
-			if (!j2k_copy_decoded_tile_to_output_image(p_j2k->m_tcd,
+			if (!j2k_copy_decoded_tile_to_output_image(&p_j2k->m_cp, p_j2k->m_tcd,
 					l_current_data, p_j2k->m_output_image, clearOutputOnInit)) {
-				grok_free(l_current_data);
 				return false;
 			}
 			// event_msg( EVT_INFO, "Image data has been updated with tile %d.\n\n", l_current_tile_no + 1);
@@ -9185,10 +9947,12 @@ static bool j2k_decode_tiles(j2k_t *p_j2k, GrokStream *p_stream) {
 			break;
 	}
 
-	if (l_current_data) {
-		grok_free(l_current_data);
-	}
-
+	/* remaining tiles are decoded as more data arrives */
+	if (l_growing)
+		return true;
+	if (l_cache_entry && l_cache_entry->tile_parts.empty()
+			&& l_decoder->m_state == J2K_DEC_STATE_EOC)
+		j2k_cache_tile_parts(p_j2k, p_stream, l_cache_entry);
 	if (num_tiles_decoded == 0) {
 		GROK_ERROR( "No tiles were decoded. Exiting");
 		return false;
@@ -9226,7 +9990,8 @@ static bool j2k_decode_one_tile(j2k_t *p_j2k, GrokStream *p_stream) {
 	uint32_t l_nb_comps;
 	uint8_t *l_current_data = nullptr;
 
-	if (j2k_needs_copy_tile_data(p_j2k, 1)) {
+	if (!j2k_decodes_to_user(p_j2k)
+			&& j2k_needs_copy_tile_data(p_j2k, 1)) {
 		l_current_data = (uint8_t*) grok_malloc(1);
 		if (!l_current_data) {
 			GROK_ERROR(
@@ -9318,7 +10083,7 @@ static bool j2k_decode_one_tile(j2k_t *p_j2k, GrokStream *p_stream) {
 		//event_msg( EVT_INFO, "Tile %d/%d has been decoded.\n", l_current_tile_no+1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
 
 		if (l_current_data) {
-			if (!j2k_copy_decoded_tile_to_output_image(p_j2k->m_tcd,
+			if (!j2k_copy_decoded_tile_to_output_image(&p_j2k->m_cp, p_j2k->m_tcd,
 					l_current_data, p_j2k->m_output_image, false)) {
 				grok_free(l_current_data);
 				return false;
@@ -9362,6 +10127,12 @@ bool j2k_decode(j2k_t *p_j2k, grok_plugin_tile_t *tile, GrokStream *p_stream,
 		grk_image_t *p_image) {
 	if (!p_image)
 		return false;
+	if (!j2k_check_decode_components(p_j2k, p_image))
+		return false;
+
+	/* Destroy the output image of a previous decode */
+	if (p_j2k->m_output_image)
+		grk_image_destroy(p_j2k->m_output_image);
 
 	p_j2k->m_output_image = grk_image_create0();
 	if (!(p_j2k->m_output_image)) {
@@ -9369,6 +10140,10 @@ bool j2k_decode(j2k_t *p_j2k, grok_plugin_tile_t *tile, GrokStream *p_stream,
 	}
 	grk_copy_image_header(p_image, p_j2k->m_output_image);
 
+	if (p_j2k->m_cp.m_specific_param.m_dec.m_interleaved_buffer
+			&& !j2k_check_interleaved_output(p_j2k, p_j2k->m_output_image))
+		return false;
+
 	/* customization of the decoding */
 	if (!j2k_setup_decoding(p_j2k))
 		return false;
@@ -9383,9 +10158,29 @@ bool j2k_decode(j2k_t *p_j2k, grok_plugin_tile_t *tile, GrokStream *p_stream,
 
 	/* Move data and information from codec output image to user output image*/
 	j2k_transfer_image_data(p_j2k->m_output_image, p_image);
+	j2k_remove_unselected_components(&p_j2k->m_cp, p_image);
 	return true;
 }
 
+/**
+ * Key of a decoded tile in the tile cache, or empty string if the tile cannot be cached
+ */
+static std::string j2k_tile_cache_key(j2k_t *p_j2k, GrokStream *p_stream,
+		grk_image_t *p_image, uint32_t tile_index) {
+	auto l_dec = &p_j2k->m_cp.m_specific_param.m_dec;
+	if (p_stream->m_identity.empty() || j2k_decodes_to_user(p_j2k)
+			|| l_dec->m_layer_refinement || l_dec->m_growing_stream
+			|| !TileCache::instance()->enabled())
+		return "";
+	std::stringstream ss;
+	ss << p_stream->m_identity << "/" << tile_index << "/" << p_image->x0 << ","
+			<< p_image->y0 << "," << p_image->x1 << "," << p_image->y1 << "/"
+			<< l_dec->m_reduce << "/" << l_dec->m_layer << "/";
+	for (uint32_t i = 0; i < l_dec->m_numcomps_to_decode; ++i)
+		ss << l_dec->m_comps_to_decode[i] << ",";
+	return ss.str();
+}
+
 bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint32_t tile_index) {
 	uint32_t compno;
 	uint32_t l_tile_x, l_tile_y;
@@ -9397,6 +10192,9 @@ bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint
 				"We need an image previously created.");
 		return false;
 	}
+	if (!j2k_check_decode_components(p_j2k, p_image))
+		return false;
+	j2k_clear_decode_areas(p_j2k);
 
 	if ( /*(tile_index < 0) &&*/(tile_index >= p_j2k->m_cp.tw * p_j2k->m_cp.th)) {
 		GROK_ERROR(
@@ -9469,6 +10267,14 @@ bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint
 		l_img_comp++;
 	}
 
+	/* tile has already been decoded */
+	auto l_cache_key = j2k_tile_cache_key(p_j2k, p_stream, p_image, tile_index);
+	if (!l_cache_key.empty()) {
+		auto l_entry = TileCache::instance()->get(l_cache_key);
+		if (l_entry)
+			return TileCache::copy_to_image(l_entry.get(), p_image);
+	}
+
 	/* Destroy the previous output image*/
 	if (p_j2k->m_output_image)
 		grk_image_destroy(p_j2k->m_output_image);
@@ -9480,6 +10286,10 @@ bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint
 	}
 	grk_copy_image_header(p_image, p_j2k->m_output_image);
 
+	if (p_j2k->m_cp.m_specific_param.m_dec.m_interleaved_buffer
+			&& !j2k_check_interleaved_output(p_j2k, p_j2k->m_output_image))
+		return false;
+
 	p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = (int32_t) tile_index;
 
 	// reset tile part numbers, in case we are re-using the same codec object from previous decode
@@ -9501,10 +10311,245 @@ bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint
 
 	/* Move data information from codec output image to user output image*/
 	j2k_transfer_image_data(p_j2k->m_output_image, p_image);
+	j2k_remove_unselected_components(&p_j2k->m_cp, p_image);
+
+	if (!l_cache_key.empty())
+		TileCache::instance()->put(l_cache_key,
+				TileCache::create_entry(p_image));
 
 	return true;
 }
 
+/**
+ * Decode a tile again from its retained compressed data, and update the output image
+ *
+ * @param p_j2k				J2K codec
+ * @param tileno			tile index
+ * @param p_data			scratch buffer for the decoded tile, grown as needed
+ * @param p_max_data_size	size of scratch buffer
+ */
+static bool j2k_redecode_tile(j2k_t *p_j2k, uint32_t tileno, uint8_t **p_data,
+		uint64_t *p_max_data_size) {
+	auto l_tcp = p_j2k->m_cp.tcps + tileno;
+	auto l_refinement = l_tcp->m_refinement;
+	if (!p_j2k->m_tcd->init_decode_tile(p_j2k->m_output_image, tileno,
+			p_j2k->m_specific_param.m_decoder.m_decode_areas,
+			p_j2k->m_specific_param.m_decoder.m_num_decode_areas)) {
+		GROK_ERROR("Cannot decode tile %d", tileno);
+		return false;
+	}
+	l_refinement->tile_data->rewind();
+	if (!p_j2k->m_tcd->decode_tile(l_refinement->tile_data, tileno)) {
+		GROK_ERROR("Failed to decode tile %d again", tileno);
+		/* coefficients of this tile are no longer consistent */
+		delete l_refinement;
+		l_tcp->m_refinement = nullptr;
+		return false;
+	}
+	l_refinement->num_layers_decoded = l_tcp->num_layers_to_decode;
+
+	if (j2k_decodes_to_user(p_j2k)) {
+		if (!j2k_stream_decoded_tile(p_j2k, tileno)) {
+			GROK_ERROR("Decode sink aborted decoding of tile %d", tileno);
+			return false;
+		}
+		return true;
+	}
+	uint64_t l_data_size = p_j2k->m_tcd->get_decoded_tile_size();
+	if (l_data_size > *p_max_data_size) {
+		uint8_t *l_new_data = (uint8_t*) grok_realloc(*p_data, l_data_size);
+		if (!l_new_data) {
+			GROK_ERROR("Not enough memory to decode tile %d", tileno);
+			return false;
+		}
+		*p_data = l_new_data;
+		*p_max_data_size = l_data_size;
+	}
+	return p_j2k->m_tcd->update_tile_data(*p_data, l_data_size)
+			&& j2k_copy_decoded_tile_to_output_image(&p_j2k->m_cp, p_j2k->m_tcd,
+					*p_data, p_j2k->m_output_image, true);
+}
+
+bool j2k_decode_layers(j2k_t *p_j2k, grk_image_t *p_image, uint32_t num_layers) {
+	auto l_cp = &p_j2k->m_cp;
+	auto l_dec = &l_cp->m_specific_param.m_dec;
+	if (!l_dec->m_layer_refinement || !p_j2k->m_output_image) {
+		GROK_ERROR(
+				"Layer refinement requires a previous decode with layer refinement enabled");
+		return false;
+	}
+	if (j2k_decodes_component_subset(p_j2k)) {
+		GROK_ERROR(
+				"Layer refinement is not supported together with component subset decoding");
+		return false;
+	}
+	bool l_to_user = j2k_decodes_to_user(p_j2k);
+	if (!l_to_user && p_image->numcomps != p_j2k->m_output_image->numcomps) {
+		GROK_ERROR(
+				"Image has %d components, but previously decoded image has %d components",
+				p_image->numcomps, p_j2k->m_output_image->numcomps);
+		return false;
+	}
+	l_dec->m_layer = num_layers;
+
+	/* previously decoded samples are updated in place */
+	if (!l_to_user)
+		j2k_transfer_image_data(p_image, p_j2k->m_output_image);
+
+	bool l_rc = true;
+	uint8_t *l_current_data = nullptr;
+	uint64_t l_max_data_size = 0;
+	uint32_t l_nb_tiles = l_cp->tw * l_cp->th;
+	for (uint32_t tileno = 0; tileno < l_nb_tiles; ++tileno) {
+		auto l_tcp = l_cp->tcps + tileno;
+		auto l_refinement = l_tcp->m_refinement;
+		if (!l_refinement || !l_refinement->tile_data)
+			continue;
+		uint32_t l_num_layers = l_tcp->numlayers;
+		if (num_layers && num_layers < l_num_layers)
+			l_num_layers = num_layers;
+		/* tile is unchanged */
+		if (l_num_layers == l_refinement->num_layers_decoded)
+			continue;
+		l_tcp->num_layers_to_decode = l_num_layers;
+		if (l_cp->ppm) {
+			l_cp->ppm_data = l_refinement->ppm_data;
+			l_cp->ppm_len = l_refinement->ppm_len;
+		}
+		l_tcp->ppt_data = l_refinement->ppt_data;
+		l_tcp->ppt_len = l_refinement->ppt_len;
+
+		if (!j2k_redecode_tile(p_j2k, tileno, &l_current_data,
+				&l_max_data_size)) {
+			l_rc = false;
+			break;
+		}
+	}
+	grok_free(l_current_data);
+
+	if (!l_to_user)
+		j2k_transfer_image_data(p_j2k->m_output_image, p_image);
+
+	return l_rc;
+}
+
+/**
+ * Growing stream: read the part of the truncated tile-part that has arrived since
+ * the previous decode, and decode the tile again
+ */
+static bool j2k_extend_truncated_tile(j2k_t *p_j2k, GrokStream *p_stream) {
+	auto l_dec = &p_j2k->m_specific_param.m_decoder;
+	uint32_t tileno = (uint32_t) l_dec->m_truncated_tile;
+	auto l_refinement = p_j2k->m_cp.tcps[tileno].m_refinement;
+	if (!l_refinement || !l_refinement->tile_data) {
+		GROK_ERROR("Missing data for incomplete tile %d", tileno);
+		return false;
+	}
+	/* reading stopped at the previous end of the stream */
+	if (!p_stream->seek(p_stream->tell()))
+		return false;
+	auto l_available = p_stream->get_number_byte_left();
+	if (l_available <= 0)
+		return true;
+	uint64_t l_len = std::min<uint64_t>((uint64_t) l_available,
+			l_dec->m_truncated_bytes);
+	std::vector<uint8_t> l_buf(l_len);
+	if (p_stream->read(l_buf.data(), l_len) != l_len
+			|| !l_refinement->tile_data->append_to_last_segment(l_buf.data(),
+					l_len)) {
+		GROK_ERROR("Failed to read data for tile %d", tileno);
+		return false;
+	}
+	if (l_dec->m_truncated_bytes != UINT64_MAX) {
+		l_dec->m_truncated_bytes -= l_len;
+		if (!l_dec->m_truncated_bytes) {
+			/* tile-part is complete: the next one starts here */
+			l_refinement->truncated = false;
+			l_dec->m_truncated_tile = -1;
+			l_dec->m_resume_pos = p_stream->tell();
+			l_dec->m_resume_tile = -1;
+		}
+	} else if (j2k_tile_data_ends_with_eoc(l_refinement->tile_data)) {
+		/* Psot == 0: tile-part is complete, and EOC is read next */
+		if (!l_refinement->tile_data->trim_last_segment(2))
+			return false;
+		l_refinement->truncated = false;
+		l_dec->m_truncated_tile = -1;
+		l_dec->m_resume_pos = p_stream->tell() - 2;
+		l_dec->m_resume_tile = -1;
+	}
+	uint8_t *l_current_data = nullptr;
+	uint64_t l_max_data_size = 0;
+	bool l_rc = j2k_redecode_tile(p_j2k, tileno, &l_current_data,
+			&l_max_data_size);
+	grok_free(l_current_data);
+	return l_rc;
+}
+
+bool j2k_decode_update(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image) {
+	auto l_dec = &p_j2k->m_specific_param.m_decoder;
+	if (!p_j2k->m_cp.m_specific_param.m_dec.m_growing_stream
+			|| !p_j2k->m_output_image) {
+		GROK_ERROR(
+				"Decode update requires a previous decode with growing stream enabled");
+		return false;
+	}
+	if (j2k_decodes_component_subset(p_j2k)) {
+		GROK_ERROR(
+				"Decode update is not supported together with component subset decoding");
+		return false;
+	}
+	bool l_to_user = j2k_decodes_to_user(p_j2k);
+	if (!l_to_user && p_image->numcomps != p_j2k->m_output_image->numcomps) {
+		GROK_ERROR(
+				"Image has %d components, but previously decoded image has %d components",
+				p_image->numcomps, p_j2k->m_output_image->numcomps);
+		return false;
+	}
+	/* codestream is complete */
+	if (l_dec->m_state == J2K_DEC_STATE_EOC && l_dec->m_truncated_tile < 0)
+		return true;
+
+	/* previously decoded samples are updated in place */
+	if (!l_to_user)
+		j2k_transfer_image_data(p_image, p_j2k->m_output_image);
+
+	bool l_rc = true;
+	if (l_dec->m_truncated_tile >= 0)
+		l_rc = j2k_extend_truncated_tile(p_j2k, p_stream);
+
+	/* continue with the next tile-part, once its marker has arrived */
+	if (l_rc && l_dec->m_truncated_tile < 0
+			&& l_dec->m_state != J2K_DEC_STATE_EOC) {
+		uint8_t l_data[2];
+		uint32_t l_current_marker = 0;
+		l_rc = p_stream->seek((uint64_t) l_dec->m_resume_pos);
+		if (l_rc && p_stream->get_number_byte_left() >= 2) {
+			if (p_stream->read(l_data, 2) != 2) {
+				j2k_stream_too_short(p_j2k);
+				l_rc = false;
+			} else {
+				grok_read_bytes(l_data, &l_current_marker, 2);
+				if (l_current_marker == J2K_MS_EOC) {
+					l_dec->m_state = J2K_DEC_STATE_EOC;
+				} else if (l_current_marker == J2K_MS_SOT) {
+					l_dec->m_state = J2K_DEC_STATE_TPHSOT;
+					l_rc = j2k_decode_tiles(p_j2k, p_stream);
+				} else {
+					GROK_ERROR("Expected SOT or EOC marker, found %x",
+							l_current_marker);
+					l_rc = false;
+				}
+			}
+		}
+	}
+
+	if (!l_to_user)
+		j2k_transfer_image_data(p_j2k->m_output_image, p_image);
+
+	return l_rc;
+}
+
 bool j2k_set_decoded_resolution_factor(j2k_t *p_j2k, uint32_t res_factor) {
 	uint32_t it_comp;
 
@@ -9553,7 +10598,7 @@ bool j2k_encode(j2k_t *p_j2k, grok_plugin_tile_t *tile, GrokStream *p_stream) {
 	p_tcd->current_plugin_tile = tile;
 
 	l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
-	if (l_nb_tiles == 1) {
+	if (l_nb_tiles == 1 && !p_j2k->m_cp.m_specific_param.m_enc.m_input_buffer) {
 		l_reuse_data = true;
 #ifdef __SSE__
 		for (j = 0; j < p_j2k->m_tcd->image->numcomps; ++j) {
@@ -9589,8 +10634,11 @@ bool j2k_encode(j2k_t *p_j2k, grok_plugin_tile_t *tile, GrokStream *p_stream) {
 				}
 			}
 		}
-		l_current_tile_size = p_tcd->get_encoded_tile_size();
-		if (!l_reuse_data) {
+		if (p_j2k->m_cp.m_specific_param.m_enc.m_input_buffer) {
+			/* read samples straight from the user buffer into the tile components */
+			j2k_copy_input_buffer_to_tile(p_j2k);
+		} else if (!l_reuse_data) {
+			l_current_tile_size = p_tcd->get_encoded_tile_size();
 			if (l_current_tile_size > l_max_tile_size) {
 				uint8_t *l_new_current_data = (uint8_t*) grok_realloc(
 						l_current_data, l_current_tile_size);
@@ -9646,6 +10694,19 @@ bool j2k_end_compress(j2k_t *p_j2k, GrokStream *p_stream) {
 	return true;
 }
 
+bool j2k_get_compress_stats(j2k_t *p_j2k, grk_compress_stats_t *stats) {
+	if (!p_j2k || !stats)
+		return false;
+	auto l_enc = &p_j2k->m_specific_param.m_encoder;
+	stats->passes_coded = l_enc->m_num_passes_coded;
+	stats->passes_skipped = l_enc->m_num_passes_skipped;
+	if (p_j2k->m_tcd) {
+		stats->passes_coded += p_j2k->m_tcd->m_num_passes_coded;
+		stats->passes_skipped += p_j2k->m_tcd->m_num_passes_skipped;
+	}
+	return true;
+}
+
 bool j2k_start_compress(j2k_t *p_j2k, GrokStream *p_stream,
 		grk_image_t *p_image) {
 
@@ -9741,6 +10802,60 @@ static void get_tile_dimensions(grk_image_t *l_image, tcd_tilecomp_t *l_tilec,
 			+ (uint64_t) (l_tilec->y0 - *l_offset_y) * *l_image_width;
 }
 
+template<typename T> static void j2k_copy_input_to_tilec(const uint8_t *src,
+		uint64_t src_stride, uint32_t src_step, tcd_tilecomp_t *tilec) {
+	uint32_t w = tilec->x1 - tilec->x0;
+	uint32_t h = tilec->y1 - tilec->y0;
+	int32_t *dest = tilec->buf->data;
+	for (uint32_t j = 0; j < h; ++j) {
+		auto src_ptr = (const T*) src;
+		for (uint32_t k = 0; k < w; ++k) {
+			dest[k] = (int32_t) *src_ptr;
+			src_ptr += src_step;
+		}
+		dest += w;
+		src += src_stride;
+	}
+}
+
+static void j2k_copy_input_buffer_to_tile(j2k_t *p_j2k) {
+	auto p_tcd = p_j2k->m_tcd;
+	auto l_image = p_tcd->image;
+	auto enc = &p_j2k->m_cp.m_specific_param.m_enc;
+	uint32_t bytes_per_sample = enc->m_input_prec >> 3;
+	uint32_t numcomps = l_image->numcomps;
+	uint32_t src_step = enc->m_input_interleaved ? numcomps : 1;
+	uint64_t image_height = l_image->y1 - l_image->y0;
+
+	for (uint32_t i = 0; i < numcomps; ++i) {
+		auto l_tilec = p_tcd->tile->comps + i;
+		auto l_img_comp = l_image->comps + i;
+		const uint8_t *src = enc->m_input_buffer
+				+ (uint64_t) (l_tilec->y0 - l_image->y0) * enc->m_input_stride;
+		if (enc->m_input_interleaved)
+			src += ((uint64_t) (l_tilec->x0 - l_image->x0) * numcomps + i)
+					* bytes_per_sample;
+		else
+			src += (uint64_t) i * enc->m_input_stride * image_height
+					+ (uint64_t) (l_tilec->x0 - l_image->x0) * bytes_per_sample;
+		if (bytes_per_sample == 1) {
+			if (l_img_comp->sgnd)
+				j2k_copy_input_to_tilec<int8_t>(src, enc->m_input_stride,
+						src_step, l_tilec);
+			else
+				j2k_copy_input_to_tilec<uint8_t>(src, enc->m_input_stride,
+						src_step, l_tilec);
+		} else {
+			if (l_img_comp->sgnd)
+				j2k_copy_input_to_tilec<int16_t>(src, enc->m_input_stride,
+						src_step, l_tilec);
+			else
+				j2k_copy_input_to_tilec<uint16_t>(src, enc->m_input_stride,
+						src_step, l_tilec);
+		}
+	}
+}
+
 static void j2k_get_tile_data(TileProcessor *p_tcd, uint8_t *p_data) {
 	uint32_t i, j, k = 0;
 
@@ -10134,6 +11249,11 @@ static bool j2k_end_encoding(j2k_t *p_j2k, GrokStream *p_stream) {
 	
 	assert(p_stream != nullptr);
 
+	if (p_j2k->m_tcd) {
+		auto l_enc = &p_j2k->m_specific_param.m_encoder;
+		l_enc->m_num_passes_coded += p_j2k->m_tcd->m_num_passes_coded;
+		l_enc->m_num_passes_skipped += p_j2k->m_tcd->m_num_passes_skipped;
+	}
 	delete p_j2k->m_tcd;
 	p_j2k->m_tcd = nullptr;
 
@@ -253,6 +253,8 @@ struct ppx_t {
 	uint32_t m_data_size;
 };
 
+struct layer_refinement_t;
+
 /**
  Tile coding parameters :
  this structure is used to store coding/decoding parameters common to all
@@ -305,6 +307,10 @@ struct tcp_t {
 	uint32_t m_nb_tile_parts;
 
 	seg_buf_t *m_tile_data;
+	/** packet lengths read from PLT markers, in codestream order (decoder only) */
+	std::vector<uint32_t> *m_packet_lengths;
+	/** tile state retained for layer refinement (decoder only) */
+	layer_refinement_t *m_refinement;
 
 	/** encoding norms */
 	double *mct_norms;
@@ -349,13 +355,43 @@ struct encoding_param_t {
 	uint32_t m_tp_on :1;
 	/* rate control algorithm */
 	uint32_t rateControlAlgorithm;
+	/** code every code-block pass, even ones rate control is expected to discard */
+	bool m_code_all_passes;
+	/** if not null, tile buffers are filled from this 8/16 bit buffer
+	 rather than from the image component data */
+	uint8_t *m_input_buffer;
+	uint64_t m_input_stride;
+	uint32_t m_input_prec;
+	bool m_input_interleaved;
 };
 
 struct decoding_param_t {
 	/** if != 0, then original dimension divided by 2^(reduce); if == 0 or not used, image is decoded to the full resolution */
 	uint32_t m_reduce;
+	/** if true, m_reduce is set from the main header so that only the lowest resolution is decoded */
+	bool m_thumbnail;
 	/** if != 0, then only the first "layer" layers are decoded; if == 0 or not used, all the quality layers are decoded */
 	uint32_t m_layer;
+	/** if not null, decoded tiles are streamed to this sink instead of the output image */
+	grk_decode_sink_fn m_sink;
+	void *m_sink_user_data;
+	/** maximum number of bytes of decoded sample data for a single tile (0 : no limit) */
+	uint64_t m_max_tile_memory;
+	/** if not null, decoded tiles are written, interleaved, into this buffer */
+	uint8_t *m_interleaved_buffer;
+	uint64_t m_interleaved_buffer_len;
+	uint64_t m_interleaved_stride;
+	uint32_t m_interleaved_prec;
+	/** if true, tile data and decoded code-blocks are retained so that more layers can be decoded later */
+	bool m_layer_refinement;
+	/** if true, the codestream is still growing: decoding stops at the end of the available data, and can be resumed later */
+	bool m_growing_stream;
+	/** if != 0, then only the components listed (sorted, without duplicates) in m_comps_to_decode are decoded */
+	uint32_t m_numcomps_to_decode;
+	uint32_t *m_comps_to_decode;
+	/** true once a header has been read with the component selection: the selection
+	 belongs to that codestream, and is cleared when the decoder is reused */
+	bool m_comps_to_decode_used;
 };
 
 /**
@@ -458,6 +494,22 @@ struct j2k_dec_t {
 	uint32_t m_nb_tile_parts_correction_checked :1;
 	uint32_t m_nb_tile_parts_correction :1;
 
+	/** Growing stream: offset of the tile-part from which reading resumes when more data arrives */
+	int64_t m_resume_pos;
+	/** Growing stream: tile whose SOT marker was read at m_resume_pos, or -1 */
+	int32_t m_resume_tile;
+	/** Growing stream: tile whose last tile-part data is incomplete, or -1 */
+	int32_t m_truncated_tile;
+	/** Growing stream: number of bytes missing from that tile-part
+	 * (UINT64_MAX if Psot == 0: the tile-part then ends at the EOC marker) */
+	uint64_t m_truncated_bytes;
+	/** decoded tile, before it is copied to the output image; kept across tiles and codestreams */
+	uint8_t *m_tile_data;
+	uint64_t m_tile_data_size;
+	/** areas within the decode area that are needed: tiles and code-blocks
+	 * needed by none of them are not decoded. Set by j2k_set_decode_areas */
+	grk_decode_area_t *m_decode_areas;
+	uint32_t m_num_decode_areas;
 };
 
 struct j2k_enc_t {
@@ -485,6 +537,11 @@ struct j2k_enc_t {
 	/** used in TLMmarker*/
 	uint32_t m_total_tile_parts; /* totnum_tp */
 
+	/** code-block passes coded, and passes not coded because rate control
+	 was expected to discard them, by tile encoders that have been released */
+	uint64_t m_num_passes_coded;
+	uint64_t m_num_passes_skipped;
+
 };
 
 struct j2k_t;
@@ -642,6 +699,21 @@ bool j2k_read_tile_header(j2k_t *p_j2k, uint32_t *tile_index,
 bool j2k_set_decode_area(j2k_t *p_j2k, grk_image_t *p_image, uint32_t start_x,
 		uint32_t start_y, uint32_t end_x, uint32_t end_y);
 
+/**
+ * Restricts the decode area to a set of areas within it: tiles and code-blocks
+ * that none of the areas need are not decoded, and the rest of the decode
+ * area is left undefined. Areas are cleared by the next call to
+ * j2k_set_decode_area.
+ *
+ * @param	p_j2k			the jpeg2000 codec.
+ * @param	areas			areas, in reference grid coordinates
+ * @param	num_areas		number of areas
+ *
+ * @return	true			if the areas could be set.
+ */
+bool j2k_set_decode_areas(j2k_t *p_j2k, const grk_decode_area_t *areas,
+		uint32_t num_areas);
+
 /**
  * Creates a J2K decompression structure.
  *
@@ -712,6 +784,51 @@ bool j2k_get_tile(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image, uint
 
 bool j2k_set_decoded_resolution_factor(j2k_t *p_j2k, uint32_t res_factor);
 
+/**
+ * Refine a previously decoded image by decoding a different number of quality layers.
+ * Only tiles whose number of decoded layers changes are decoded again,
+ * and only code-blocks that receive new compressed data go through T1.
+ *
+ * @param p_j2k			J2K codec, set up for layer refinement
+ * @param p_image		image returned by previous decode
+ * @param num_layers	number of layers to decode (0 : all layers)
+ */
+bool j2k_decode_layers(j2k_t *p_j2k, grk_image_t *p_image, uint32_t num_layers);
+
+/**
+ * Continue decoding a growing codestream after more data has become available.
+ * Reading resumes inside the incomplete tile-part, or at the start of the first
+ * tile-part that was not yet read. Tiles that receive no new data are not decoded again.
+ *
+ * @param p_j2k			J2K codec, set up for a growing stream
+ * @param p_stream		stream used for the previous decode
+ * @param p_image		image returned by previous decode
+ */
+bool j2k_decode_update(j2k_t *p_j2k, GrokStream *p_stream, grk_image_t *p_image);
+
+/**
+ * Check if decoded tiles are passed straight to the user (decode sink or
+ * interleaved buffer), rather than being stored in the output image
+ *
+ * @param p_j2k	J2K codec
+ */
+bool j2k_decodes_to_user(j2k_t *p_j2k);
+
+/**
+ * Check if only a subset of the image components is decoded
+ *
+ * @param p_j2k	J2K codec
+ */
+bool j2k_decodes_component_subset(j2k_t *p_j2k);
+
+/**
+ * Check if component was selected for decoding
+ *
+ * @param p_cp		decoder coding parameters
+ * @param compno	component index
+ */
+bool j2k_decodes_component(cp_t *p_cp, uint32_t compno);
+
 /**
  * Writes a tile.
  * @param	p_j2k		the jpeg2000 codec.
@@ -748,6 +865,11 @@ bool j2k_start_compress(j2k_t *p_j2k, GrokStream *p_stream,
  */
 bool j2k_end_compress(j2k_t *p_j2k, GrokStream *cio);
 
+/**
+ * Gets the statistics of the tiles compressed so far.
+ */
+bool j2k_get_compress_stats(j2k_t *p_j2k, grk_compress_stats_t *stats);
+
 bool j2k_setup_mct_encoding(tcp_t *p_tcp, grk_image_t *p_image);
 
 }
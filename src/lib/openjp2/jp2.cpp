@@ -461,6 +461,12 @@ static bool jp2_read_boxhdr_char(jp2_box_t *box, uint8_t *p_data,
  */
 static bool jp2_setup_decoding_validation(jp2_t *jp2);
 
+/**
+ * Releases the boxes read from the previous file, so that the decoder
+ * can be bound to a new one.
+ */
+static void jp2_reset_decompress(jp2_t *jp2);
+
 /**
  * Sets up the procedures to do on reading header.
  * Developers wanting to extend the library can add their own writing procedures.
@@ -1860,7 +1866,9 @@ bool jp2_decode(jp2_t *jp2, grok_plugin_tile_t *tile, GrokStream *p_stream,
 		return false;
 	}
 
-	if (!jp2_check_color(p_image, &(jp2->color))) {
+	/* channel indices in pclr/cmap/cdef boxes refer to the full component set */
+	bool l_comp_subset = j2k_decodes_component_subset(jp2->j2k);
+	if (!l_comp_subset && !jp2_check_color(p_image, &(jp2->color))) {
 		return false;
 	}
 
@@ -1905,15 +1913,22 @@ bool jp2_decode(jp2_t *jp2, grok_plugin_tile_t *tile, GrokStream *p_stream,
 		/* Part 1, I.5.3.4: Either both or none : */
 		if (!jp2->color.jp2_pclr->cmap)
 			jp2_free_pclr(&(jp2->color));
-		else {
+		else if (j2k_decodes_to_user(jp2->j2k)) {
+			GROK_WARN(
+					"Palette is not applied to samples decoded directly to user buffers");
+		} else if (l_comp_subset) {
+			GROK_WARN(
+					"Palette is not applied when decoding a subset of components");
+		} else {
 			if (!jp2_apply_pclr(p_image, &(jp2->color)))
 				return false;
 		}
 	}
 
 	/* Apply channel definitions if needed */
-	if (jp2->color.jp2_cdef) {
+	if (jp2->color.jp2_cdef && !l_comp_subset) {
 		jp2_apply_cdef(p_image, &(jp2->color));
+		jp2->cdef_applied = true;
 	}
 
 	// retrieve icc profile
@@ -2463,6 +2478,10 @@ bool jp2_end_compress(jp2_t *jp2, GrokStream *cio) {
 	return jp2_exec(jp2, jp2->m_procedure_list, cio);
 }
 
+bool jp2_get_compress_stats(jp2_t *jp2, grk_compress_stats_t *stats) {
+	return j2k_get_compress_stats(jp2->j2k, stats);
+}
+
 static bool jp2_setup_end_header_writing(jp2_t *jp2) {
 
 	assert(jp2 != nullptr);
@@ -3032,12 +3051,54 @@ static bool jp2_read_boxhdr_char(jp2_box_t *box, uint8_t *p_data,
 	return true;
 }
 
+static void jp2_reset_decompress(jp2_t *jp2) {
+	grok_free(jp2->comps);
+	jp2->comps = nullptr;
+	grok_free(jp2->cl);
+	jp2->cl = nullptr;
+	jp2->numcl = 0;
+
+	if (jp2->color.icc_profile_buf) {
+		grk_buffer_delete(jp2->color.icc_profile_buf);
+		jp2->color.icc_profile_buf = nullptr;
+	}
+	jp2->color.icc_profile_len = 0;
+	if (jp2->color.jp2_cdef) {
+		grok_free(jp2->color.jp2_cdef->info);
+		grok_free(jp2->color.jp2_cdef);
+		jp2->color.jp2_cdef = nullptr;
+	}
+	jp2_free_pclr(&jp2->color);
+	jp2->color.jp2_has_colour_specification_box = 0;
+	jp2->cdef_applied = false;
+
+	jp2->has_capture_resolution = false;
+	jp2->has_display_resolution = false;
+	for (int i = 0; i < 2; ++i) {
+		jp2->capture_resolution[i] = 0;
+		jp2->display_resolution[i] = 0;
+	}
+
+	jp2->xml.dealloc();
+	for (uint32_t i = 0; i < jp2->numUuids; ++i) {
+		(jp2->uuids + i)->dealloc();
+	}
+	jp2->numUuids = 0;
+
+	jp2->jp2_state = JP2_STATE_NONE;
+	jp2->jp2_img_state = JP2_IMG_STATE_NONE;
+}
+
 bool jp2_read_header(GrokStream *p_stream, jp2_t *jp2,
 		grk_header_info_t *header_info, grk_image_t **p_image) {
 
 	assert(jp2 != nullptr);
 	assert(p_stream != nullptr);
 	
+	/* the decoder has already read a file: rebind it to this one */
+	if (jp2->jp2_state != JP2_STATE_NONE)
+		jp2_reset_decompress(jp2);
+
 
 	/* customization of the validation */
 	if (!jp2_setup_decoding_validation(jp2)) {
@@ -3223,6 +3284,11 @@ bool jp2_set_decode_area(jp2_t *p_jp2, grk_image_t *p_image, uint32_t start_x,
 			end_x, end_y);
 }
 
+bool jp2_set_decode_areas(jp2_t *p_jp2, const grk_decode_area_t *areas,
+		uint32_t num_areas) {
+	return j2k_set_decode_areas(p_jp2->j2k, areas, num_areas);
+}
+
 bool jp2_get_tile(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image, uint32_t tile_index) {
 	if (!p_image)
 		return false;
@@ -3236,7 +3302,8 @@ bool jp2_get_tile(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image, uint
 		return false;
 	}
 
-	if (!jp2_check_color(p_image, &(p_jp2->color))) {
+	bool l_comp_subset = j2k_decodes_component_subset(p_jp2->j2k);
+	if (!l_comp_subset && !jp2_check_color(p_image, &(p_jp2->color))) {
 		return false;
 	}
 
@@ -3258,15 +3325,19 @@ bool jp2_get_tile(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image, uint
 		/* Part 1, I.5.3.4: Either both or none : */
 		if (!p_jp2->color.jp2_pclr->cmap)
 			jp2_free_pclr(&(p_jp2->color));
-		else {
+		else if (l_comp_subset) {
+			GROK_WARN(
+					"Palette is not applied when decoding a subset of components");
+		} else {
 			if (!jp2_apply_pclr(p_image, &(p_jp2->color)))
 				return false;
 		}
 	}
 
 	/* Apply channel definitions if needed */
-	if (p_jp2->color.jp2_cdef) {
+	if (p_jp2->color.jp2_cdef && !l_comp_subset) {
 		jp2_apply_cdef(p_image, &(p_jp2->color));
+		p_jp2->cdef_applied = true;
 	}
 
 	if (p_jp2->color.icc_profile_buf) {
@@ -3332,4 +3403,24 @@ bool jp2_set_decoded_resolution_factor(jp2_t *p_jp2, uint32_t res_factor) {
 	return j2k_set_decoded_resolution_factor(p_jp2->j2k, res_factor);
 }
 
+bool jp2_decode_layers(jp2_t *p_jp2, grk_image_t *p_image, uint32_t num_layers) {
+	/* palette and channel definitions have already changed the image components */
+	if (p_jp2->color.jp2_pclr || p_jp2->cdef_applied) {
+		GROK_ERROR(
+				"Layer refinement is not supported for images with palette or channel definitions");
+		return false;
+	}
+	return j2k_decode_layers(p_jp2->j2k, p_image, num_layers);
+}
+
+bool jp2_decode_update(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image) {
+	/* palette and channel definitions have already changed the image components */
+	if (p_jp2->color.jp2_pclr || p_jp2->cdef_applied) {
+		GROK_ERROR(
+				"Growing stream decode is not supported for images with palette or channel definitions");
+		return false;
+	}
+	return j2k_decode_update(p_jp2->j2k, p_stream, p_image);
+}
+
 }
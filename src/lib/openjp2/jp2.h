@@ -198,6 +198,8 @@ struct jp2_t {
 	uint32_t jp2_state;
 	uint32_t jp2_img_state;
 	jp2_color_t color;
+	/* channel definitions have been applied to the decoded image */
+	bool cdef_applied;
 
 	bool has_capture_resolution;
 	double capture_resolution[2];
@@ -297,6 +299,11 @@ bool jp2_start_compress(jp2_t *jp2, GrokStream *stream, grk_image_t *p_image);
  */
 bool jp2_end_compress(jp2_t *jp2, GrokStream *cio);
 
+/**
+ * Gets the statistics of the tiles compressed so far.
+ */
+bool jp2_get_compress_stats(jp2_t *jp2, grk_compress_stats_t *stats);
+
 /* ----------------------------------------------------------------------- */
 
 /**
@@ -392,6 +399,18 @@ void jp2_destroy(jp2_t *jp2);
 bool jp2_set_decode_area(jp2_t *p_jp2, grk_image_t *p_image, uint32_t start_x,
 		uint32_t start_y, uint32_t end_x, uint32_t end_y);
 
+/**
+ * Restricts the decode area to a set of areas within it (see j2k_set_decode_areas).
+ *
+ * @param  p_jp2      the jpeg2000 codec.
+ * @param  areas      areas, in reference grid coordinates
+ * @param  num_areas  number of areas
+ *
+ * @return  true      if the areas could be set.
+ */
+bool jp2_set_decode_areas(jp2_t *p_jp2, const grk_decode_area_t *areas,
+		uint32_t num_areas);
+
 /**
  *
  */
@@ -402,6 +421,24 @@ bool jp2_get_tile(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image, uint
  */
 bool jp2_set_decoded_resolution_factor(jp2_t *p_jp2, uint32_t res_factor);
 
+/**
+ * Refine a previously decoded image by decoding a different number of quality layers
+ *
+ * @param p_jp2			JP2 decoder
+ * @param p_image		image returned by previous decode
+ * @param num_layers	number of layers to decode (0 : all layers)
+ */
+bool jp2_decode_layers(jp2_t *p_jp2, grk_image_t *p_image, uint32_t num_layers);
+
+/**
+ * Continue decoding a growing codestream after more data has become available
+ *
+ * @param p_jp2			JP2 decoder
+ * @param p_stream		stream used for the previous decode
+ * @param p_image		image returned by previous decode
+ */
+bool jp2_decode_update(jp2_t *p_jp2, GrokStream *p_stream, grk_image_t *p_image);
+
 /**
  * Dump some elements from the JP2 decompression structure .
  *
@@ -176,18 +176,37 @@ static inline void mct_rev_sse2(int32_t *restrict chan0,
 								uint64_t ind)
 {
 	__m128i r, g, b;
-	__m128i y = _mm_load_si128((const __m128i*) &(chan0[ind]));
-	__m128i u = _mm_load_si128((const __m128i*) &(chan1[ind]));
-	__m128i v = _mm_load_si128((const __m128i*) &(chan2[ind]));
+	__m128i y = _mm_loadu_si128((const __m128i*) &(chan0[ind]));
+	__m128i u = _mm_loadu_si128((const __m128i*) &(chan1[ind]));
+	__m128i v = _mm_loadu_si128((const __m128i*) &(chan2[ind]));
 	g = y;
 	g = _mm_sub_epi32(g, _mm_srai_epi32(_mm_add_epi32(u, v), 2));
 	r = _mm_add_epi32(v, g);
 	b = _mm_add_epi32(u, g);
-	_mm_store_si128((__m128i*) &(chan0[ind]), r);
-	_mm_store_si128((__m128i*) &(chan1[ind]), g);
-	_mm_store_si128((__m128i*) &(chan2[ind]), b);
+	_mm_storeu_si128((__m128i*) &(chan0[ind]), r);
+	_mm_storeu_si128((__m128i*) &(chan1[ind]), g);
+	_mm_storeu_si128((__m128i*) &(chan2[ind]), b);
 }
 
+#ifdef __AVX2__
+static inline void mct_rev_avx2(int32_t *restrict chan0,
+								int32_t *restrict chan1,
+								int32_t *restrict chan2,
+								uint64_t ind)
+{
+	__m256i r, g, b;
+	__m256i y = _mm256_loadu_si256((const __m256i*) &(chan0[ind]));
+	__m256i u = _mm256_loadu_si256((const __m256i*) &(chan1[ind]));
+	__m256i v = _mm256_loadu_si256((const __m256i*) &(chan2[ind]));
+	g = _mm256_sub_epi32(y, _mm256_srai_epi32(_mm256_add_epi32(u, v), 2));
+	r = _mm256_add_epi32(v, g);
+	b = _mm256_add_epi32(u, g);
+	_mm256_storeu_si256((__m256i*) &(chan0[ind]), r);
+	_mm256_storeu_si256((__m256i*) &(chan1[ind]), g);
+	_mm256_storeu_si256((__m256i*) &(chan2[ind]), b);
+}
+#endif
+
 /* <summary> */
 /* Inverse reversible MCT. */
 /* </summary> */
@@ -195,8 +214,13 @@ void mct_decode(int32_t *restrict chan0, int32_t *restrict chan1,
 		int32_t *restrict chan2, uint64_t n) {
 	size_t i = 0;
 	const size_t len = n;
+#ifdef __AVX2__
+	for (; i < (len & ~(size_t) 7); i += 8) {
+		mct_rev_avx2(chan0,chan1,chan2,i);
+	}
+#endif
 #ifdef __SSE2__
-	for (i = 0; i < (len & ~3U); i += 4) {
+	for (; i < (len & ~3U); i += 4) {
 		mct_rev_sse2(chan0,chan1,chan2,i);
 	}
 #endif
@@ -212,6 +236,83 @@ void mct_decode(int32_t *restrict chan0, int32_t *restrict chan1,
 		chan2[i] = b;
 	}
 }
+/* <summary> */
+/* Inverse reversible MCT of 16 bit samples. */
+/* Results are computed in 32 bits and saturated to 16 bits:  */
+/* a saturated sample lies outside the range of the component  */
+/* precision, and is clamped to the same value by DC level     */
+/* shift as the exact result would be.                         */
+/* </summary> */
+void mct_decode_narrow(int16_t *restrict chan0, int16_t *restrict chan1,
+		int16_t *restrict chan2, uint64_t n) {
+	size_t i = 0;
+	const size_t len = n;
+#ifdef __AVX2__
+	for (; i < (len & ~(size_t) 15); i += 16) {
+		__m256i y = _mm256_loadu_si256((const __m256i*) &(chan0[i]));
+		__m256i u = _mm256_loadu_si256((const __m256i*) &(chan1[i]));
+		__m256i v = _mm256_loadu_si256((const __m256i*) &(chan2[i]));
+		__m256i r[2], g[2], b[2];
+		for (int k = 0; k < 2; ++k) {
+			__m128i y16 = k ? _mm256_extracti128_si256(y, 1) : _mm256_castsi256_si128(y);
+			__m128i u16 = k ? _mm256_extracti128_si256(u, 1) : _mm256_castsi256_si128(u);
+			__m128i v16 = k ? _mm256_extracti128_si256(v, 1) : _mm256_castsi256_si128(v);
+			__m256i y32 = _mm256_cvtepi16_epi32(y16);
+			__m256i u32 = _mm256_cvtepi16_epi32(u16);
+			__m256i v32 = _mm256_cvtepi16_epi32(v16);
+			g[k] = _mm256_sub_epi32(y32,
+					_mm256_srai_epi32(_mm256_add_epi32(u32, v32), 2));
+			r[k] = _mm256_add_epi32(v32, g[k]);
+			b[k] = _mm256_add_epi32(u32, g[k]);
+		}
+		// packs operates on 128 bit lanes, so restore sample order
+		_mm256_storeu_si256((__m256i*) &(chan0[i]),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(r[0], r[1]),
+						_MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_si256((__m256i*) &(chan1[i]),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(g[0], g[1]),
+						_MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_si256((__m256i*) &(chan2[i]),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(b[0], b[1]),
+						_MM_SHUFFLE(3, 1, 2, 0)));
+	}
+#endif
+#ifdef __SSE2__
+	for (; i < (len & ~(size_t) 7); i += 8) {
+		__m128i y = _mm_loadu_si128((const __m128i*) &(chan0[i]));
+		__m128i u = _mm_loadu_si128((const __m128i*) &(chan1[i]));
+		__m128i v = _mm_loadu_si128((const __m128i*) &(chan2[i]));
+		__m128i r[2], g[2], b[2];
+		for (int k = 0; k < 2; ++k) {
+			// sign extend to 32 bits
+			__m128i y32 = _mm_srai_epi32(
+					k ? _mm_unpackhi_epi16(y, y) : _mm_unpacklo_epi16(y, y), 16);
+			__m128i u32 = _mm_srai_epi32(
+					k ? _mm_unpackhi_epi16(u, u) : _mm_unpacklo_epi16(u, u), 16);
+			__m128i v32 = _mm_srai_epi32(
+					k ? _mm_unpackhi_epi16(v, v) : _mm_unpacklo_epi16(v, v), 16);
+			g[k] = _mm_sub_epi32(y32, _mm_srai_epi32(_mm_add_epi32(u32, v32), 2));
+			r[k] = _mm_add_epi32(v32, g[k]);
+			b[k] = _mm_add_epi32(u32, g[k]);
+		}
+		_mm_storeu_si128((__m128i*) &(chan0[i]), _mm_packs_epi32(r[0], r[1]));
+		_mm_storeu_si128((__m128i*) &(chan1[i]), _mm_packs_epi32(g[0], g[1]));
+		_mm_storeu_si128((__m128i*) &(chan2[i]), _mm_packs_epi32(b[0], b[1]));
+	}
+#endif
+	for (; i < len; ++i) {
+		int32_t y = chan0[i];
+		int32_t u = chan1[i];
+		int32_t v = chan2[i];
+		int32_t g = y - ((u + v) >> 2);
+		int32_t r = v + g;
+		int32_t b = u + g;
+		chan0[i] = (int16_t) int_clamp(r, INT16_MIN, INT16_MAX);
+		chan1[i] = (int16_t) int_clamp(g, INT16_MIN, INT16_MAX);
+		chan2[i] = (int16_t) int_clamp(b, INT16_MIN, INT16_MAX);
+	}
+}
+
 /* <summary> */
 /* Forward irreversible MCT. */
 /* </summary> */
@@ -374,30 +475,30 @@ void mct_decode_real(float *restrict c0, float *restrict c1, float *restrict c2,
 		__m128 vy, vu, vv;
 		__m128 vr, vg, vb;
 
-		vy = _mm_load_ps(c0);
-		vu = _mm_load_ps(c1);
-		vv = _mm_load_ps(c2);
+		vy = _mm_loadu_ps(c0);
+		vu = _mm_loadu_ps(c1);
+		vv = _mm_loadu_ps(c2);
 		vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
 		vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)),
 				_mm_mul_ps(vv, vgv));
 		vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
-		_mm_store_ps(c0, vr);
-		_mm_store_ps(c1, vg);
-		_mm_store_ps(c2, vb);
+		_mm_storeu_ps(c0, vr);
+		_mm_storeu_ps(c1, vg);
+		_mm_storeu_ps(c2, vb);
 		c0 += 4;
 		c1 += 4;
 		c2 += 4;
 
-		vy = _mm_load_ps(c0);
-		vu = _mm_load_ps(c1);
-		vv = _mm_load_ps(c2);
+		vy = _mm_loadu_ps(c0);
+		vu = _mm_loadu_ps(c1);
+		vv = _mm_loadu_ps(c2);
 		vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
 		vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)),
 				_mm_mul_ps(vv, vgv));
 		vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
-		_mm_store_ps(c0, vr);
-		_mm_store_ps(c1, vg);
-		_mm_store_ps(c2, vb);
+		_mm_storeu_ps(c0, vr);
+		_mm_storeu_ps(c1, vg);
+		_mm_storeu_ps(c2, vb);
 		c0 += 4;
 		c1 += 4;
 		c2 += 4;
@@ -88,6 +88,15 @@ void mct_encode(int32_t *c0, int32_t *c1, int32_t *c2, uint64_t n);
  @param n Number of samples for each component
  */
 void mct_decode(int32_t *c0, int32_t *c1, int32_t *c2, uint64_t n);
+/**
+ Apply a reversible multi-component inverse transform to 16 bit samples,
+ saturating the results
+ @param c0 Samples for luminance component
+ @param c1 Samples for red chrominance component
+ @param c2 Samples for blue chrominance component
+ @param n Number of samples for each component
+ */
+void mct_decode_narrow(int16_t *c0, int16_t *c1, int16_t *c2, uint64_t n);
 /**
  Get norm of the basis function used for the reversible multi-component transform
  @param compno Number of the component (0->Y, 1->U, 2->V)
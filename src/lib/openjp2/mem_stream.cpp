@@ -351,6 +351,8 @@ grk_stream_t* create_mapped_file_read_stream(const char *fname) {
 	grk_stream_set_user_data(l_stream, buffer_info,
 			(grk_stream_free_user_data_fn) mem_map_free);
 	set_up_buffer_stream(l_stream, buffer_info->len, p_is_read_stream);
+	/* grok_handle_t is a file handle on Windows, and a descriptor elsewhere */
+	((GrokStream*) l_stream)->m_identity = header_cache_file_identity(fd);
 
 	return l_stream;
 }
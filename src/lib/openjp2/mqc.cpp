@@ -63,8 +63,6 @@
 
 namespace grk {
 
-const uint16_t A_MIN = 0x8000;
-
 /**
  ERTERM mode switch (PTERM)
  @param mqc MQC handle
@@ -119,28 +117,11 @@ static void mqc_setbits(mqc_t *mqc);
  */
 static void mqc_setstate(mqc_t *mqc, uint8_t ctxno, uint8_t prob);
 
-/**
- FIXME DOC
- @param mqc MQC handle
- @return
- */
-static inline uint8_t mqc_mpsexchange(mqc_t *const mqc);
-/**
- FIXME DOC
- @param mqc MQC handle
- @return
- */
-static inline uint8_t mqc_lpsexchange(mqc_t *const mqc);
 /**
  Input a byte
  @param mqc MQC handle
  */
 static inline void mqc_bytein(mqc_t *const mqc);
-/**
- Renormalize mqc->A and mqc->C while decoding
- @param mqc MQC handle
- */
-static inline void mqc_renormd(mqc_t *const mqc);
 /*@}*/
 
 /*@}*/
@@ -307,33 +288,6 @@ static void mqc_setbits(mqc_t *mqc) {
 		mqc->C -= A_MIN;
 	}
 }
-static inline uint8_t mqc_mpsexchange(mqc_t *const mqc) {
-	uint8_t d;
-	auto curctx = mqc_states + mqc->ctxs[mqc->curctx];
-	if (mqc->A < (curctx->qeval & PROB_MASK)) {
-		d = (uint8_t) ((curctx->qeval>>MPS_SHIFT)^1);
-		mqc->ctxs[mqc->curctx] = curctx->nlps;
-	} else {
-		d = (uint8_t)(curctx->qeval>>MPS_SHIFT);
-		mqc->ctxs[mqc->curctx] = curctx->nmps;
-	}
-	return d;
-}
-static inline uint8_t mqc_lpsexchange(mqc_t *const mqc) {
-	uint8_t d;
-	auto curctx = mqc_states + mqc->ctxs[mqc->curctx];
-	auto qeval = (uint16_t)(curctx->qeval & PROB_MASK);
-	if (mqc->A < qeval) {
-		mqc->A = qeval;
-		d = (uint8_t)(curctx->qeval>>MPS_SHIFT);
-		mqc->ctxs[mqc->curctx] = curctx->nmps;
-	} else {
-		mqc->A = qeval;
-		d = (uint8_t) ((curctx->qeval>>MPS_SHIFT)^1);
-		mqc->ctxs[mqc->curctx] = curctx->nlps;
-	}
-	return d;
-}
 static void mqc_bytein(mqc_t *const mqc) {
 	uint8_t nextByte = mqc->bp[1];
 	if (mqc->currentByteIs0xFF) {
@@ -355,17 +309,6 @@ static void mqc_bytein(mqc_t *const mqc) {
 	}
 	mqc->currentByteIs0xFF = (nextByte == 0xFF);
 }
-static inline void mqc_renormd(mqc_t *const mqc) {
-	do {
-		if (mqc->COUNT == 0) {
-			mqc_bytein(mqc);
-		}
-		mqc->A = (uint16_t) (mqc->A << 1);
-		mqc->C = (mqc->C << 1);
-		mqc->COUNT--;
-	} while (mqc->A < A_MIN);
-}
-
 static void mqc_flush(mqc_t *mqc) {
 	mqc_setbits(mqc);
 	mqc->C <<= mqc->COUNT;
@@ -419,22 +362,7 @@ void raw_init_dec(raw_t *raw, uint8_t *bp, uint32_t len) {
 	raw->len = 0;
 	raw->C = 0;
 	raw->COUNT = 0;
-}
-uint8_t raw_decode(raw_t *raw) {
-	if (raw->COUNT == 0) {
-		raw->COUNT = 8;
-		if (raw->len == raw->lenmax) {
-			raw->C = 0xff;
-		} else {
-			if (raw->C == 0xff) {
-				raw->COUNT = 7;
-			}
-			raw->C = raw->start[raw->len];
-			raw->len++;
-		}
-	}
-	raw->COUNT--;
-	return ((uint32_t) raw->C >> raw->COUNT) & 0x01;
+	raw->lastByteIs0xFF = false;
 }
 void mqc_setcurctx(mqc_t *mqc, uint8_t ctxno) {
 #ifdef PLUGIN_DEBUG_ENCODE
@@ -613,21 +541,6 @@ void mqc_bypass_init_enc(mqc_t *mqc) {
 		mqc->COUNT = 7;
 	}
 }
-void mqc_bypass_enc(mqc_t *mqc, uint8_t d) {
-	mqc->COUNT--;
-	mqc->C += (uint32_t) d << mqc->COUNT;
-	if (mqc->COUNT == 0) {
-		mqc->bp++;
-		*mqc->bp = (uint8_t) mqc->C;
-		mqc->COUNT = 8;
-		// bit stuffing ensures that most significant bit equals zero
-		// for byte following 0xFF
-		if (*mqc->bp == 0xff) {
-			mqc->COUNT = 7;
-		}
-		mqc->C = 0;
-	}
-}
 
 void mqc_restart_init_enc(mqc_t *mqc) {
 	mqc_setcurctx(mqc, 0);
@@ -663,27 +576,9 @@ void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len) {
 	mqc->Q_SUM = 0;
 }
 uint8_t mqc_decode(mqc_t *const mqc) {
-	uint32_t Q_SUM = (uint16_t) (mqc->Q_SUM + ((mqc_states + mqc->ctxs[mqc->curctx])->qeval & PROB_MASK) );
-	if (mqc->MIN_A_C >= (uint16_t) Q_SUM) {
-		mqc->Q_SUM = (uint16_t) Q_SUM;
-		return (uint8_t)((mqc_states + mqc->ctxs[mqc->curctx])->qeval >> MPS_SHIFT);
-	}
-	mqc->A = (uint16_t) (mqc->A - Q_SUM);
-	Q_SUM <<= 8;
-	uint8_t d = 0;
-	if (mqc->C < Q_SUM) {
-		mqc->C -= (mqc->Q_SUM << 8);
-		d = mqc_lpsexchange(mqc);
-	} else {
-		mqc->C -= Q_SUM;
-		if (mqc->A < A_MIN) {
-			d = mqc_mpsexchange(mqc);
-		}
-	}
-	mqc_renormd(mqc);
-	mqc->MIN_A_C = std::min<uint16_t>((uint16_t) (mqc->A - A_MIN),
-			(uint16_t) (mqc->C >> 8));
-	mqc->Q_SUM = 0;
+	mqc_dec_t dec(mqc);
+	uint8_t d = dec.decode();
+	dec.store(mqc);
 	return d;
 }
 
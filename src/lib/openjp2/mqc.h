@@ -67,19 +67,20 @@ const unsigned int totalNumContextStates = 47 * 2;
 const uint16_t HIGH_BIT  = 0x8000;
 const uint16_t PROB_MASK = 0x7FFF;
 const uint16_t MPS_SHIFT = 15;
+const uint16_t A_MIN = 0x8000;
 
 
 struct raw_t {
-	/** temporary buffer where bits are coded or decoded */
-	uint8_t C;
-	/** number of bits already read or free to write */
-	uint8_t COUNT;
+	/** bit register: the next bit to decode is the most significant bit */
+	uint64_t C;
+	/** number of valid bits in the register */
+	uint32_t COUNT;
+	/** true if the last byte loaded into the register was 0xFF */
+	bool lastByteIs0xFF;
 	/** maximum length to decode */
 	uint32_t lenmax;
 	/** length decoded */
 	uint32_t len;
-	/** pointer to the current position in the buffer */
-	uint8_t *bp;
 	/** pointer to the start of the buffer */
 	uint8_t *start;
 };
@@ -102,12 +103,55 @@ void raw_destroy(raw_t *raw);
  @param len Length of the input buffer
  */
 void raw_init_dec(raw_t *raw, uint8_t *bp, uint32_t len);
+/**
+ Refill the raw decoder register with as many whole bytes as fit.
+ A byte following 0xFF only carries 7 bits (its stuffed
+ most significant bit is skipped), and past the end of the segment
+ the register is filled with 1 bits.
+ @param raw RAW handle
+ */
+inline void raw_fill(raw_t *raw) {
+	while (raw->COUNT <= 56) {
+		if (raw->len == raw->lenmax) {
+			raw->C |= ~(uint64_t) 0 >> raw->COUNT;
+			raw->COUNT = 64;
+			return;
+		}
+		uint8_t byte = raw->start[raw->len++];
+		uint32_t bits = raw->lastByteIs0xFF ? 7 : 8;
+		uint64_t val = raw->lastByteIs0xFF ? (byte & 0x7F) : byte;
+		raw->C |= val << (64 - raw->COUNT - bits);
+		raw->COUNT += bits;
+		raw->lastByteIs0xFF = (byte == 0xFF);
+	}
+}
 /**
  Decode a symbol using raw-decoder. Cfr p.506 TAUBMAN
  @param raw RAW handle
  @return the decoded symbol (0 or 1)
  */
-uint8_t raw_decode(raw_t *raw);
+inline uint8_t raw_decode(raw_t *raw) {
+	if (raw->COUNT == 0)
+		raw_fill(raw);
+	uint8_t d = (uint8_t) (raw->C >> 63);
+	raw->C <<= 1;
+	raw->COUNT--;
+	return d;
+}
+/**
+ Decode several raw symbols at once
+ @param raw RAW handle
+ @param n number of symbols to decode (between 1 and 32)
+ @return the decoded symbols, first symbol in the most significant position
+ */
+inline uint32_t raw_decode_bits(raw_t *raw, uint32_t n) {
+	if (raw->COUNT < n)
+		raw_fill(raw);
+	uint32_t d = (uint32_t) (raw->C >> (64 - n));
+	raw->C <<= n;
+	raw->COUNT -= n;
+	return d;
+}
 /* ----------------------------------------------------------------------- */
 
 /**
@@ -202,11 +246,24 @@ void mqc_bypass_init_enc(mqc_t *mqc);
 /**
  BYPASS mode switch, coding operation.
  JPEG 2000 p 505.
- <h2>Not fully implemented and tested !!</h2>
  @param mqc MQC handle
  @param d The symbol to be encoded (0 or 1)
  */
-void mqc_bypass_enc(mqc_t *mqc, uint8_t d);
+inline void mqc_bypass_enc(mqc_t *mqc, uint8_t d) {
+	mqc->COUNT--;
+	mqc->C += (uint32_t) d << mqc->COUNT;
+	if (mqc->COUNT == 0) {
+		mqc->bp++;
+		*mqc->bp = (uint8_t) mqc->C;
+		mqc->COUNT = 8;
+		// bit stuffing ensures that most significant bit equals zero
+		// for byte following 0xFF
+		if (*mqc->bp == 0xff) {
+			mqc->COUNT = 7;
+		}
+		mqc->C = 0;
+	}
+}
 
 /**
  RESTART mode switch (TERMALL) reinitialisation
@@ -233,5 +290,119 @@ void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len);
  */
 uint8_t mqc_decode(mqc_t *const mqc);
 
+/**
+ MQ decoder with its state held in local variables.
+
+ Load it from an mqc_t at the start of a coding pass, decode
+ with the inlined methods below, and store it back at the end of the pass,
+ so that C, A, COUNT and the byte pointer stay in registers instead
+ of going through mqc_t for every symbol.
+ Decoding is identical to mqc_decode.
+ */
+struct mqc_dec_t {
+	explicit mqc_dec_t(mqc_t *mqc) :
+			C(mqc->C), A(mqc->A), MIN_A_C(mqc->MIN_A_C), Q_SUM(mqc->Q_SUM), COUNT(
+					mqc->COUNT), currentByteIs0xFF(mqc->currentByteIs0xFF), bp(
+					mqc->bp), ctxs(mqc->ctxs), curctx(mqc->ctxs + mqc->curctx) {
+	}
+	void store(mqc_t *mqc) const {
+		mqc->C = C;
+		mqc->A = A;
+		mqc->MIN_A_C = MIN_A_C;
+		mqc->Q_SUM = Q_SUM;
+		mqc->COUNT = COUNT;
+		mqc->currentByteIs0xFF = currentByteIs0xFF;
+		mqc->bp = bp;
+		mqc->curctx = (uint8_t) (curctx - ctxs);
+	}
+	inline void setcurctx(uint8_t ctxno) {
+		curctx = ctxs + ctxno;
+	}
+	inline uint8_t decode() {
+		auto state = mqc_states + *curctx;
+		uint32_t qsum = (uint16_t) (Q_SUM + (state->qeval & PROB_MASK));
+		if (MIN_A_C >= (uint16_t) qsum) {
+			Q_SUM = (uint16_t) qsum;
+			return (uint8_t) (state->qeval >> MPS_SHIFT);
+		}
+		A = (uint16_t) (A - qsum);
+		qsum <<= 8;
+		uint8_t d = 0;
+		if (C < qsum) {
+			C -= ((uint32_t) Q_SUM << 8);
+			d = lpsexchange(state);
+		} else {
+			C -= qsum;
+			if (A < A_MIN)
+				d = mpsexchange(state);
+		}
+		renormd();
+		uint16_t a_minus = (uint16_t) (A - A_MIN);
+		uint16_t c_high = (uint16_t) (C >> 8);
+		MIN_A_C = a_minus < c_high ? a_minus : c_high;
+		Q_SUM = 0;
+		return d;
+	}
+
+	uint32_t C;
+	uint16_t A;
+	uint16_t MIN_A_C;
+	uint16_t Q_SUM;
+	uint8_t COUNT;
+	uint8_t currentByteIs0xFF;
+	uint8_t *bp;
+	uint8_t *ctxs;
+	uint8_t *curctx;
+private:
+	inline uint8_t mpsexchange(const mqc_state_t *state) {
+		if (A < (state->qeval & PROB_MASK)) {
+			*curctx = state->nlps;
+			return (uint8_t) ((state->qeval >> MPS_SHIFT) ^ 1);
+		}
+		*curctx = state->nmps;
+		return (uint8_t) (state->qeval >> MPS_SHIFT);
+	}
+	inline uint8_t lpsexchange(const mqc_state_t *state) {
+		auto qeval = (uint16_t) (state->qeval & PROB_MASK);
+		bool lps = A >= qeval;
+		A = qeval;
+		if (lps) {
+			*curctx = state->nlps;
+			return (uint8_t) ((state->qeval >> MPS_SHIFT) ^ 1);
+		}
+		*curctx = state->nmps;
+		return (uint8_t) (state->qeval >> MPS_SHIFT);
+	}
+	inline void bytein() {
+		uint8_t nextByte = bp[1];
+		if (currentByteIs0xFF) {
+			if (nextByte > 0x8F) {
+				// termination marker - synthesize 1's in C register and do not increment bp
+				C += 0xFF;
+				COUNT = 8;
+			} else {
+				// bit stuff next byte and add to C register
+				bp++;
+				C += (uint32_t) nextByte << 1;
+				COUNT = 7;
+			}
+		} else {
+			bp++;
+			C += nextByte;
+			COUNT = 8;
+		}
+		currentByteIs0xFF = (nextByte == 0xFF);
+	}
+	inline void renormd() {
+		do {
+			if (COUNT == 0)
+				bytein();
+			A = (uint16_t) (A << 1);
+			C <<= 1;
+			COUNT--;
+		} while (A < A_MIN);
+	}
+};
+
 }
 
@@ -141,6 +141,39 @@ void seg_buf_t::add_segment(buf_t *seg) {
 	data_len += seg->len;
 }
 
+bool seg_buf_t::append_to_last_segment(const uint8_t *buf, size_t len) {
+	if (segments.empty())
+		return false;
+	buf_t *seg = segments.back();
+	uint8_t *new_buf = nullptr;
+	try {
+		new_buf = new uint8_t[seg->len + len];
+	} catch (std::bad_alloc &ex) {
+		return false;
+	}
+	if (seg->len)
+		memcpy(new_buf, seg->buf, seg->len);
+	memcpy(new_buf + seg->len, buf, len);
+	if (seg->owns_data)
+		delete[] seg->buf;
+	seg->buf = new_buf;
+	seg->len += len;
+	seg->owns_data = true;
+	data_len += len;
+	return true;
+}
+
+bool seg_buf_t::trim_last_segment(size_t len) {
+	if (segments.empty())
+		return false;
+	buf_t *seg = segments.back();
+	if (seg->len < len)
+		return false;
+	seg->len -= len;
+	data_len -= len;
+	return true;
+}
+
 void seg_buf_t::cleanup(void) {
 	size_t i;
 	for (i = 0; i < segments.size(); ++i) {
@@ -92,6 +92,17 @@ struct seg_buf_t {
 	buf_t* add_segment(uint8_t *buf, size_t len, bool ownsData);
 	void add_segment(buf_t *seg);
 
+	/*
+	 Copy len bytes onto the end of the last segment, so that
+	 the last segment remains contiguous
+	 */
+	bool append_to_last_segment(const uint8_t *buf, size_t len);
+
+	/*
+	 Remove len bytes from the end of the last segment
+	 */
+	bool trim_last_segment(size_t len);
+
 	/*
 	 Copy all segments, in sequence, into contiguous array
 	 */
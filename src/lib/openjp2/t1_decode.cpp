@@ -575,7 +575,7 @@ bool t1_decode::decode_cblk(tcd_cblk_dec_t *cblk, uint8_t orient,
 			mqc_init_dec(mqc, compressed_block + seg->dataindex, seg->len);
 		}
 		for (uint32_t passno = 0;
-				(passno < seg->numpasses) && (bpno_plus_one >= 1); ++passno) {
+				(passno < seg->numPassesRead) && (bpno_plus_one >= 1); ++passno) {
 			switch (passtype) {
 			case 0:
 				if (type == T1_TYPE_RAW) {
@@ -641,7 +641,19 @@ void t1_decode::postDecode(decodeBlockInfo *block) {
 
 	//dequantization
 	uint32_t tile_width = block->tilec->x1 - block->tilec->x0;
-	if (block->qmfbid == 1) {
+	if (block->tilec->buf->narrow) {
+		int16_t *restrict tile_data = tile_buf_get_narrow_ptr(
+				block->tilec->buf, block->resno, block->bandno, block->x,
+				block->y);
+		for (auto j = 0U; j < h; ++j) {
+			int16_t *restrict tile_row_data = tile_data;
+			for (auto i = 0U; i < w; ++i) {
+				tile_row_data[i] = (int16_t) (*t1_data / 2);
+				t1_data++;
+			}
+			tile_data += tile_width;
+		}
+	} else if (block->qmfbid == 1) {
 		int32_t *restrict tile_data = block->tiledp;
 		for (auto j = 0U; j < h; ++j) {
 			int32_t *restrict tile_row_data = tile_data;
@@ -53,7 +53,7 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-#include "grok_includes.h"
+#include "CPUArch.h"
 
 // tier 1 interface
 #include "mqc.h"
@@ -65,7 +65,7 @@ namespace grk {
 
 t1_decode_opt::t1_decode_opt(uint16_t code_block_width,
 		uint16_t code_block_height) :
-		t1_decode_base(code_block_width, code_block_height) {
+		t1_decode_base(code_block_width, code_block_height), empty_cblk(false) {
 	if (!allocateBuffers(code_block_width, code_block_height))
 		throw std::exception();
 }
@@ -104,21 +104,22 @@ void t1_decode_opt::initBuffers(uint16_t cblkw, uint16_t cblkh) {
 
 }
 
-inline void t1_decode_opt::sigpass_step(flag_opt_t *flagsp, int32_t *datap,
-		uint8_t orient, int32_t oneplushalf, uint32_t maxci3,
+inline void t1_decode_opt::sigpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+		int32_t *datap, uint8_t orient, int32_t oneplushalf, uint32_t maxci3,
 		uint32_t mode_switch) {
 	for (uint32_t ci3 = 0U; ci3 < maxci3; ci3 += 3) {
 		flag_opt_t const shift_flags = *flagsp >> ci3;
 		if ((shift_flags & (T1_SIGMA_CURRENT | T1_PI_CURRENT)) == 0U
 				&& (shift_flags & T1_SIGMA_NEIGHBOURS) != 0U) {
-			mqc_setcurctx(mqc, getZeroCodingContext(shift_flags, orient));
-			if (mqc_decode(mqc)) {
+			dec.setcurctx(getZeroCodingContext(shift_flags, orient));
+			if (dec.decode()) {
 				uint32_t lu = getSignCodingOrSPPByteIndex(*flagsp, flagsp[-1],
 						flagsp[1], ci3);
-				mqc_setcurctx(mqc, getSignCodingContext(lu));
-				uint8_t v = mqc_decode(mqc) ^ getSPByte(lu);
+				dec.setcurctx(getSignCodingContext(lu));
+				uint8_t v = dec.decode() ^ getSPByte(lu);
 				*datap = v ? -oneplushalf : oneplushalf;
-				updateFlags(flagsp, ci3, v, flags_stride,0);
+				updateFlags(flagsp, ci3, v, flags_stride,
+						(mode_switch & J2K_CCP_CBLKSTY_VSC) ? 1 : 0);
 			}
 			/* set propagation pass bit for this location */
 			*flagsp |= T1_PI_CURRENT << ci3;
@@ -139,10 +140,11 @@ void t1_decode_opt::sigpass(int32_t bpno, uint8_t orient,
 
 	flag_opt_t *f = FLAGS_ADDRESS(0, 0);
 	int32_t *d = dataPtr;
+	mqc_dec_t dec(mqc);
 	for (k = 0; k < (h & ~3U); k += 4) {
 		for (i = 0; i < w; ++i) {
 			if (*f) {
-				sigpass_step(f, d, orient, oneplushalf, 12, mode_switch);
+				sigpass_step(dec, f, d, orient, oneplushalf, 12, mode_switch);
 			}
 			++f;
 			++d;
@@ -153,24 +155,25 @@ void t1_decode_opt::sigpass(int32_t bpno, uint8_t orient,
 	if (k < h) {
 		for (i = 0; i < w; ++i) {
 			if (*f) {
-				sigpass_step(f, d, orient, oneplushalf, (h - k) * 3,
+				sigpass_step(dec, f, d, orient, oneplushalf, (h - k) * 3,
 						mode_switch);
 			}
 			++f;
 			++d;
 		}
 	}
+	dec.store(mqc);
 }
-inline void t1_decode_opt::refpass_step(flag_opt_t *flagsp, int32_t *datap,
-		int32_t poshalf, uint32_t maxci3) {
+inline void t1_decode_opt::refpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+		int32_t *datap, int32_t poshalf, uint32_t maxci3) {
 
 	for (uint32_t ci3 = 0U; ci3 < maxci3; ci3 += 3) {
 		uint32_t shift_flags = *flagsp >> ci3;
 		/* if location is significant, but has not been coded in significance propagation pass, then code in this pass: */
 		if ((shift_flags & (T1_SIGMA_CURRENT | T1_PI_CURRENT))
 				== T1_SIGMA_CURRENT) {
-			mqc_setcurctx(mqc, getMRPContext(shift_flags));
-			uint8_t v = mqc_decode(mqc);
+			dec.setcurctx(getMRPContext(shift_flags));
+			uint8_t v = dec.decode();
 			*datap += (v ^ (*datap < 0)) ? poshalf : -poshalf;
 			/* flip magnitude refinement bit*/
 			*flagsp |= T1_MU_CURRENT << ci3;
@@ -185,11 +188,12 @@ void t1_decode_opt::refpass(int32_t bpno) {
 	uint32_t const flag_row_extra = flags_stride - w;
 	uint32_t const data_row_extra = (w << 2) - w;
 	int32_t *d = dataPtr;
+	mqc_dec_t dec(mqc);
 	uint32_t i, k;
 	for (k = 0U; k < (h & ~3); k += 4U) {
 		for (i = 0U; i < w; ++i) {
 			if (*f) {
-				refpass_step(f, d, poshalf, 12);
+				refpass_step(dec, f, d, poshalf, 12);
 			}
 			++f;
 			++d;
@@ -199,16 +203,17 @@ void t1_decode_opt::refpass(int32_t bpno) {
 	}
 	if (k < h) {
 		for (uint32_t i = 0; i < w; ++i) {
-			refpass_step(f, d, poshalf, (h - k) * 3);
+			refpass_step(dec, f, d, poshalf, (h - k) * 3);
 			++f;
 			++d;
 		}
 	}
+	dec.store(mqc);
 }
 
-void t1_decode_opt::clnpass_step(flag_opt_t *flagsp, int32_t *datap,
-		uint8_t orient, int32_t oneplushalf, uint32_t agg, uint32_t runlen,
-		uint32_t y, uint32_t mode_switch) {
+inline void t1_decode_opt::clnpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+		int32_t *datap, uint8_t orient, int32_t oneplushalf, uint32_t agg,
+		uint32_t runlen, uint32_t y, uint32_t mode_switch) {
 
 	const uint32_t check = (T1_SIGMA_4 | T1_SIGMA_7 | T1_SIGMA_10 | T1_SIGMA_13
 			| T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3);
@@ -234,17 +239,18 @@ void t1_decode_opt::clnpass_step(flag_opt_t *flagsp, int32_t *datap,
 		} else {
 			shift_flags = *flagsp >> ci3;
 			if (!(shift_flags & (T1_SIGMA_CURRENT | T1_PI_CURRENT))) {
-				mqc_setcurctx(mqc, getZeroCodingContext(shift_flags, orient));
-				signCoding = mqc_decode(mqc);
+				dec.setcurctx(getZeroCodingContext(shift_flags, orient));
+				signCoding = dec.decode();
 			}
 		}
 		if (signCoding) {
 			uint32_t lu = getSignCodingOrSPPByteIndex(*flagsp, flagsp[-1],
 					flagsp[1], ci3);
-			mqc_setcurctx(mqc, getSignCodingContext(lu));
-			uint8_t v = mqc_decode(mqc) ^ getSPByte(lu);
+			dec.setcurctx(getSignCodingContext(lu));
+			uint8_t v = dec.decode() ^ getSPByte(lu);
 			*datap = v ? -oneplushalf : oneplushalf;
-			updateFlags(flagsp, ci3, v, flags_stride,0);
+			updateFlags(flagsp, ci3, v, flags_stride,
+					(mode_switch & J2K_CCP_CBLKSTY_VSC) ? 1 : 0);
 		}
 		*flagsp &= ~(T1_PI_0 << ci3);
 		datap += w;
@@ -258,37 +264,152 @@ void t1_decode_opt::clnpass(int32_t bpno, uint8_t orient,
 	oneplushalf = one | half;
 	uint32_t k;
 	uint32_t agg, runlen;
+	mqc_dec_t dec(mqc);
 	for (k = 0; k < (h & ~3); k += 4) {
 		for (uint32_t i = 0; i < w; ++i) {
 			agg = !flags[i + 1 + ((k >> 2) + 1) * flags_stride];
 			if (agg) {
-				mqc_setcurctx(mqc, T1_CTXNO_AGG);
-				if (!mqc_decode(mqc)) {
+				dec.setcurctx(T1_CTXNO_AGG);
+				if (!dec.decode()) {
 					continue;
 				}
-				mqc_setcurctx(mqc, T1_CTXNO_UNI);
-				runlen = mqc_decode(mqc);
-				runlen = (uint8_t) (runlen << 1) | mqc_decode(mqc);
+				dec.setcurctx(T1_CTXNO_UNI);
+				runlen = dec.decode();
+				runlen = (uint8_t) (runlen << 1) | dec.decode();
 			} else {
 				runlen = 0;
 			}
-			clnpass_step(FLAGS_ADDRESS(i, k), dataPtr + ((k + runlen) * w) + i,
-					orient, oneplushalf, agg, runlen, k, mode_switch);
+			clnpass_step(dec, FLAGS_ADDRESS(i, k),
+					dataPtr + ((k + runlen) * w) + i, orient, oneplushalf, agg,
+					runlen, k, mode_switch);
 		}
 	}
 	if (k < h) {
 		for (uint32_t i = 0; i < w; ++i) {
-			clnpass_step(FLAGS_ADDRESS(i, k), dataPtr + (k * w) + i, orient,
-					oneplushalf, 0, 0, k, mode_switch);
+			clnpass_step(dec, FLAGS_ADDRESS(i, k), dataPtr + (k * w) + i,
+					orient, oneplushalf, 0, 0, k, mode_switch);
 		}
 	}
+	if (mode_switch & J2K_CCP_CBLKSTY_SEGSYM) {
+		// segmentation symbol : decoded and ignored
+		dec.setcurctx(T1_CTXNO_UNI);
+		dec.decode();
+		dec.decode();
+		dec.decode();
+		dec.decode();
+	}
+	dec.store(mqc);
+}
+inline void t1_decode_opt::sigpass_step_raw(raw_t &r, flag_opt_t *flagsp,
+		int32_t *datap, int32_t oneplushalf, uint32_t maxci3, uint8_t vsc) {
+	for (uint32_t ci3 = 0U; ci3 < maxci3; ci3 += 3) {
+		flag_opt_t const shift_flags = *flagsp >> ci3;
+		if ((shift_flags & (T1_SIGMA_CURRENT | T1_PI_CURRENT)) == 0U
+				&& (shift_flags & T1_SIGMA_NEIGHBOURS) != 0U) {
+			if (raw_decode(&r)) {
+				uint8_t v = raw_decode(&r);
+				*datap = v ? -oneplushalf : oneplushalf;
+				updateFlags(flagsp, ci3, v, flags_stride, vsc);
+			}
+			*flagsp |= T1_PI_CURRENT << ci3;
+		}
+		datap += w;
+	}
+}
+void t1_decode_opt::sigpass_raw(int32_t bpno, uint32_t mode_switch) {
+	int32_t one = 1 << bpno;
+	int32_t half = one >> 1;
+	int32_t oneplushalf = one | half;
+	uint8_t vsc = (mode_switch & J2K_CCP_CBLKSTY_VSC) ? 1 : 0;
+	uint32_t const flag_row_extra = flags_stride - w;
+	uint32_t const data_row_extra = (w << 2) - w;
+	flag_opt_t *f = FLAGS_ADDRESS(0, 0);
+	int32_t *d = dataPtr;
+	uint32_t i, k;
+	// work on a local copy so that the bit register stays in registers
+	raw_t r = *raw;
+	for (k = 0; k < (h & ~3U); k += 4) {
+		for (i = 0; i < w; ++i) {
+			if (*f)
+				sigpass_step_raw(r, f, d, oneplushalf, 12, vsc);
+			++f;
+			++d;
+		}
+		d += data_row_extra;
+		f += flag_row_extra;
+	}
+	if (k < h) {
+		for (i = 0; i < w; ++i) {
+			if (*f)
+				sigpass_step_raw(r, f, d, oneplushalf, (h - k) * 3, vsc);
+			++f;
+			++d;
+		}
+	}
+	*raw = r;
+}
+inline void t1_decode_opt::refpass_step_raw(raw_t &r, flag_opt_t *flagsp,
+		int32_t *datap, int32_t poshalf, uint32_t maxci3) {
+	// find the samples of this stripe column that need refinement,
+	// then fetch all of their bits from the register at once
+	uint32_t refine = 0;
+	uint32_t n = 0;
+	for (uint32_t ci3 = 0U; ci3 < maxci3; ci3 += 3) {
+		if (((*flagsp >> ci3) & (T1_SIGMA_CURRENT | T1_PI_CURRENT))
+				== T1_SIGMA_CURRENT) {
+			refine |= 1U << ci3;
+			n++;
+		}
+	}
+	if (!n)
+		return;
+	uint32_t bits = raw_decode_bits(&r, n);
+	for (uint32_t ci3 = 0U; ci3 < maxci3; ci3 += 3) {
+		if (refine & (1U << ci3)) {
+			uint32_t v = (bits >> --n) & 1;
+			*datap += (v ^ (*datap < 0)) ? poshalf : -poshalf;
+			*flagsp |= T1_MU_CURRENT << ci3;
+		}
+		datap += w;
+	}
+}
+void t1_decode_opt::refpass_raw(int32_t bpno) {
+	int32_t one = 1 << bpno;
+	int32_t poshalf = one >> 1;
+	uint32_t const flag_row_extra = flags_stride - w;
+	uint32_t const data_row_extra = (w << 2) - w;
+	flag_opt_t *f = FLAGS_ADDRESS(0, 0);
+	int32_t *d = dataPtr;
+	uint32_t i, k;
+	raw_t r = *raw;
+	for (k = 0; k < (h & ~3U); k += 4) {
+		for (i = 0; i < w; ++i) {
+			if (*f)
+				refpass_step_raw(r, f, d, poshalf, 12);
+			++f;
+			++d;
+		}
+		d += data_row_extra;
+		f += flag_row_extra;
+	}
+	if (k < h) {
+		for (i = 0; i < w; ++i) {
+			refpass_step_raw(r, f, d, poshalf, (h - k) * 3);
+			++f;
+			++d;
+		}
+	}
+	*raw = r;
 }
 bool t1_decode_opt::decode_cblk(tcd_cblk_dec_t *cblk, uint8_t orient,
 		uint32_t mode_switch) {
+	// empty code block: nothing to decode, and postDecode
+	// writes zeros directly, so buffers need not be cleared
+	empty_cblk = !cblk->seg_buffers.get_len();
+	if (empty_cblk)
+		return true;
 	initBuffers((uint16_t) (cblk->x1 - cblk->x0),
 			(uint16_t) (cblk->y1 - cblk->y0));
-	if (!cblk->seg_buffers.get_len())
-		return true;
 	if (!allocCompressed(cblk))
 		return false;
 	int32_t bpno_plus_one = (int32_t) (cblk->numbps);
@@ -299,20 +420,38 @@ bool t1_decode_opt::decode_cblk(tcd_cblk_dec_t *cblk, uint8_t orient,
 		uint32_t synthOffset = seg->dataindex + seg->len;
 		uint16_t stash = *((uint16_t*) (compressed_block + synthOffset));
 		*((uint16_t*) (compressed_block + synthOffset)) = synthBytes;
-		mqc_init_dec(mqc, compressed_block + seg->dataindex, seg->len);
+		// BYPASS: significance and refinement passes below the fourth
+		// most significant bit plane are raw coded
+		uint8_t type =
+				((bpno_plus_one <= ((int32_t) (cblk->numbps)) - 4)
+						&& (passtype < 2)
+						&& (mode_switch & J2K_CCP_CBLKSTY_LAZY)) ?
+						T1_TYPE_RAW : T1_TYPE_MQ;
+		if (type == T1_TYPE_RAW)
+			raw_init_dec(raw, compressed_block + seg->dataindex, seg->len);
+		else
+			mqc_init_dec(mqc, compressed_block + seg->dataindex, seg->len);
 		for (uint32_t passno = 0;
-				(passno < seg->numpasses) && (bpno_plus_one >= 1); ++passno) {
+				(passno < seg->numPassesRead) && (bpno_plus_one >= 1); ++passno) {
 			switch (passtype) {
 			case 0:
-				sigpass(bpno_plus_one, orient, mode_switch);
+				if (type == T1_TYPE_RAW)
+					sigpass_raw(bpno_plus_one, mode_switch);
+				else
+					sigpass(bpno_plus_one, orient, mode_switch);
 				break;
 			case 1:
-				refpass(bpno_plus_one);
+				if (type == T1_TYPE_RAW)
+					refpass_raw(bpno_plus_one);
+				else
+					refpass(bpno_plus_one);
 				break;
 			case 2:
 				clnpass(bpno_plus_one, orient, mode_switch);
 				break;
 			}
+			if ((mode_switch & J2K_CCP_CBLKSTY_RESET) && type == T1_TYPE_MQ)
+				mqc_resetstates(mqc);
 			if (++passtype == 3) {
 				passtype = 0;
 				bpno_plus_one--;
@@ -323,47 +462,189 @@ bool t1_decode_opt::decode_cblk(tcd_cblk_dec_t *cblk, uint8_t orient,
 	return true;
 }
 
-void t1_decode_opt::postDecode(decodeBlockInfo *block) {
-	auto t1_data = dataPtr;
-	// ROI shift
-	if (block->roishift) {
-		int32_t threshold = 1 << block->roishift;
-		for (auto j = 0U; j < h; ++j) {
-			for (auto i = 0U; i < w; ++i) {
-				auto value = *t1_data;
-				auto magnitude = abs(value);
-				if (magnitude >= threshold) {
-					magnitude >>= block->roishift;
-					// ((value > 0) - (value < 0)) == signum(value)
-					*t1_data = ((value > 0) - (value < 0)) * magnitude;
-				}
-				t1_data++;
-			}
+void t1_decode_opt::postDecodeEmpty(decodeBlockInfo *block) {
+	auto cblk = block->cblk;
+	uint32_t cblk_w = cblk->x1 - cblk->x0;
+	uint32_t cblk_h = cblk->y1 - cblk->y0;
+	uint32_t tile_width = block->tilec->x1 - block->tilec->x0;
+	if (block->tilec->buf->narrow) {
+		int16_t *restrict tile_data = tile_buf_get_narrow_ptr(
+				block->tilec->buf, block->resno, block->bandno, block->x,
+				block->y);
+		for (auto j = 0U; j < cblk_h; ++j) {
+			memset(tile_data, 0, cblk_w * sizeof(int16_t));
+			tile_data += tile_width;
 		}
-		//reset t1_data to start of buffer
-		t1_data = dataPtr;
+		return;
+	}
+	// zero bits are zero in both the integer and the float tile buffer
+	static_assert(sizeof(float) == sizeof(int32_t), "float must be 32 bits");
+	int32_t *restrict tile_data = block->tiledp;
+	for (auto j = 0U; j < cblk_h; ++j) {
+		memset(tile_data, 0, cblk_w * sizeof(int32_t));
+		tile_data += tile_width;
 	}
+}
 
-	//dequantization
+/*
+ Undo the ROI shift of one sample: magnitudes at or above the threshold
+ belong to the region of interest and are scaled back down.
+ */
+static inline int32_t roi_unshift(int32_t value, int32_t threshold,
+		uint32_t roishift) {
+	auto magnitude = abs(value);
+	if (!roishift || magnitude < threshold)
+		return value;
+	magnitude >>= roishift;
+	// ((value > 0) - (value < 0)) == signum(value)
+	return ((value > 0) - (value < 0)) * magnitude;
+}
+
+#ifdef __AVX2__
+static inline __m256i roi_unshift_avx2(__m256i value, __m256i threshold,
+		uint32_t roishift) {
+	__m256i magnitude = _mm256_abs_epi32(value);
+	__m256i below = _mm256_cmpgt_epi32(threshold, magnitude);
+	__m256i shifted = _mm256_sign_epi32(
+			_mm256_srai_epi32(magnitude, (int) roishift), value);
+	return _mm256_blendv_epi8(shifted, value, below);
+}
+#endif
+
+/*
+ ROI un-shift and halve one row of reversible coefficients,
+ writing the result to the tile buffer.
+ Division truncates towards zero, as in the scalar code.
+ */
+static void postDecodeRowReversible(const int32_t *restrict src,
+		int32_t *restrict dst, uint32_t w, int32_t threshold,
+		uint32_t roishift) {
+	uint32_t i = 0;
+#ifdef __AVX2__
+	const __m256i vthresh = _mm256_set1_epi32(threshold);
+	for (; i + 8 <= w; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+		if (roishift)
+			v = roi_unshift_avx2(v, vthresh, roishift);
+		v = _mm256_srai_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(v, 31)),
+				1);
+		_mm256_storeu_si256((__m256i*) (dst + i), v);
+	}
+#endif
+#ifdef __SSE2__
+	if (!roishift) {
+		for (; i + 4 <= w; i += 4) {
+			__m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+			v = _mm_srai_epi32(_mm_add_epi32(v, _mm_srli_epi32(v, 31)), 1);
+			_mm_storeu_si128((__m128i*) (dst + i), v);
+		}
+	}
+#endif
+	for (; i < w; ++i)
+		dst[i] = roi_unshift(src[i], threshold, roishift) / 2;
+}
+
+/*
+ Halve one row of reversible coefficients, writing the result to a
+ narrow (16 bit) tile buffer. Narrow tiles have no ROI shift, and all
+ their sub-band magnitudes fit in 13 bits, so packing never saturates.
+ */
+static void postDecodeRowNarrow(const int32_t *restrict src,
+		int16_t *restrict dst, uint32_t w) {
+	uint32_t i = 0;
+#ifdef __AVX2__
+	for (; i + 16 <= w; i += 16) {
+		__m256i lo = _mm256_loadu_si256((const __m256i*) (src + i));
+		__m256i hi = _mm256_loadu_si256((const __m256i*) (src + i + 8));
+		lo = _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_srli_epi32(lo, 31)),
+				1);
+		hi = _mm256_srai_epi32(_mm256_add_epi32(hi, _mm256_srli_epi32(hi, 31)),
+				1);
+		// packs operates on 128 bit lanes, so restore sample order
+		_mm256_storeu_si256((__m256i*) (dst + i),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+						_MM_SHUFFLE(3, 1, 2, 0)));
+	}
+#endif
+#ifdef __SSE2__
+	for (; i + 8 <= w; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i*) (src + i));
+		__m128i hi = _mm_loadu_si128((const __m128i*) (src + i + 4));
+		lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_srli_epi32(lo, 31)), 1);
+		hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_srli_epi32(hi, 31)), 1);
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < w; ++i)
+		dst[i] = (int16_t) (src[i] / 2);
+}
+
+/*
+ ROI un-shift and dequantize one row of irreversible coefficients,
+ writing the result to the tile buffer.
+ */
+static void postDecodeRowIrreversible(const int32_t *restrict src,
+		float *restrict dst, uint32_t w, float stepsize, int32_t threshold,
+		uint32_t roishift) {
+	uint32_t i = 0;
+#ifdef __AVX2__
+	const __m256i vthresh = _mm256_set1_epi32(threshold);
+	const __m256 vstep = _mm256_set1_ps(stepsize);
+	for (; i + 8 <= w; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (src + i));
+		if (roishift)
+			v = roi_unshift_avx2(v, vthresh, roishift);
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), vstep));
+	}
+#endif
+#ifdef __SSE2__
+	if (!roishift) {
+		const __m128 vstep4 = _mm_set1_ps(stepsize);
+		for (; i + 4 <= w; i += 4) {
+			__m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), vstep4));
+		}
+	}
+#endif
+	for (; i < w; ++i)
+		dst[i] = (float) roi_unshift(src[i], threshold, roishift) * stepsize;
+}
+
+void t1_decode_opt::postDecode(decodeBlockInfo *block) {
+	if (empty_cblk) {
+		postDecodeEmpty(block);
+		return;
+	}
+	// ROI un-shift, then halving (reversible) or dequantization
+	// (irreversible), fused into a single pass over each row,
+	// writing straight into the tile buffer
+	auto t1_data = dataPtr;
+	uint32_t roishift = block->roishift;
+	int32_t threshold = roishift ? 1 << roishift : 0;
 	uint32_t tile_width = block->tilec->x1 - block->tilec->x0;
-	if (block->qmfbid == 1) {
+	if (block->tilec->buf->narrow) {
+		int16_t *restrict tile_data = tile_buf_get_narrow_ptr(
+				block->tilec->buf, block->resno, block->bandno, block->x,
+				block->y);
+		for (auto j = 0U; j < h; ++j) {
+			postDecodeRowNarrow(t1_data, tile_data, w);
+			t1_data += w;
+			tile_data += tile_width;
+		}
+	} else if (block->qmfbid == 1) {
 		int32_t *restrict tile_data = block->tiledp;
 		for (auto j = 0U; j < h; ++j) {
-			int32_t *restrict tile_row_data = tile_data;
-			for (auto i = 0U; i < w; ++i) {
-				tile_row_data[i] = *t1_data / 2;
-				t1_data++;
-			}
+			postDecodeRowReversible(t1_data, tile_data, w, threshold,
+					roishift);
+			t1_data += w;
 			tile_data += tile_width;
 		}
 	} else {
 		float *restrict tile_data = (float*) block->tiledp;
 		for (auto j = 0U; j < h; ++j) {
-			float *restrict tile_row_data = tile_data;
-			for (auto i = 0U; i < w; ++i) {
-				tile_row_data[i] = (float) *t1_data * block->stepsize;
-				t1_data++;
-			}
+			postDecodeRowIrreversible(t1_data, tile_data, w, block->stepsize,
+					threshold, roishift);
+			t1_data += w;
 			tile_data += tile_width;
 		}
 	}
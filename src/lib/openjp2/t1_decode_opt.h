@@ -61,6 +61,7 @@
 namespace grk {
 
 struct mqc_t;
+struct mqc_dec_t;
 struct raw_t;
 
 class t1_decode_base;
@@ -84,16 +85,27 @@ public:
 private:
 	bool allocateBuffers(uint16_t w, uint16_t h);
 	void initBuffers(uint16_t w, uint16_t h);
-	inline void sigpass_step(flag_opt_t *flagsp, int32_t *datap, uint8_t orient,
-			int32_t oneplushalf, uint32_t maxci3, uint32_t mode_switch);
+	inline void sigpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+			int32_t *datap, uint8_t orient, int32_t oneplushalf,
+			uint32_t maxci3, uint32_t mode_switch);
 	void sigpass(int32_t bpno, uint8_t orient, uint32_t mode_switch);
 	void refpass(int32_t bpno);
-	inline void refpass_step(flag_opt_t *flagsp, int32_t *datap,
-			int32_t poshalf, uint32_t maxci3);
-	void clnpass_step(flag_opt_t *flagsp, int32_t *datap, uint8_t orient,
-			int32_t oneplushalf, uint32_t agg, uint32_t runlen, uint32_t y,
-			uint32_t mode_switch);
+	inline void refpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+			int32_t *datap, int32_t poshalf, uint32_t maxci3);
+	inline void clnpass_step(mqc_dec_t &dec, flag_opt_t *flagsp,
+			int32_t *datap, uint8_t orient, int32_t oneplushalf, uint32_t agg,
+			uint32_t runlen, uint32_t y, uint32_t mode_switch);
 	void clnpass(int32_t bpno, uint8_t orient, uint32_t mode_switch);
+	inline void sigpass_step_raw(raw_t &r, flag_opt_t *flagsp,
+			int32_t *datap, int32_t oneplushalf, uint32_t maxci3, uint8_t vsc);
+	void sigpass_raw(int32_t bpno, uint32_t mode_switch);
+	inline void refpass_step_raw(raw_t &r, flag_opt_t *flagsp,
+			int32_t *datap, int32_t poshalf, uint32_t maxci3);
+	void refpass_raw(int32_t bpno);
+	void postDecodeEmpty(decodeBlockInfo *block);
+
+	// true if the last decoded code block had no compressed data
+	bool empty_cblk;
 };
 
 }
@@ -54,7 +54,7 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-#include "grok_includes.h"
+#include "CPUArch.h"
 #include "mqc.h"
 #include "t1.h"
 #include "t1_encode.h"
@@ -101,9 +101,8 @@ bool t1_encode::allocateBuffers(uint16_t cblkw, uint16_t cblkh) {
  @param h	height of code block
  */
 void t1_encode::initBuffers(uint16_t w, uint16_t h) {
+	// data is not cleared: preEncode overwrites every sample
 	t1::initBuffers(w, h);
-	if (data)
-		memset(data, 0, w * h * sizeof(int32_t));
 }
 void t1_encode::sigpass_step(flag_opt_t *flagsp, uint32_t *datap,
 		uint8_t orient, int32_t bpno, int32_t one, int32_t *nmsedec,
@@ -120,10 +119,11 @@ void t1_encode::sigpass_step(flag_opt_t *flagsp, uint32_t *datap,
 				&& (shift_flags & T1_SIGMA_NEIGHBOURS) != 0U) {
 			auto dataPoint = *datap;
 			v = (dataPoint >> one) & 1;
-			mqc_setcurctx(mqc, getZeroCodingContext(shift_flags, orient));
+			// raw coded bits need no context
 			if (type == T1_TYPE_RAW) {
 				mqc_bypass_enc(mqc, v);
 			} else {
+				mqc_setcurctx(mqc, getZeroCodingContext(shift_flags, orient));
 				mqc_encode(mqc, v);
 			}
 			if (v) {
@@ -131,12 +131,12 @@ void t1_encode::sigpass_step(flag_opt_t *flagsp, uint32_t *datap,
 				v = (uint8_t) (dataPoint >> T1_DATA_SIGN_BIT_INDEX);
 				if (nmsedec)
 					*nmsedec += getnmsedec_sig(dataPoint, (uint32_t) bpno);
-				uint32_t lu = getSignCodingOrSPPByteIndex(*flagsp, flagsp[-1],
-						flagsp[1], ci3);
-				mqc_setcurctx(mqc, getSignCodingContext(lu));
 				if (type == T1_TYPE_RAW) {
 					mqc_bypass_enc(mqc, v);
 				} else {
+					uint32_t lu = getSignCodingOrSPPByteIndex(*flagsp,
+							flagsp[-1], flagsp[1], ci3);
+					mqc_setcurctx(mqc, getSignCodingContext(lu));
 					mqc_encode(mqc, v ^ getSPByte(lu));
 				}
 				updateFlags(flagsp, ci3, v, flags_stride,
@@ -191,10 +191,10 @@ void t1_encode::refpass_step(flag_opt_t *flagsp, uint32_t *datap, int32_t bpno,
 			if (nmsedec)
 				*nmsedec += getnmsedec_ref(*datap, (uint32_t) bpno);
 			v = (*datap >> one) & 1;
-			mqc_setcurctx(mqc, getMRPContext(shift_flags));
 			if (type == T1_TYPE_RAW) {
 				mqc_bypass_enc(mqc, v);
 			} else {
+				mqc_setcurctx(mqc, getMRPContext(shift_flags));
 				mqc_encode(mqc, v);
 			}
 			/* flip magnitude refinement bit*/
@@ -344,8 +344,12 @@ int16_t t1_encode::getnmsedec_ref(uint32_t x, uint32_t bitpos) {
 double t1_encode::encode_cblk(tcd_cblk_enc_t *cblk, uint8_t orient,
 		uint32_t compno, uint32_t level, uint32_t qmfbid, double stepsize,
 		uint32_t mode_switch, uint32_t numcomps, const double *mct_norms,
-		uint32_t mct_numcomps, uint32_t max, bool doRateControl) {
+		uint32_t mct_numcomps, uint32_t max, bool doRateControl,
+		double min_slope) {
 	double cumwmsedec = 0.0;
+	// distortion and rate at the end of the previous bit plane
+	double planewmsedec = 0.0;
+	uint32_t planerate = 0;
 
 	uint32_t passno;
 	int32_t bpno;
@@ -358,8 +362,12 @@ double t1_encode::encode_cblk(tcd_cblk_enc_t *cblk, uint8_t orient,
 	cblk->numbps =
 			(max && (logMax > T1_NMSEDEC_FRACBITS)) ?
 					(uint32_t) (logMax - T1_NMSEDEC_FRACBITS) : 0;
-	if (!cblk->numbps)
+	// empty code block: no passes, and no need to clear the flags
+	if (!cblk->numbps) {
+		cblk->num_passes_encoded = 0;
 		return 0;
+	}
+	initBuffers(w, h);
 
 	bpno = (int32_t) (cblk->numbps - 1);
 	passtype = 2;
@@ -457,6 +465,22 @@ double t1_encode::encode_cblk(tcd_cblk_enc_t *cblk, uint8_t orient,
 		pass->distortiondec = cumwmsedec;
 		pass->rate = (uint16_t) (mqc_numbytes(mqc) + correction);
 
+		// stop at the end of a bit plane once its rate-distortion slope
+		// falls below the minimum slope that rate control will keep:
+		// the remaining passes would be discarded anyway
+		if (doRateControl && min_slope > 0 && passtype == 0 && bpno >= 0) {
+			if (pass->rate > planerate) {
+				double slope = (cumwmsedec - planewmsedec)
+						/ (double) (pass->rate - planerate);
+				if (slope < min_slope) {
+					++passno;
+					break;
+				}
+			}
+			planewmsedec = cumwmsedec;
+			planerate = pass->rate;
+		}
+
 		//note: passtype and bpno have already been updated to next pass,
 		// while pass pointer still points to current pass
 		if (bpno >= 0) {
@@ -538,68 +562,180 @@ static inline int32_t int_fix_mul_t1(int32_t a, int32_t b) {
 	return (int32_t) (temp >> (13 + 11 - T1_NMSEDEC_FRACBITS));
 }
 
+#ifdef __AVX2__
+/*
+ Split 8 quantized coefficients into magnitude and sign bit,
+ store them and update the running maximum magnitude
+ */
+static inline void pack_sign_mag_avx2(__m256i v, uint32_t *data,
+		__m256i &vmax) {
+	__m256i mag = _mm256_abs_epi32(v);
+	__m256i sign = _mm256_and_si256(v,
+			_mm256_set1_epi32((int32_t) (1U << T1_DATA_SIGN_BIT_INDEX)));
+	vmax = _mm256_max_epu32(vmax, mag);
+	_mm256_storeu_si256((__m256i*) data, _mm256_or_si256(mag, sign));
+}
+static inline uint32_t hmax_avx2(__m256i vmax) {
+	__m128i m = _mm_max_epu32(_mm256_castsi256_si128(vmax),
+			_mm256_extracti128_si256(vmax, 1));
+	m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t) _mm_cvtsi128_si32(m);
+}
+#elif defined(__SSE4_1__)
+static inline void pack_sign_mag_sse4(__m128i v, uint32_t *data,
+		__m128i &vmax) {
+	__m128i mag = _mm_abs_epi32(v);
+	__m128i sign = _mm_and_si128(v,
+			_mm_set1_epi32((int32_t) (1U << T1_DATA_SIGN_BIT_INDEX)));
+	vmax = _mm_max_epu32(vmax, mag);
+	_mm_storeu_si128((__m128i*) data, _mm_or_si128(mag, sign));
+}
+static inline uint32_t hmax_sse4(__m128i m) {
+	m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t) _mm_cvtsi128_si32(m);
+}
+#endif
+
+static inline uint32_t to_sign_mag(int32_t tmp, uint32_t &max) {
+	uint32_t mag = (uint32_t) abs(tmp);
+	max = std::max<uint32_t>(max, mag);
+	return mag | ((uint32_t) (tmp < 0) << T1_DATA_SIGN_BIT_INDEX);
+}
+
+/*
+ Reversible: scale one row by (1 << T1_NMSEDEC_FRACBITS) in place
+ in the tile buffer, and store it in sign/magnitude form.
+ Returns the maximum magnitude of the row.
+ */
+static uint32_t preEncodeRowReversible(int32_t *restrict tiledp,
+		uint32_t *restrict data, uint32_t w) {
+	uint32_t max = 0;
+	uint32_t i = 0;
+#ifdef __AVX2__
+	__m256i vmax = _mm256_setzero_si256();
+	for (; i + 8 <= w; i += 8) {
+		__m256i v = _mm256_slli_epi32(
+				_mm256_loadu_si256((const __m256i*) (tiledp + i)),
+				T1_NMSEDEC_FRACBITS);
+		_mm256_storeu_si256((__m256i*) (tiledp + i), v);
+		pack_sign_mag_avx2(v, data + i, vmax);
+	}
+	max = hmax_avx2(vmax);
+#elif defined(__SSE4_1__)
+	__m128i vmax = _mm_setzero_si128();
+	for (; i + 4 <= w; i += 4) {
+		__m128i v = _mm_slli_epi32(
+				_mm_loadu_si128((const __m128i*) (tiledp + i)),
+				T1_NMSEDEC_FRACBITS);
+		_mm_storeu_si128((__m128i*) (tiledp + i), v);
+		pack_sign_mag_sse4(v, data + i, vmax);
+	}
+	max = hmax_sse4(vmax);
+#endif
+	for (; i < w; ++i)
+		data[i] = to_sign_mag(tiledp[i] *= (1 << T1_NMSEDEC_FRACBITS), max);
+	return max;
+}
+
+/*
+ Irreversible: quantize one row with int_fix_mul_t1(x, bandconst)
+ and store it in sign/magnitude form.
+ Returns the maximum magnitude of the row.
+ */
+static uint32_t preEncodeRowIrreversible(const int32_t *restrict tiledp,
+		uint32_t *restrict data, uint32_t w, int32_t bandconst) {
+	const uint32_t shift = 13 + 11 - T1_NMSEDEC_FRACBITS;
+	uint32_t max = 0;
+	uint32_t i = 0;
+	// 64 bit products are rounded and shifted; the low 32 bits of a
+	// logical shift equal those of the arithmetic shift, and the result
+	// fits in 32 bits, so even and odd lanes can be recombined with a blend
+#ifdef __AVX2__
+	const __m256i vconst = _mm256_set1_epi32(bandconst);
+	const __m256i round = _mm256_set1_epi64x(4096);
+	__m256i vmax = _mm256_setzero_si256();
+	for (; i + 8 <= w; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (tiledp + i));
+		__m256i lo = _mm256_add_epi64(_mm256_mul_epi32(v, vconst), round);
+		__m256i hi = _mm256_add_epi64(
+				_mm256_mul_epi32(_mm256_srli_epi64(v, 32), vconst), round);
+		lo = _mm256_srli_epi64(lo, shift);
+		hi = _mm256_slli_epi64(_mm256_srli_epi64(hi, shift), 32);
+		pack_sign_mag_avx2(_mm256_blend_epi32(lo, hi, 0xAA), data + i, vmax);
+	}
+	max = hmax_avx2(vmax);
+#elif defined(__SSE4_1__)
+	const __m128i vconst = _mm_set1_epi32(bandconst);
+	const __m128i round = _mm_set1_epi64x(4096);
+	__m128i vmax = _mm_setzero_si128();
+	for (; i + 4 <= w; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (tiledp + i));
+		__m128i lo = _mm_add_epi64(_mm_mul_epi32(v, vconst), round);
+		__m128i hi = _mm_add_epi64(
+				_mm_mul_epi32(_mm_srli_epi64(v, 32), vconst), round);
+		lo = _mm_srli_epi64(lo, shift);
+		hi = _mm_slli_epi64(_mm_srli_epi64(hi, shift), 32);
+		pack_sign_mag_sse4(_mm_blend_epi16(lo, hi, 0xCC), data + i, vmax);
+	}
+	max = hmax_sse4(vmax);
+#endif
+	for (; i < w; ++i)
+		data[i] = to_sign_mag(int_fix_mul_t1(tiledp[i], bandconst), max);
+	return max;
+}
+
 void t1_encode::preEncode(encodeBlockInfo *block, tcd_tile_t *tile,
 		uint32_t &max) {
 	auto state = grok_plugin_get_debug_state();
 	//1. prepare low-level encode
 	auto tilec = tile->comps + block->compno;
-	initBuffers((uint16_t) (block->cblk->x1 - block->cblk->x0),
-			(uint16_t) (block->cblk->y1 - block->cblk->y0));
+	// flags are only cleared by encode_cblk, once the code block
+	// is known to be non-empty
+	w = (uint16_t) (block->cblk->x1 - block->cblk->x0);
+	h = (uint16_t) (block->cblk->y1 - block->cblk->y0);
 
 	uint32_t tile_width = (tilec->x1 - tilec->x0);
-	auto tileLineAdvance = tile_width - w;
 	auto tiledp = block->tiledp;
 #ifdef DEBUG_LOSSLESS_T1
-	block->unencodedData = new int32_t[t1_encoder->w * t1_encoder->h];
+	block->unencodedData = new int32_t[w * h];
 #endif
-	uint32_t tileIndex = 0;
 	max = 0;
-	uint32_t cblk_index = 0;
+	auto cblk_data = data;
 	if (block->qmfbid == 1) {
 		for (auto j = 0U; j < h; ++j) {
-			for (auto i = 0U; i < w; ++i) {
 #ifdef DEBUG_LOSSLESS_T1
-				block->unencodedData[cblk_index] = block->tiledp[tileIndex];
+			memcpy(block->unencodedData + j * w, tiledp, w * sizeof(int32_t));
 #endif
-				// should we disable multiplication by (1 << T1_NMSEDEC_FRACBITS)
-				// when ((state & GROK_PLUGIN_STATE_DEBUG) && !(state & GROK_PLUGIN_STATE_PRE_TR1)) is true ?
-				// Disabling multiplication was messing up post-encode comparison
-				// between plugin and grok open source
-				int32_t tmp = (block->tiledp[tileIndex] *= (1
-						<< T1_NMSEDEC_FRACBITS));
-				uint32_t mag = (uint32_t) abs(tmp);
-				max = std::max<uint32_t>(max, mag);
-				data[cblk_index] = mag
-						| ((uint32_t) (tmp < 0) << T1_DATA_SIGN_BIT_INDEX);
-				tileIndex++;
-				cblk_index++;
-			}
-			tileIndex += tileLineAdvance;
+			// should we disable multiplication by (1 << T1_NMSEDEC_FRACBITS)
+			// when ((state & GROK_PLUGIN_STATE_DEBUG) && !(state & GROK_PLUGIN_STATE_PRE_TR1)) is true ?
+			// Disabling multiplication was messing up post-encode comparison
+			// between plugin and grok open source
+			max = std::max<uint32_t>(max,
+					preEncodeRowReversible(tiledp, cblk_data, w));
+			tiledp += tile_width;
+			cblk_data += w;
 		}
 	} else {
+		// In lossy mode, we do a direct pass through of the image data in two cases while in debug encode mode:
+		// 1. plugin is being used for full T1 encoding, so no need to quantize in grok
+		// 2. plugin is only being used for pre T1 encoding, and we are applying quantization
+		//    in the plugin DWT step
+		bool quantize = !(state & GROK_PLUGIN_STATE_DEBUG)
+				|| ((state & GROK_PLUGIN_STATE_PRE_TR1)
+						&& !(state & GROK_PLUGIN_STATE_DWT_QUANTIZATION));
 		for (auto j = 0U; j < h; ++j) {
-			for (auto i = 0U; i < w; ++i) {
-				// In lossy mode, we do a direct pass through of the image data in two cases while in debug encode mode:
-				// 1. plugin is being used for full T1 encoding, so no need to quantize in grok
-				// 2. plugin is only being used for pre T1 encoding, and we are applying quantization
-				//    in the plugin DWT step
-				int32_t tmp = 0;
-				if (!(state & GROK_PLUGIN_STATE_DEBUG)
-						|| ((state & GROK_PLUGIN_STATE_PRE_TR1)
-								&& !(state & GROK_PLUGIN_STATE_DWT_QUANTIZATION))) {
-					tmp = int_fix_mul_t1(tiledp[tileIndex], block->bandconst);
-				} else {
-					tmp = tiledp[tileIndex];
-				}
-				uint32_t mag = (uint32_t) abs(tmp);
-				uint32_t sign_mag = mag
-						| ((uint32_t) (tmp < 0) << T1_DATA_SIGN_BIT_INDEX);
-				max = std::max<uint32_t>(max, mag);
-				data[cblk_index] = sign_mag;
-				tileIndex++;
-				cblk_index++;
+			if (quantize) {
+				max = std::max<uint32_t>(max,
+						preEncodeRowIrreversible(tiledp, cblk_data, w,
+								block->bandconst));
+			} else {
+				for (auto i = 0U; i < w; ++i)
+					cblk_data[i] = to_sign_mag(tiledp[i], max);
 			}
-			tileIndex += tileLineAdvance;
+			tiledp += tile_width;
+			cblk_data += w;
 		}
 	}
 }
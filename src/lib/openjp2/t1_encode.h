@@ -70,7 +70,8 @@ public:
 	double encode_cblk(tcd_cblk_enc_t *cblk, uint8_t orient, uint32_t compno,
 			uint32_t level, uint32_t qmfbid, double stepsize,
 			uint32_t mode_switch, uint32_t numcomps, const double *mct_norms,
-			uint32_t mct_numcomps, uint32_t max, bool doRateControl);
+			uint32_t mct_numcomps, uint32_t max, bool doRateControl,
+			double min_slope);
 	uint32_t *data;
 private:
 	mqc_t *mqc;
@@ -33,11 +33,9 @@ t1_impl::t1_impl(bool isEncoder, tcp_t *tcp, uint16_t maxCblkW,
 			throw std::exception();
 		}
 	} else {
-		tccp_t *tccp = &tcp->tccps[0];
-		if (!tccp->mode_switch)
-			t1_decoder = new t1_decode_opt(maxCblkW, maxCblkH);
-		else
-			t1_decoder = new t1_decode(maxCblkW, maxCblkH);
+		// the optimized decoder handles all code block styles; the style
+		// is taken per code block from its own component's tccp
+		t1_decoder = new t1_decode_opt(maxCblkW, maxCblkH);
 	}
 }
 t1_impl::~t1_impl() {
@@ -54,7 +52,8 @@ double t1_impl::encode(encodeBlockInfo *block, tcd_tile_t *tile, uint32_t max,
 			block->compno,
 			(tile->comps + block->compno)->numresolutions - 1 - block->resno,
 			block->qmfbid, block->stepsize, block->mode_switch, tile->numcomps,
-			block->mct_norms, block->mct_numcomps, max, doRateControl);
+			block->mct_norms, block->mct_numcomps, max, doRateControl,
+			block->min_slope);
 #ifdef DEBUG_LOSSLESS_T1
 		t1_decode* t1Decode = new t1_decode(t1_encoder->w, t1_encoder->h);
 
@@ -73,6 +72,7 @@ double t1_impl::encode(encodeBlockInfo *block, tcd_tile_t *tile, uint32_t max,
 		memset(cblkDecode->segs, 0, sizeof(tcd_seg_t));
 		auto seg = cblkDecode->segs;
 		seg->numpasses = block->cblk->num_passes_encoded;
+		seg->numPassesRead = seg->numpasses;
 		auto rate = seg->numpasses ? block->cblk->passes[seg->numpasses - 1].rate : 0;
 		seg->len = rate;
 		seg->dataindex = 0;
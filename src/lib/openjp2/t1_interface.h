@@ -24,11 +24,13 @@ namespace grk {
 
 struct decodeBlockInfo {
 	decodeBlockInfo() :
-			tilec(nullptr), tiledp(nullptr), cblk(nullptr), resno(0), bandno(0), stepsize(
-					0), roishift(0), mode_switch(0), qmfbid(0), x(0), y(0) {
+			tilec(nullptr), tiledp(nullptr), cachedp(nullptr), cblk(nullptr), resno(
+					0), bandno(0), stepsize(0), roishift(0), mode_switch(0), qmfbid(
+					0), x(0), y(0) {
 	}
 	tcd_tilecomp_t *tilec;
 	int32_t *tiledp;
+	int32_t *cachedp; /* layer refinement cache, same stride as tiledp */
 	tcd_cblk_dec_t *cblk;
 	uint32_t resno;
 	uint32_t bandno;
@@ -43,7 +45,7 @@ struct encodeBlockInfo {
 	encodeBlockInfo() :
 			tiledp(nullptr), cblk(nullptr), compno(0), resno(0), bandno(0), precno(
 					0), cblkno(0), bandconst(0), stepsize(0), mode_switch(0), qmfbid(
-					0), x(0), y(0), mct_norms(nullptr),
+					0), x(0), y(0), mct_norms(nullptr), min_slope(0),
 #ifdef DEBUG_LOSSLESS_T1
 		unencodedData(nullptr),
 #endif
@@ -62,6 +64,9 @@ struct encodeBlockInfo {
 	uint32_t qmfbid;
 	uint32_t x, y; /* relative code block offset */
 	const double *mct_norms;
+	/* bit planes whose rate-distortion slope falls below this value
+	 * are not coded (0 means code all bit planes) */
+	double min_slope;
 #ifdef DEBUG_LOSSLESS_T1
 	int32_t* unencodedData;
 #endif
@@ -132,10 +132,10 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 		seg_buf_t *src_buf, uint64_t *p_data_read);
 
 static bool t2_read_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
-		seg_buf_t *src_buf, uint64_t *p_data_read);
+		seg_buf_t *src_buf, uint64_t *p_data_read, tcp_t *p_tcp);
 
 static bool t2_skip_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
-		uint64_t *p_data_read, uint64_t max_length);
+		uint64_t *p_data_read, uint64_t max_length, tcp_t *p_tcp);
 
 /**
  @param cblk
@@ -356,6 +356,76 @@ bool t2_encode_packets_simulate(t2_t *p_t2, uint32_t tile_no,
 	pi_destroy(l_pi, l_nb_pocs);
 	return true;
 }
+/*
+ For each component and resolution, flag the precincts that intersect
+ the decode region in at least one of their sub-bands. Components that
+ are decoded in full are left empty.
+ */
+static void t2_map_precincts_to_region(tcd_tile_t *tile,
+		std::vector<std::vector<std::vector<bool> > > &map) {
+	map.resize(tile->numcomps);
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		tcd_tilecomp_t *tilec = tile->comps + compno;
+		if (tilec->skip_decode || !tile_buf_is_decode_region(tilec->buf))
+			continue;
+		auto &comp_map = map[compno];
+		comp_map.resize(tilec->numresolutions);
+		for (uint32_t resno = 0; resno < tilec->minimum_num_resolutions;
+				++resno) {
+			tcd_resolution_t *res = tilec->resolutions + resno;
+			auto &res_map = comp_map[resno];
+			res_map.resize((size_t) res->pw * res->ph, false);
+			for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
+				tcd_band_t *band = res->bands + bandno;
+				for (uint64_t precno = 0;
+						precno < band->numPrecincts && precno < res_map.size();
+						++precno) {
+					tcd_precinct_t *prec = band->precincts + precno;
+					rect_t prec_rect = rect_t(prec->x0, prec->y0, prec->x1,
+							prec->y1);
+					if (tile_buf_hit_test_band(tilec->buf, resno, bandno,
+							&prec_rect))
+						res_map[precno] = true;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Growing stream: true if the tile's last tile-part has only partly arrived
+ */
+static bool t2_tile_truncated(tcp_t *p_tcp) {
+	return p_tcp && p_tcp->m_refinement && p_tcp->m_refinement->truncated;
+}
+
+/**
+ * Growing stream: called when a packet runs past the end of the available data.
+ * If the tile's last tile-part has only partly arrived, then this is the expected
+ * end of data rather than an error: record it, and return true.
+ */
+static bool t2_stop_at_end_of_data(tcp_t *p_tcp) {
+	if (!t2_tile_truncated(p_tcp))
+		return false;
+	p_tcp->m_refinement->end_of_data = true;
+	return true;
+}
+
+/**
+ * Growing stream: packets of the higher resolutions may not have arrived yet,
+ * but the tile is still reconstructed at full resolution, so that it lines up
+ * with the other tiles in the output image
+ */
+static void t2_truncated_tile_resolutions(tcd_tile_t *p_tile,
+		grk_image_t *p_image) {
+	for (uint32_t compno = 0; compno < p_tile->numcomps; ++compno) {
+		auto tilec = p_tile->comps + compno;
+		if (tilec->minimum_num_resolutions)
+			p_image->comps[compno].resno_decoded =
+					tilec->minimum_num_resolutions - 1;
+	}
+}
+
 bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 		seg_buf_t *src_buf, uint64_t *p_data_read) {
 	pi_iterator_t *l_pi = nullptr;
@@ -376,6 +446,38 @@ bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 
 	l_current_pi = l_pi;
 
+	std::vector<std::vector<std::vector<bool> > > precincts_in_region;
+	t2_map_precincts_to_region(p_tile, precincts_in_region);
+	bool l_truncated = t2_tile_truncated(l_tcp);
+	if (l_truncated)
+		l_tcp->m_refinement->end_of_data = false;
+
+	/* highest resolution needed by any component */
+	uint32_t l_max_resolutions = 0;
+	for (uint32_t compno = 0; compno < p_tile->numcomps; ++compno) {
+		auto tilec = p_tile->comps + compno;
+		if (!tilec->skip_decode)
+			l_max_resolutions = std::max<uint32_t>(l_max_resolutions,
+					tilec->minimum_num_resolutions);
+	}
+
+	/* PLT packet lengths let skipped packets be stepped over without parsing
+	 * their headers, provided that there is exactly one length per packet */
+	std::vector<uint32_t> *l_packet_lengths = nullptr;
+	size_t l_packet_index = 0;
+	if (l_tcp->m_packet_lengths && !l_tcp->ppt && !l_cp->ppm_data
+			&& !l_truncated) {
+		uint64_t l_num_packets = 0;
+		for (uint32_t compno = 0; compno < p_tile->numcomps; ++compno) {
+			auto tilec = p_tile->comps + compno;
+			for (uint32_t resno = 0; resno < tilec->numresolutions; ++resno)
+				l_num_packets += (uint64_t) tilec->resolutions[resno].pw
+						* tilec->resolutions[resno].ph;
+		}
+		if (l_num_packets * l_tcp->numlayers == l_tcp->m_packet_lengths->size())
+			l_packet_lengths = l_tcp->m_packet_lengths;
+	}
+
 	for (pino = 0; pino <= l_tcp->numpocs; ++pino) {
 
 		/* if the resolution needed is too low, one dim of the tilec could be equal to zero
@@ -391,6 +493,17 @@ bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 			return false;
 		}
 		while (pi_next(l_current_pi)) {
+			/* without POCs, all remaining packets are skipped once a
+			 * layer-major or resolution-major progression moves past
+			 * the last layer or resolution to decode */
+			if (!l_tcp->numpocs) {
+				auto prg = l_current_pi->poc.prg;
+				if ((prg == GRK_LRCP
+						&& l_current_pi->layno >= l_tcp->num_layers_to_decode)
+						|| ((prg == GRK_RLCP || prg == GRK_RPCL)
+								&& l_current_pi->resno >= l_max_resolutions))
+					break;
+			}
 			bool skip_precinct = false;
 			tcd_tilecomp_t *tilec = p_tile->comps + l_current_pi->compno;
 			bool skip_layer_or_res = l_current_pi->layno
@@ -405,28 +518,13 @@ bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 					l_current_pi->resno, l_current_pi->precno,
 					l_current_pi->layno);
 */
-			if (!skip_layer_or_res) {
-				tcd_resolution_t *res = tilec->resolutions
-						+ l_current_pi->resno;
-				uint32_t bandno;
+			if (tilec->skip_decode) {
 				skip_precinct = true;
-				for (bandno = 0; bandno < res->numbands && skip_precinct;
-						++bandno) {
-					tcd_band_t *band = res->bands + bandno;
-					auto num_precincts = band->numPrecincts;
-					uint32_t precno;
-					for (precno = 0; precno < num_precincts && skip_precinct;
-							++precno) {
-						rect_t prec_rect;
-						tcd_precinct_t *prec = band->precincts + precno;
-						prec_rect = rect_t(prec->x0, prec->y0, prec->x1,
-								prec->y1);
-						if (tile_buf_hit_test(tilec->buf, &prec_rect)) {
-							skip_precinct = false;
-							break;
-						}
-					}
-				}
+			} else if (!skip_layer_or_res) {
+				auto &comp_map = precincts_in_region[l_current_pi->compno];
+				if (!comp_map.empty())
+					skip_precinct =
+							!comp_map[l_current_pi->resno][l_current_pi->precno];
 			}
 
 			if (!skip_layer_or_res && !skip_precinct) {
@@ -435,14 +533,32 @@ bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 						&p_tile->comps[l_current_pi->compno].resolutions[l_current_pi->resno],
 						l_tcp, l_current_pi, src_buf, &l_nb_bytes_read)) {
 					pi_destroy(l_pi, l_nb_pocs);
+					/* growing stream: decode the packets that have arrived */
+					if (!l_truncated || !l_tcp->m_refinement->end_of_data)
+						return false;
+					t2_truncated_tile_resolutions(p_tile, l_image);
+					return true;
+				}
+			} else if (l_packet_lengths) {
+				uint32_t l_packet_len = (*l_packet_lengths)[l_packet_index];
+				if (!l_packet_len || l_packet_len > src_buf->get_cur_seg_len()) {
+					pi_destroy(l_pi, l_nb_pocs);
+					GROK_ERROR(
+							"t2_decode_packets: invalid PLT packet length (%d)",
+							l_packet_len);
 					return false;
 				}
+				l_nb_bytes_read = l_packet_len;
+				src_buf->incr_cur_seg_offset(l_nb_bytes_read);
 			} else {
 				l_nb_bytes_read = 0;
 				if (!t2_skip_packet(p_t2, p_tile, l_tcp, l_current_pi, src_buf,
 						&l_nb_bytes_read)) {
 					pi_destroy(l_pi, l_nb_pocs);
-					return false;
+					if (!l_truncated || !l_tcp->m_refinement->end_of_data)
+						return false;
+					t2_truncated_tile_resolutions(p_tile, l_image);
+					return true;
 				}
 			}
 
@@ -450,6 +566,7 @@ bool t2_decode_packets(t2_t *p_t2, uint32_t tile_no, tcd_tile_t *p_tile,
 				l_img_comp->resno_decoded = std::max<uint32_t>(
 						l_current_pi->resno, l_img_comp->resno_decoded);
 			*p_data_read += l_nb_bytes_read;
+			++l_packet_index;
 		}
 		++l_current_pi;
 	}
@@ -499,7 +616,8 @@ static bool t2_decode_packet(t2_t *p_t2, tcd_resolution_t *l_res, tcp_t *p_tcp,
 	/* we should read data for the packet */
 	if (l_read_data) {
 		l_nb_bytes_read = 0;
-		if (!t2_read_packet_data(l_res, p_pi, src_buf, &l_nb_bytes_read)) {
+		if (!t2_read_packet_data(l_res, p_pi, src_buf, &l_nb_bytes_read,
+				p_tcp)) {
 			return false;
 		}
 		l_nb_total_bytes_read += l_nb_bytes_read;
@@ -518,6 +636,8 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 	uint64_t l_nb_code_blocks = 0;
 	uint8_t *active_src = p_src_data;
 	cp_t *l_cp = p_t2->cp;
+	/* running out of data is expected in a partly arrived tile-part */
+	bool l_truncated = t2_tile_truncated(p_tcp);
 
 	if (p_pi->layno == 0) {
 		/* reset tagtrees */
@@ -545,8 +665,9 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 	/* SOP markers */
 	if (p_tcp->csty & J2K_CP_CSTY_SOP) {
 		if (max_length < 6) {
-			GROK_WARN(
-					"Not enough space for expected SOP marker");
+			if (!l_truncated)
+				GROK_WARN(
+						"Not enough space for expected SOP marker");
 		} else if ((*active_src) != 0xff || (*(active_src + 1) != 0x91)) {
 			GROK_WARN( "Expected SOP marker");
 		} else {
@@ -587,23 +708,27 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 			new BitIO(l_header_data, *l_modified_length_ptr, false));
 	if (*l_modified_length_ptr) {
 		if (!l_bio->read(&l_present, 1)) {
-			GROK_ERROR(
-					"t2_read_packet_header: failed to read `present` bit ");
+			if (!t2_stop_at_end_of_data(p_tcp))
+				GROK_ERROR(
+						"t2_read_packet_header: failed to read `present` bit ");
 			return false;
 		}
 	}
 	//GROK_INFO("present=%d \n", l_present);
 	if (!l_present) {
-		if (!l_bio->inalign())
+		if (!l_bio->inalign()) {
+			t2_stop_at_end_of_data(p_tcp);
 			return false;
+		}
 		l_header_data += l_bio->numbytes();
 
 		/* EPH markers */
 		if (p_tcp->csty & J2K_CP_CSTY_EPH) {
 			if ((*l_modified_length_ptr
 					- (size_t) (l_header_data - *l_header_data_start)) < 2U) {
-				GROK_WARN(
-						"Not enough space for expected EPH marker");
+				if (!l_truncated)
+					GROK_WARN(
+							"Not enough space for expected EPH marker");
 			} else if ((*l_header_data) != 0xff
 					|| (*(l_header_data + 1) != 0x92)) {
 				GROK_WARN( "Expected EPH marker");
@@ -638,8 +763,9 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 				uint64_t value;
 				if (!l_prc->incltree->decodeValue(l_bio.get(), cblkno,
 						p_pi->layno + 1, &value)) {
-					GROK_ERROR(
-							"t2_read_packet_header: failed to read `inclusion` bit ");
+					if (!t2_stop_at_end_of_data(p_tcp))
+						GROK_ERROR(
+								"t2_read_packet_header: failed to read `inclusion` bit ");
 					return false;
 				}
 				if (value != tag_tree_uninitialized_node_value
@@ -668,8 +794,9 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 			/* else one bit */
 			else {
 				if (!l_bio->read(&l_included, 1)) {
-					GROK_ERROR(
-							"t2_read_packet_header: failed to read `inclusion` bit ");
+					if (!t2_stop_at_end_of_data(p_tcp))
+						GROK_ERROR(
+								"t2_read_packet_header: failed to read `inclusion` bit ");
 					return false;
 				}
 
@@ -701,8 +828,9 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 				K_msbs--;
 
 				if (!rc) {
-					GROK_ERROR(
-							"Failed to decode zero-bitplane tag tree ");
+					if (!t2_stop_at_end_of_data(p_tcp))
+						GROK_ERROR(
+								"Failed to decode zero-bitplane tag tree ");
 					return false;
 				}
 
@@ -726,13 +854,15 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 
 			/* number of coding passes */
 			if (!t2_getnumpasses(l_bio.get(), &l_cblk->numPassesInPacket)) {
-				GROK_ERROR(
-						"t2_read_packet_header: failed to read numpasses.");
+				if (!t2_stop_at_end_of_data(p_tcp))
+					GROK_ERROR(
+							"t2_read_packet_header: failed to read numpasses.");
 				return false;
 			}
 			if (!t2_getcommacode(l_bio.get(), &l_increment)) {
-				GROK_ERROR(
-						"t2_read_packet_header: failed to read length indicator increment.");
+				if (!t2_stop_at_end_of_data(p_tcp))
+					GROK_ERROR(
+							"t2_read_packet_header: failed to read length indicator increment.");
 				return false;
 			}
 
@@ -772,6 +902,8 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 				if (!l_bio->read(&l_seg->newlen,
 						l_cblk->numlenbits
 								+ uint_floorlog2(l_seg->numPassesInPacket))) {
+					if (t2_stop_at_end_of_data(p_tcp))
+						return false;
 					GROK_WARN(
 							"t2_read_packet_header: failed to read segment length ");
 				}
@@ -799,7 +931,8 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 	}
 
 	if (!l_bio->inalign()) {
-		GROK_ERROR( "Unable to read packet header");
+		if (!t2_stop_at_end_of_data(p_tcp))
+			GROK_ERROR( "Unable to read packet header");
 		return false;
 	}
 
@@ -809,8 +942,9 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 	if (p_tcp->csty & J2K_CP_CSTY_EPH) {
 		if ((*l_modified_length_ptr
 				- (uint32_t) (l_header_data - *l_header_data_start)) < 2U) {
-			GROK_WARN(
-					"Not enough space for expected EPH marker");
+			if (!l_truncated)
+				GROK_WARN(
+						"Not enough space for expected EPH marker");
 		} else if ((*l_header_data) != 0xff || (*(l_header_data + 1) != 0x92)) {
 			GROK_WARN( "Expected EPH marker");
 		} else {
@@ -832,7 +966,7 @@ static bool t2_read_packet_header(t2_t *p_t2, tcd_resolution_t *l_res,
 }
 
 static bool t2_read_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
-		seg_buf_t *src_buf, uint64_t *p_data_read) {
+		seg_buf_t *src_buf, uint64_t *p_data_read, tcp_t *p_tcp) {
 	uint32_t bandno;
 	uint64_t l_nb_code_blocks, cblkno;
 	tcd_band_t *l_band = nullptr;
@@ -869,6 +1003,9 @@ static bool t2_read_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
 				size_t len = src_buf->data_len;
 				// Check possible overflow on segment length
 				if (((offset + l_seg->newlen) > len)) {
+					/* rest of packet has not arrived yet */
+					if (t2_stop_at_end_of_data(p_tcp))
+						return false;
 					GROK_ERROR(
 							"read packet data: segment offset (%u) plus segment length %u is greater than total length \nof all segments (%u) for codeblock %d (layer=%d, prec=%d, band=%d, res=%d, comp=%d)\n",
 							offset, l_seg->newlen, len, cblkno, p_pi->layno,
@@ -889,6 +1026,7 @@ static bool t2_read_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
 					l_seg->len += l_seg->newlen;
 				}
 				l_seg->numpasses += l_seg->numPassesInPacket;
+				l_seg->numPassesRead += l_seg->numPassesInPacket;
 				numPassesInPacket -= l_seg->numPassesInPacket;
 				if (numPassesInPacket > 0) {
 					++l_seg;
@@ -1270,7 +1408,8 @@ static bool t2_encode_packet(uint32_t tileno, tcd_tile_t *tile, tcp_t *tcp,
 				if (!t2_read_packet_data(roundRes,
 					pi,
 					src_buf.get(),
-					&l_nb_bytes_read)) {
+					&l_nb_bytes_read,
+					nullptr)) {
 					rc = false;
 				}
 				else {
@@ -1570,7 +1709,7 @@ static bool t2_skip_packet(t2_t *p_t2, tcd_tile_t *p_tile, tcp_t *p_tcp,
 
 		if (!t2_skip_packet_data(
 				&p_tile->comps[p_pi->compno].resolutions[p_pi->resno], p_pi,
-				&l_nb_bytes_read, max_length)) {
+				&l_nb_bytes_read, max_length, p_tcp)) {
 			return false;
 		}
 		src_buf->incr_cur_seg_offset(l_nb_bytes_read);
@@ -1582,7 +1721,7 @@ static bool t2_skip_packet(t2_t *p_t2, tcd_tile_t *p_tile, tcp_t *p_tcp,
 }
 
 static bool t2_skip_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
-		uint64_t *p_data_read, uint64_t max_length) {
+		uint64_t *p_data_read, uint64_t max_length, tcp_t *p_tcp) {
 	uint32_t bandno;
 	uint64_t l_nb_code_blocks, cblkno;
 	tcd_cblk_dec_t *l_cblk = nullptr;
@@ -1625,6 +1764,8 @@ static bool t2_skip_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
 				/* Check possible overflow then size */
 				if (((*p_data_read + l_seg->newlen) < (*p_data_read))
 						|| ((*p_data_read + l_seg->newlen) > max_length)) {
+					if (t2_stop_at_end_of_data(p_tcp))
+						return false;
 					GROK_ERROR(
 							"skip: segment too long (%d) with max (%d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
 							l_seg->newlen, max_length, cblkno, p_pi->precno,
@@ -1632,8 +1773,6 @@ static bool t2_skip_packet_data(tcd_resolution_t *l_res, pi_iterator_t *p_pi,
 					return false;
 				}
 
-				GROK_ERROR( "p_data_read (%d) newlen (%d) \n",
-						*p_data_read, l_seg->newlen);
 				*(p_data_read) += l_seg->newlen;
 
 				l_seg->numpasses += l_seg->numPassesInPacket;
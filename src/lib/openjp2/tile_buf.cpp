@@ -19,9 +19,31 @@
 
 namespace grk {
 
+/* region of a sub-band that is needed to reconstruct a region of its resolution */
+static rect_t tile_buf_band_region(rect_t region, uint32_t resno,
+		uint32_t bandno, bool irreversible) {
+	if (resno > 0) {
+
+		/*For next level down, E' = ceil((E-b)/2) where b in {0,1} identifies band  */
+		pt_t shift;
+		shift.x = bandno & 1;
+		shift.y = bandno & 2;
+
+		region.pan(&shift);
+		region.ceildivpow2(1);
+
+		// boundary padding. These numbers are slightly larger than they theoretically should be,
+		// but we want to make sure that we don't have bugs at the region boundaries
+		region.grow(irreversible ? 5 : 3);
+
+	}
+	return region;
+}
+
 bool tile_buf_create_component(tcd_tilecomp_t *tilec, bool isEncoder,
 		bool irreversible, uint32_t cblkw, uint32_t cblkh,
-		grk_image_t *output_image, uint32_t dx, uint32_t dy) {
+		grk_image_t *output_image, uint32_t dx, uint32_t dy,
+		const grk_decode_area_t *areas, uint32_t num_areas) {
 	int32_t resno = 0;
 	rect_t component_output_rect;
 	tile_buf_component_t *comp = nullptr;
@@ -81,22 +103,9 @@ bool tile_buf_create_component(tcd_tilecomp_t *tilec, bool isEncoder,
 			rect_t band_rect;
 			band_rect = rect_t(band->x0, band->y0, band->x1, band->y1);
 
-			res->band_region[bandno].dim = component_output_rect;
-			if (resno > 0) {
-
-				/*For next level down, E' = ceil((E-b)/2) where b in {0,1} identifies band  */
-				pt_t shift;
-				shift.x = band->bandno & 1;
-				shift.y = band->bandno & 2;
-
-				res->band_region[bandno].dim.pan(&shift);
-				res->band_region[bandno].dim.ceildivpow2(1);
-
-				// boundary padding. These numbers are slightly larger than they theoretically should be,
-				// but we want to make sure that we don't have bugs at the region boundaries
-				res->band_region[bandno].dim.grow(irreversible ? 5 : 3);
-
-			}
+			res->band_region[bandno].dim = tile_buf_band_region(
+					component_output_rect, (uint32_t) resno, band->bandno,
+					irreversible);
 
 			/* add code block padding around region */
 			(res->band_region + bandno)->data_dim =
@@ -109,6 +118,40 @@ bool tile_buf_create_component(tcd_tilecomp_t *tilec, bool isEncoder,
 		comp->resolutions.push_back(res);
 	}
 
+	/* sub-band regions of each area, so that code-blocks needed by none of them are skipped */
+	comp->has_areas = areas && num_areas;
+	for (uint32_t i = 0; i < num_areas && comp->has_areas; ++i) {
+		rect_t area_rect = rect_t(ceildiv<uint32_t>(areas[i].x0, dx),
+				ceildiv<uint32_t>(areas[i].y0, dy),
+				ceildiv<uint32_t>(areas[i].x1, dx),
+				ceildiv<uint32_t>(areas[i].y1, dy));
+		if (!comp->tile_dim.clip(&area_rect, &area_rect)
+				|| !area_rect.is_non_degenerate())
+			continue;
+		std::vector<rect_t> band_dims;
+		for (resno = (int32_t) (tilec->numresolutions - 1); resno >= 0;
+				--resno) {
+			tcd_resolution_t *tcd_res = tilec->resolutions + resno;
+			for (uint8_t bandno = 0; bandno < 3; ++bandno) {
+				uint32_t orient =
+						bandno < tcd_res->numbands ?
+								tcd_res->bands[bandno].bandno : 0;
+				band_dims.push_back(
+						tile_buf_band_region(area_rect, (uint32_t) resno,
+								orient, irreversible));
+			}
+			area_rect = band_dims[band_dims.size() - 3];
+		}
+		comp->area_band_dims.push_back(band_dims);
+	}
+
+	/* hand the previous tile's sample buffer over, so that it can be reused */
+	if (tilec->buf && tilec->buf->data && tilec->buf->owns_data) {
+		comp->data = tilec->buf->data;
+		comp->data_size = tilec->buf->data_size;
+		comp->owns_data = true;
+		tilec->buf->data = nullptr;
+	}
 	tile_buf_destroy_component(tilec->buf);
 	tilec->buf = comp;
 
@@ -118,7 +161,7 @@ bool tile_buf_create_component(tcd_tilecomp_t *tilec, bool isEncoder,
 bool tile_buf_is_decode_region(tile_buf_component_t *buf) {
 	if (!buf)
 		return false;
-	return !buf->dim.are_equal(&buf->tile_dim);
+	return buf->has_areas || !buf->dim.are_equal(&buf->tile_dim);
 }
 
 int32_t* tile_buf_get_ptr(tile_buf_component_t *buf, uint32_t resno,
@@ -130,6 +173,14 @@ int32_t* tile_buf_get_ptr(tile_buf_component_t *buf, uint32_t resno,
 
 }
 
+int16_t* tile_buf_get_narrow_ptr(tile_buf_component_t *buf, uint32_t resno,
+		uint32_t bandno, uint32_t offsetx, uint32_t offsety) {
+	(void) resno;
+	(void) bandno;
+	return (int16_t*) buf->data + (uint64_t) offsetx
+			+ (uint64_t) offsety * (buf->tile_dim.x1 - buf->tile_dim.x0);
+}
+
 bool tile_buf_alloc_component_data_encode(tile_buf_component_t *buf) {
 	if (!buf)
 		return false;
@@ -164,18 +215,64 @@ bool tile_buf_alloc_component_data_decode(tile_buf_component_t *buf) {
 	if (!buf)
 		return false;
 
+	uint64_t l_size_needed = (uint64_t) buf->tile_dim.get_area()
+			* sizeof(int32_t);
+	/* narrow buffers grow to 32 bit samples when they are widened */
+	uint64_t l_size =
+			buf->narrow ?
+					(uint64_t) buf->tile_dim.get_area() * sizeof(int16_t) :
+					l_size_needed;
+	/* a buffer left over from a previous tile is reused if it is large enough */
+	if (buf->data && buf->owns_data && buf->data_size < l_size) {
+		grok_aligned_free(buf->data);
+		buf->data = nullptr;
+	}
 	if (!buf->data) {
-		int64_t area = buf->tile_dim.get_area();
-		if (area) {
-			buf->data = (int32_t*) grok_aligned_malloc(area * sizeof(int32_t));
+		if (l_size) {
+			buf->data = (int32_t*) grok_aligned_malloc(l_size);
 			if (!buf->data) {
+				buf->data_size = 0;
 				return false;
 			}
 		}
-		buf->data_size = area * sizeof(int32_t);
-		buf->data_size_needed = buf->data_size;
+		buf->data_size = l_size;
 		buf->owns_data = true;
 	}
+	buf->data_size_needed = l_size_needed;
+	/* code-blocks needed by none of the areas are not decoded */
+	if (buf->has_areas && buf->data)
+		memset(buf->data, 0, l_size);
+	return true;
+}
+
+bool tile_buf_alloc_component_data_wide(tile_buf_component_t *buf) {
+	if (!buf)
+		return false;
+	uint64_t l_size = (uint64_t) buf->tile_dim.get_area() * sizeof(int32_t);
+	if (buf->data_size >= l_size)
+		return true;
+	if (!buf->owns_data || l_size > SIZE_MAX)
+		return false;
+	auto l_data = (int32_t*) grok_aligned_realloc(buf->data, (size_t) l_size);
+	if (!l_data)
+		return false;
+	buf->data = l_data;
+	buf->data_size = l_size;
+	return true;
+}
+
+bool tile_buf_widen(tile_buf_component_t *buf) {
+	if (!buf || !buf->narrow)
+		return true;
+	if (!tile_buf_alloc_component_data_wide(buf))
+		return false;
+	/* each 32 bit sample occupies the bytes of the 16 bit sample with
+	 twice its index, so samples are widened from last to first */
+	auto l_src = tile_buf_get_narrow_ptr(buf, 0, 0, 0, 0);
+	auto l_dest = tile_buf_get_ptr(buf, 0, 0, 0, 0);
+	for (uint64_t i = (uint64_t) buf->tile_dim.get_area(); i-- > 0;)
+		l_dest[i] = l_src[i];
+	buf->narrow = false;
 	return true;
 }
 
@@ -208,6 +305,24 @@ bool tile_buf_hit_test(tile_buf_component_t *comp, rect_t *rect) {
 	return false;
 }
 
+bool tile_buf_hit_test_band(tile_buf_component_t *comp, uint32_t resno,
+		uint32_t bandno, rect_t *rect) {
+	if (!comp || !rect || resno >= comp->resolutions.size())
+		return false;
+	size_t l_res_index = comp->resolutions.size() - 1 - resno;
+	auto res = comp->resolutions[l_res_index];
+	if (bandno >= res->num_bands)
+		return false;
+	rect_t dummy;
+	if (!comp->has_areas)
+		return res->band_region[bandno].dim.clip(rect, &dummy);
+	for (auto &band_dims : comp->area_band_dims) {
+		if (band_dims[l_res_index * 3 + bandno].clip(rect, &dummy))
+			return true;
+	}
+	return false;
+}
+
 pt_t tile_buf_get_uninterleaved_range(tile_buf_component_t *comp,
 		uint32_t resno, bool is_even, bool is_horizontal) {
 	pt_t rc;
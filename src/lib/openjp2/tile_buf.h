@@ -48,20 +48,41 @@ struct tile_buf_component_t {
 	int32_t *data;
 	uint64_t data_size_needed; /* we may either need to allocate this amount of data,
 	 or re-use image data and ignore this value */
-	uint64_t data_size; /* size of the data of the component */
+	uint64_t data_size; /* allocated size of the data array; may exceed data_size_needed
+	 when the array is reused from a previous tile */
 	bool owns_data; /* true if tile buffer manages its data array, false otherwise */
+	bool narrow; /* data array holds 16 bit samples, with the same stride as 32 bit
+	 samples, and is only allocated for 16 bit samples until they are widened in place */
+	uint32_t narrow_overflow_resno; /* set by the inverse DWT to the resolution whose
+	 results did not fit in 16 bits, or 0 if all of them fit */
 
 	rect_t dim; /* canvas coordinates of region */
 	rect_t tile_dim; /* canvas coordinates of tile */
 
+	bool has_areas; /* only the areas below are needed from the region */
+	/* sub-band regions of each area that intersects the tile, with three entries
+	 per resolution, ordered like resolutions */
+	std::vector<std::vector<rect_t> > area_band_dims;
+
 };
 
 /* offsets are in canvas coordinate system*/
 int32_t* tile_buf_get_ptr(tile_buf_component_t *buf, uint32_t resno,
 		uint32_t bandno, uint32_t offsetx, uint32_t offsety);
 
+/* offsets are in canvas coordinate system; for narrow buffers */
+int16_t* tile_buf_get_narrow_ptr(tile_buf_component_t *buf, uint32_t resno,
+		uint32_t bandno, uint32_t offsetx, uint32_t offsety);
+
 bool tile_buf_alloc_component_data_decode(tile_buf_component_t *buf);
 
+/* grow the data array of a narrow buffer to hold 32 bit samples,
+ keeping the 16 bit samples at its start */
+bool tile_buf_alloc_component_data_wide(tile_buf_component_t *buf);
+
+/* widen the 16 bit samples of a narrow buffer in place to 32 bit samples */
+bool tile_buf_widen(tile_buf_component_t *buf);
+
 bool tile_buf_alloc_component_data_encode(tile_buf_component_t *buf);
 
 bool tile_buf_is_decode_region(tile_buf_component_t *buf);
@@ -73,6 +94,13 @@ void tile_buf_destroy_component(tile_buf_component_t *comp);
  */
 bool tile_buf_hit_test(tile_buf_component_t *comp, rect_t *rect);
 
+/* Check if rect overlaps with the region of one sub-band of one resolution,
+ or with the region of one of the areas if there are areas.
+ rect coordinates must be stored in the band's coordinate system
+ */
+bool tile_buf_hit_test_band(tile_buf_component_t *comp, uint32_t resno,
+		uint32_t bandno, rect_t *rect);
+
 /* sub-band coordinates */
 pt_t tile_buf_get_uninterleaved_range(tile_buf_component_t *comp,
 		uint32_t resno, bool is_even, bool is_horizontal);
@@ -0,0 +1,210 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Process-wide header and decoded tile caches: with the caches enabled,
+ repeated full, area and tile decodes of the same file must match decodes
+ with the caches disabled. Cache statistics must count hits and misses,
+ a tile decoded with different parameters must not be served from the
+ cache, and a file that is rewritten must not be served from either cache.
+
+ usage: test_caches <file>
+ */
+
+#include "test_common.h"
+
+using namespace grk_test;
+
+/**
+ Decode one tile with grk_get_decoded_tile
+ */
+static grk_image_t* decode_test_tile(const char *file, uint32_t tile_index,
+		uint32_t reduce) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = reduce;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return nullptr;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	if (stream && grk_read_header(stream, codec, &image))
+		rc = grk_get_decoded_tile(codec, stream, image, tile_index);
+	if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc && image) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+	return image;
+}
+
+static bool encode_tiled(grk_image_t *image, const char *file) {
+	return encode_test_image(image, file, [](grk_cparameters_t *parameters) {
+		parameters->tile_size_on = true;
+		parameters->cp_tdx = 64;
+		parameters->cp_tdy = 64;
+		parameters->tp_on = 1;
+		parameters->tp_flag = 'R';
+	});
+}
+
+/* decode area that covers parts of four tiles */
+const uint32_t area[] = { 40, 50, 100, 120 };
+
+static bool test_header_cache(const char *file, grk_image_t *original) {
+	bool rc = true;
+	auto area_reference = decode_test_image(file, nullptr, area[0], area[1],
+			area[2], area[3]);
+	grk_set_header_cache_size(4);
+	/* first decode fills the cache, and later ones read from it */
+	for (uint32_t i = 0; i < 3 && rc; ++i) {
+		char msg[256];
+		sprintf(msg, "header cache, decode %u", i);
+		auto decoded = decode_test_image(file);
+		rc = compare_test_images(msg, original, decoded);
+		if (decoded)
+			grk_image_destroy(decoded);
+		if (rc) {
+			strcat(msg, ", decode area");
+			decoded = decode_test_image(file, nullptr, area[0], area[1], area[2],
+					area[3]);
+			rc = compare_test_images(msg, area_reference, decoded);
+			if (decoded)
+				grk_image_destroy(decoded);
+		}
+	}
+	if (area_reference)
+		grk_image_destroy(area_reference);
+
+	/* rewrite file with a different image: cached header must not be used */
+	if (rc) {
+		auto other = create_test_image(3, 190, 150, 8, false, PATTERN_CHECKER);
+		if (!other || !encode_tiled(other, file)) {
+			fprintf(stderr, "header cache: encode failed\n");
+			rc = false;
+		} else {
+			auto decoded = decode_test_image(file);
+			rc = compare_test_images("header cache, rewritten file", other,
+					decoded);
+			if (decoded)
+				grk_image_destroy(decoded);
+		}
+		if (other)
+			grk_image_destroy(other);
+	}
+	grk_set_header_cache_size(0);
+	return rc;
+}
+
+static bool test_tile_cache(const char *file) {
+	const uint32_t tiles[] = { 0, 5, 0, 5, 7 };
+	const uint32_t reduce[] = { 0, 0, 0, 1, 0 };
+	const bool hit[] = { false, false, true, false, false };
+	const uint32_t num_tiles = sizeof(tiles) / sizeof(tiles[0]);
+	grk_image_t *references[num_tiles] = { };
+	bool rc = true;
+	for (uint32_t i = 0; i < num_tiles && rc; ++i) {
+		references[i] = decode_test_tile(file, tiles[i], reduce[i]);
+		rc = references[i] != nullptr;
+	}
+	if (!rc)
+		fprintf(stderr, "tile cache: decode failed\n");
+	grk_set_tile_cache_size(16 << 20);
+	grk_tile_cache_stats_t stats;
+	grk_get_tile_cache_stats(&stats);
+	for (uint32_t i = 0; i < num_tiles && rc; ++i) {
+		char msg[256];
+		sprintf(msg, "tile cache, tile %u, reduce %u", tiles[i], reduce[i]);
+		auto decoded = decode_test_tile(file, tiles[i], reduce[i]);
+		rc = compare_test_images(msg, references[i], decoded);
+		if (decoded)
+			grk_image_destroy(decoded);
+		grk_tile_cache_stats_t next;
+		grk_get_tile_cache_stats(&next);
+		if (rc
+				&& (next.hits - stats.hits != (hit[i] ? 1U : 0U)
+						|| next.misses - stats.misses != (hit[i] ? 0U : 1U))) {
+			fprintf(stderr, "%s: expected cache %s\n", msg,
+					hit[i] ? "hit" : "miss");
+			rc = false;
+		}
+		stats = next;
+	}
+	if (rc && (stats.num_tiles != 4 || !stats.num_bytes)) {
+		fprintf(stderr, "tile cache: %u tiles held, expected 4\n",
+				(uint32_t) stats.num_tiles);
+		rc = false;
+	}
+
+	/* rewrite file with a different image: cached tile must not be used */
+	if (rc) {
+		auto other = create_test_image(3, 203, 149, 8, false, PATTERN_CHECKER);
+		if (!other || !encode_tiled(other, file)) {
+			fprintf(stderr, "tile cache: encode failed\n");
+			rc = false;
+		} else {
+			auto decoded = decode_test_tile(file, 0, 0);
+			rc = decoded
+					&& compare_test_components("tile cache, rewritten file",
+							other, 0, 0, 0, decoded, 0, 0, 0, 64, 64);
+			if (decoded)
+				grk_image_destroy(decoded);
+		}
+		if (other)
+			grk_image_destroy(other);
+	}
+
+	grk_set_tile_cache_size(0);
+	grk_get_tile_cache_stats(&stats);
+	if (rc && (stats.num_tiles || stats.num_bytes)) {
+		fprintf(stderr, "tile cache: tiles held after cache was disabled\n");
+		rc = false;
+	}
+	for (uint32_t i = 0; i < num_tiles; ++i) {
+		if (references[i])
+			grk_image_destroy(references[i]);
+	}
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	auto image = create_test_image(3, 217, 161, 8, false, PATTERN_NATURAL);
+	if (!image || !encode_tiled(image, file)) {
+		fprintf(stderr, "encode failed\n");
+		rc = 1;
+	} else if (!test_header_cache(file, image)) {
+		rc = 1;
+	} else if (!encode_tiled(image, file) || !test_tile_cache(file)) {
+		rc = 1;
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
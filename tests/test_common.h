@@ -0,0 +1,325 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Helpers shared by the API non-regression tests: synthetic test images,
+ encoding to a file, plain full decode, and image comparison.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "grok.h"
+
+namespace grk_test {
+
+static void error_callback(const char *msg, void *client_data) {
+	(void) client_data;
+	fprintf(stderr, "[ERROR] %s", msg);
+}
+
+enum test_pattern_t {
+	/* smooth gradients, texture and a little noise */
+	PATTERN_NATURAL,
+	/* random mix of minimum and maximum sample values, which drives
+	 wavelet coefficients to the limits of their range */
+	PATTERN_EXTREME,
+	/* checkerboard of minimum and maximum sample values: largest
+	 high pass coefficients */
+	PATTERN_CHECKER
+};
+
+/* deterministic pseudo-random generator, so that tests are repeatable */
+struct test_rand_t {
+	explicit test_rand_t(uint32_t seed) :
+			state(seed ? seed : 1) {
+	}
+	uint32_t next(void) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	uint32_t state;
+};
+
+static inline bool has_extension(const char *path, const char *ext) {
+	size_t len = strlen(path);
+	size_t ext_len = strlen(ext);
+	return len >= ext_len && !strcmp(path + len - ext_len, ext);
+}
+
+/**
+ Create a test image. Components may be sub-sampled by dx and dy.
+ */
+static grk_image_t* create_test_image(uint32_t numcomps, uint32_t w,
+		uint32_t h, uint32_t prec, bool sgnd, test_pattern_t pattern,
+		uint32_t dx = 1, uint32_t dy = 1) {
+	grk_image_cmptparm_t cmptparms[4];
+	if (numcomps == 0 || numcomps > 4)
+		return nullptr;
+	memset(cmptparms, 0, sizeof(cmptparms));
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto parm = cmptparms + compno;
+		// only chroma components are sub-sampled
+		parm->dx = compno ? dx : 1;
+		parm->dy = compno ? dy : 1;
+		parm->w = (w + parm->dx - 1) / parm->dx;
+		parm->h = (h + parm->dy - 1) / parm->dy;
+		parm->prec = prec;
+		parm->sgnd = sgnd;
+	}
+	auto image = grk_image_create(numcomps, cmptparms,
+			numcomps >= 3 ? GRK_CLRSPC_SRGB : GRK_CLRSPC_GRAY);
+	if (!image)
+		return nullptr;
+	image->x0 = 0;
+	image->y0 = 0;
+	image->x1 = w;
+	image->y1 = h;
+
+	int64_t maxval = ((int64_t) 1 << prec) - 1;
+	int64_t offset = sgnd ? ((int64_t) 1 << (prec - 1)) : 0;
+	test_rand_t rnd(prec * 7919 + numcomps);
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		for (uint32_t y = 0; y < comp->h; ++y) {
+			for (uint32_t x = 0; x < comp->w; ++x) {
+				int64_t val;
+				if (pattern == PATTERN_EXTREME) {
+					val = (rnd.next() & 1) ? maxval : 0;
+				} else if (pattern == PATTERN_CHECKER) {
+					val = ((x + y) & 1) ? maxval : 0;
+				} else {
+					double fx = (double) x / comp->w;
+					double fy = (double) y / comp->h;
+					double v = 0.45 * (fx + fy) + 0.05 * compno
+							+ 0.1 * (((x / 8) + (y / 8)) & 1)
+							+ 0.02 * ((double) (rnd.next() & 0xFF) / 255.0);
+					val = (int64_t) (v * (double) maxval);
+					if (val > maxval)
+						val = maxval;
+					if (val < 0)
+						val = 0;
+				}
+				comp->data[x + (size_t) y * comp->w] = (int32_t) (val - offset);
+			}
+		}
+	}
+	return image;
+}
+
+/**
+ Deep copy of an image
+ */
+static grk_image_t* clone_test_image(grk_image_t *src) {
+	grk_image_cmptparm_t cmptparms[4];
+	if (src->numcomps == 0 || src->numcomps > 4)
+		return nullptr;
+	memset(cmptparms, 0, sizeof(cmptparms));
+	for (uint32_t compno = 0; compno < src->numcomps; ++compno) {
+		auto comp = src->comps + compno;
+		auto parm = cmptparms + compno;
+		parm->dx = comp->dx;
+		parm->dy = comp->dy;
+		parm->w = comp->w;
+		parm->h = comp->h;
+		parm->x0 = comp->x0;
+		parm->y0 = comp->y0;
+		parm->prec = comp->prec;
+		parm->sgnd = comp->sgnd;
+	}
+	auto image = grk_image_create(src->numcomps, cmptparms, src->color_space);
+	if (!image)
+		return nullptr;
+	image->x0 = src->x0;
+	image->y0 = src->y0;
+	image->x1 = src->x1;
+	image->y1 = src->y1;
+	for (uint32_t compno = 0; compno < src->numcomps; ++compno) {
+		auto comp = src->comps + compno;
+		memcpy(image->comps[compno].data, comp->data,
+				(size_t) comp->w * comp->h * sizeof(int32_t));
+	}
+	return image;
+}
+
+/**
+ Encode an image to a .j2k or .jp2 file. Encoding is lossless, unless
+ setup changes the encoding parameters. The encoder takes ownership
+ of the sample data it is given, so a copy of the image is encoded,
+ and the caller's image is left intact for comparison.
+ */
+static bool encode_test_image(grk_image_t *src, const char *path,
+		std::function<void(grk_cparameters_t*)> setup = nullptr,
+		grk_compress_stats_t *stats = nullptr) {
+	auto image = clone_test_image(src);
+	if (!image)
+		return false;
+	grk_cparameters_t parameters;
+	grk_set_default_encoder_parameters(&parameters);
+	parameters.tcp_numlayers = 1;
+	parameters.tcp_rates[0] = 0;
+	parameters.cp_disto_alloc = 1;
+	parameters.tcp_mct = image->numcomps >= 3 && image->comps[1].dx == 1
+			&& image->comps[1].dy == 1 ? 1 : 0;
+	if (setup)
+		setup(&parameters);
+
+	auto codec = grk_create_compress(
+			has_extension(path, ".jp2") ? GRK_CODEC_JP2 : GRK_CODEC_J2K);
+	if (!codec) {
+		grk_image_destroy(image);
+		return false;
+	}
+	grk_set_error_handler(codec, error_callback, nullptr);
+	bool rc = false;
+	grk_stream_t *stream = nullptr;
+	if (!grk_setup_encoder(codec, &parameters, image))
+		goto cleanup;
+	stream = grk_stream_create_default_file_stream(path, false);
+	if (!stream)
+		goto cleanup;
+	rc = grk_start_compress(codec, image, stream) && grk_encode(codec, stream)
+			&& grk_end_compress(codec, stream);
+	if (rc && stats)
+		rc = grk_get_compress_stats(codec, stats);
+	cleanup: if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	grk_image_destroy(image);
+	return rc;
+}
+
+static grk_codec_t* create_test_decompressor(const char *path,
+		grk_dparameters_t *parameters) {
+	auto codec = grk_create_decompress(
+			has_extension(path, ".jp2") ? GRK_CODEC_JP2 : GRK_CODEC_J2K);
+	if (!codec)
+		return nullptr;
+	grk_set_error_handler(codec, error_callback, nullptr);
+	if (!grk_setup_decoder(codec, parameters)) {
+		grk_destroy_codec(codec);
+		return nullptr;
+	}
+	return codec;
+}
+
+/**
+ Plain decode of a file: setup may change the decoding parameters,
+ and the decode area is set to (x0,y0,x1,y1) unless it is empty.
+ Returns the decoded image, or nullptr on failure.
+ */
+static grk_image_t* decode_test_image(const char *path,
+		std::function<void(grk_dparameters_t*)> setup = nullptr, uint32_t x0 =
+				0, uint32_t y0 = 0, uint32_t x1 = 0, uint32_t y1 = 0) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	if (setup)
+		setup(&parameters);
+	auto codec = create_test_decompressor(path, &parameters);
+	if (!codec)
+		return nullptr;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(path, true);
+	if (!stream)
+		goto cleanup;
+	if (!grk_read_header(stream, codec, &image))
+		goto cleanup;
+	if (!grk_set_decode_area(codec, image, x0, y0, x1, y1))
+		goto cleanup;
+	rc = grk_decode(codec, nullptr, stream, image)
+			&& grk_end_decompress(codec, stream);
+	cleanup: if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc && image) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+	return image;
+}
+
+/**
+ Compare component (compno_a of a) with component (compno_b of b),
+ over a window of width w and height h, starting at (xa,ya) in a and at (xb,yb) in b
+ */
+static bool compare_test_components(const char *msg, grk_image_t *a,
+		uint32_t compno_a, uint32_t xa, uint32_t ya, grk_image_t *b,
+		uint32_t compno_b, uint32_t xb, uint32_t yb, uint32_t w, uint32_t h) {
+	auto ca = a->comps + compno_a;
+	auto cb = b->comps + compno_b;
+	if (!ca->data || !cb->data) {
+		fprintf(stderr, "%s: component data missing\n", msg);
+		return false;
+	}
+	if (xa + w > ca->w || ya + h > ca->h || xb + w > cb->w || yb + h > cb->h) {
+		fprintf(stderr, "%s: window out of bounds\n", msg);
+		return false;
+	}
+	for (uint32_t y = 0; y < h; ++y) {
+		for (uint32_t x = 0; x < w; ++x) {
+			int32_t va = ca->data[xa + x + (size_t) (ya + y) * ca->w];
+			int32_t vb = cb->data[xb + x + (size_t) (yb + y) * cb->w];
+			if (va != vb) {
+				fprintf(stderr,
+						"%s: component %u/%u differs at (%u,%u): %d != %d\n",
+						msg, compno_a, compno_b, x, y, va, vb);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ Check that two images have identical geometry and samples
+ */
+static bool compare_test_images(const char *msg, grk_image_t *a,
+		grk_image_t *b) {
+	if (!a || !b) {
+		fprintf(stderr, "%s: missing image\n", msg);
+		return false;
+	}
+	if (a->numcomps != b->numcomps) {
+		fprintf(stderr, "%s: number of components differs: %u != %u\n", msg,
+				a->numcomps, b->numcomps);
+		return false;
+	}
+	for (uint32_t compno = 0; compno < a->numcomps; ++compno) {
+		auto ca = a->comps + compno;
+		auto cb = b->comps + compno;
+		if (ca->w != cb->w || ca->h != cb->h || ca->prec != cb->prec
+				|| ca->sgnd != cb->sgnd) {
+			fprintf(stderr, "%s: component %u geometry differs\n", msg, compno);
+			return false;
+		}
+		if (!compare_test_components(msg, a, compno, 0, 0, b, compno, 0, 0,
+				ca->w, ca->h))
+			return false;
+	}
+	return true;
+}
+
+}
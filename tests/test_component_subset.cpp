@@ -0,0 +1,181 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Component subset decode: the output image must hold only the selected
+ components, in increasing index order, and each of them must match
+ the same component of a full decode. Components that take part in a
+ multiple component transform, components outside of it, sub-sampled
+ components, reduced resolution and decode areas are covered.
+ Setting up the same decompressor again without a selection must decode
+ all components. Selecting a component that does not exist must fail.
+
+ usage: test_component_subset <file>
+ */
+
+#include "test_common.h"
+#include <algorithm>
+#include <vector>
+
+using namespace grk_test;
+
+static bool test_subset(const char *msg, const char *file,
+		std::vector<uint32_t> comps, uint32_t reduce, uint32_t x0 = 0,
+		uint32_t y0 = 0, uint32_t x1 = 0, uint32_t y1 = 0) {
+	auto reference = decode_test_image(file,
+			[reduce](grk_dparameters_t *parameters) {
+				parameters->cp_reduce = reduce;
+			}, x0, y0, x1, y1);
+	auto subset = decode_test_image(file,
+			[reduce, &comps](grk_dparameters_t *parameters) {
+				parameters->cp_reduce = reduce;
+				parameters->numcomps_to_decode = (uint32_t) comps.size();
+				parameters->comps_to_decode = comps.data();
+			}, x0, y0, x1, y1);
+	bool rc = reference && subset;
+	if (!rc) {
+		fprintf(stderr, "%s: decode failed\n", msg);
+	} else if (subset->numcomps != comps.size()) {
+		fprintf(stderr, "%s: %u components decoded, expected %u\n", msg,
+				subset->numcomps, (uint32_t) comps.size());
+		rc = false;
+	}
+	/* selection may be given in any order */
+	std::sort(comps.begin(), comps.end());
+	for (uint32_t i = 0; i < comps.size() && rc; ++i) {
+		auto ref_comp = reference->comps + comps[i];
+		auto comp = subset->comps + i;
+		if (comp->w != ref_comp->w || comp->h != ref_comp->h
+				|| comp->dx != ref_comp->dx || comp->dy != ref_comp->dy) {
+			fprintf(stderr, "%s: component %u geometry differs\n", msg,
+					comps[i]);
+			rc = false;
+		} else {
+			rc = compare_test_components(msg, reference, comps[i], 0, 0,
+					subset, i, 0, 0, comp->w, comp->h);
+		}
+	}
+	if (reference)
+		grk_image_destroy(reference);
+	if (subset)
+		grk_image_destroy(subset);
+	return rc;
+}
+
+/**
+ Set up a decompressor with a selection, then set it up again without one:
+ all components must be decoded
+ */
+static bool test_clear_subset(const char *file) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	uint32_t comps[] = { 1 };
+	parameters.numcomps_to_decode = 1;
+	parameters.comps_to_decode = comps;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return false;
+	grk_set_default_decoder_parameters(&parameters);
+	grk_image_t *image = nullptr;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	bool rc = stream && grk_setup_decoder(codec, &parameters)
+			&& grk_read_header(stream, codec, &image)
+			&& grk_set_decode_area(codec, image, 0, 0, 0, 0)
+			&& grk_decode(codec, nullptr, stream, image)
+			&& grk_end_decompress(codec, stream);
+	if (!rc) {
+		fprintf(stderr, "cleared selection: decode failed\n");
+	} else {
+		auto reference = decode_test_image(file);
+		rc = compare_test_images("cleared selection", reference, image);
+		if (reference)
+			grk_image_destroy(reference);
+	}
+	if (stream)
+		grk_stream_destroy(stream);
+	if (image)
+		grk_image_destroy(image);
+	grk_destroy_codec(codec);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	/* four components: MCT on the first three */
+	auto image = create_test_image(4, 181, 137, 8, false, PATTERN_NATURAL);
+	if (!image || !encode_test_image(image, file,
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 64;
+				parameters->cp_tdy = 64;
+			})) {
+		fprintf(stderr, "MCT: encode failed\n");
+		rc = 1;
+	} else if (!test_subset("MCT, component 1", file, { 1 }, 0)
+			|| !test_subset("MCT, components 2 and 0", file, { 2, 0 }, 0)
+			|| !test_subset("MCT, component 3", file, { 3 }, 0)
+			|| !test_subset("MCT, components 0 and 3, reduced", file, { 0, 3 },
+					1)
+			|| !test_subset("MCT, component 2, decode area", file, { 2 }, 0, 30,
+					20, 150, 100) || !test_clear_subset(file)) {
+		rc = 1;
+	}
+	if (image)
+		grk_image_destroy(image);
+
+	/* sub-sampled chroma, no MCT */
+	if (!rc) {
+		image = create_test_image(3, 181, 137, 8, false, PATTERN_NATURAL, 2, 2);
+		if (!image || !encode_test_image(image, file)) {
+			fprintf(stderr, "sub-sampled: encode failed\n");
+			rc = 1;
+		} else if (!test_subset("sub-sampled, component 0", file, { 0 }, 0)
+				|| !test_subset("sub-sampled, components 1 and 2", file,
+						{ 1, 2 }, 0)
+				|| !test_subset("sub-sampled, component 2, reduced", file, { 2 },
+						1)) {
+			rc = 1;
+		}
+		if (image)
+			grk_image_destroy(image);
+	}
+
+	/* component index out of range */
+	if (!rc) {
+		uint32_t comps[] = { 1, 3 };
+		auto decoded = decode_test_image(file,
+				[&comps](grk_dparameters_t *parameters) {
+					parameters->numcomps_to_decode = 2;
+					parameters->comps_to_decode = comps;
+				});
+		if (decoded) {
+			fprintf(stderr, "component 3 of 3 decoded\n");
+			grk_image_destroy(decoded);
+			rc = 1;
+		}
+	}
+	grk_deinitialize();
+	return rc;
+}
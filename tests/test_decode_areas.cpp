@@ -0,0 +1,152 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Batched area decode: every image returned by grk_decode_areas must match
+ a decode of its area on its own, for intersecting areas, disjoint areas in
+ the same tile, and areas far apart whose bounding box spans tiles that
+ none of them need. The header image receives the bounding box of all
+ areas. Areas outside of the image must fail.
+
+ usage: test_decode_areas <file>
+ */
+
+#include "test_common.h"
+#include <algorithm>
+#include <vector>
+
+using namespace grk_test;
+
+static bool test_areas(const char *msg, const char *file,
+		const std::vector<grk_decode_area_t> &areas, uint32_t reduce) {
+	grk_decode_area_t bounds = areas[0];
+	for (auto &area : areas) {
+		bounds.x0 = std::min(bounds.x0, area.x0);
+		bounds.y0 = std::min(bounds.y0, area.y0);
+		bounds.x1 = std::max(bounds.x1, area.x1);
+		bounds.y1 = std::max(bounds.y1, area.y1);
+	}
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = reduce;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return false;
+	std::vector<grk_image_t*> area_images(areas.size(), nullptr);
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	if (stream && grk_read_header(stream, codec, &image))
+		rc = grk_decode_areas(codec, stream, image, areas.data(),
+				(uint32_t) areas.size(), area_images.data());
+	if (!rc) {
+		fprintf(stderr, "%s: decode failed\n", msg);
+	} else if (image->x0 != bounds.x0 || image->y0 != bounds.y0
+			|| image->x1 != bounds.x1 || image->y1 != bounds.y1) {
+		fprintf(stderr,
+				"%s: decoded (%u,%u,%u,%u), expected (%u,%u,%u,%u)\n", msg,
+				image->x0, image->y0, image->x1, image->y1, bounds.x0,
+				bounds.y0, bounds.x1, bounds.y1);
+		rc = false;
+	}
+	for (size_t i = 0; i < areas.size() && rc; ++i) {
+		char area_msg[256];
+		sprintf(area_msg, "%s, area %u", msg, (uint32_t) i);
+		auto &area = areas[i];
+		auto reference = decode_test_image(file,
+				[reduce](grk_dparameters_t *parameters) {
+					parameters->cp_reduce = reduce;
+				}, area.x0, area.y0, area.x1, area.y1);
+		rc = compare_test_images(area_msg, reference, area_images[i]);
+		if (reference)
+			grk_image_destroy(reference);
+	}
+	for (auto area_image : area_images) {
+		if (area_image)
+			grk_image_destroy(area_image);
+	}
+	if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (image)
+		grk_image_destroy(image);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	auto image = create_test_image(3, 217, 161, 8, false, PATTERN_NATURAL);
+	if (!image || !encode_test_image(image, file,
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 128;
+				parameters->cp_tdy = 128;
+				/* small code-blocks, so that areas in one tile need different ones */
+				parameters->cblockw_init = 16;
+				parameters->cblockh_init = 16;
+			})) {
+		fprintf(stderr, "encode failed\n");
+		rc = 1;
+	}
+	/* two intersecting areas, one inside the first, and two disjoint areas */
+	std::vector<grk_decode_area_t> viewport = { { 10, 10, 80, 80 }, { 150, 5,
+			200, 40 }, { 60, 60, 140, 120 }, { 0, 130, 30, 161 }, { 20, 20,
+			30, 30 } };
+	/* a cross: the bounding box is much larger than the two strips */
+	std::vector<grk_decode_area_t> cross = { { 0, 70, 217, 80 }, { 100, 0,
+			110, 161 } };
+	/* strips that only intersect through a third area */
+	std::vector<grk_decode_area_t> chain = { { 0, 0, 40, 20 }, { 100, 0, 140,
+			20 }, { 30, 10, 110, 15 } };
+	/* disjoint areas in the same tile */
+	std::vector<grk_decode_area_t> same_tile = { { 2, 3, 14, 12 }, { 90, 94,
+			120, 122 }, { 5, 100, 20, 125 } };
+	/* opposite corners: no tile between them is needed */
+	std::vector<grk_decode_area_t> corners = { { 0, 0, 20, 18 }, { 190, 140,
+			217, 161 } };
+	if (!rc
+			&& (!test_areas("viewport", file, viewport, 0)
+					|| !test_areas("viewport, reduced", file, viewport, 1)
+					|| !test_areas("cross", file, cross, 0)
+					|| !test_areas("chain", file, chain, 0)
+					|| !test_areas("same tile", file, same_tile, 0)
+					|| !test_areas("same tile, reduced", file, same_tile, 1)
+					|| !test_areas("corners", file, corners, 0)))
+		rc = 1;
+
+	/* area outside of image */
+	if (!rc) {
+		std::vector<grk_decode_area_t> outside = { { 10, 10, 80, 80 }, { 200,
+				100, 218, 120 } };
+		if (test_areas("outside", file, outside, 0)) {
+			fprintf(stderr, "area outside of image decoded\n");
+			rc = 1;
+		}
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
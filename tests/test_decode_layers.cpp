@@ -0,0 +1,139 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Quality layer refinement: after a decode of the first layer, refining
+ the same image with grk_decode_layers to more layers, to all layers, and
+ back to fewer layers must give the same image as a fresh decode of that
+ many layers, for the whole image and for a reduced decode area.
+ Refinement must fail unless the decoder was set up for it.
+
+ usage: test_decode_layers <file>
+ */
+
+#include "test_common.h"
+
+using namespace grk_test;
+
+static bool test_refinement(const char *msg, const char *file,
+		grk_image_t *original, uint32_t reduce, uint32_t x0 = 0, uint32_t y0 =
+				0, uint32_t x1 = 0, uint32_t y1 = 0) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.layer_refinement = true;
+	parameters.cp_layer = 1;
+	parameters.cp_reduce = reduce;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return false;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	if (stream && grk_read_header(stream, codec, &image)
+			&& grk_set_decode_area(codec, image, x0, y0, x1, y1))
+		rc = grk_decode(codec, nullptr, stream, image);
+	if (!rc)
+		fprintf(stderr, "%s: decode failed\n", msg);
+	const uint32_t layers[] = { 1, 2, 0, 3, 1, 4 };
+	for (uint32_t i = 0; i < sizeof(layers) / sizeof(layers[0]) && rc; ++i) {
+		char layer_msg[256];
+		sprintf(layer_msg, "%s, refined to %u layer(s)", msg, layers[i]);
+		/* first entry is the initial decode */
+		if (i && !grk_decode_layers(codec, image, layers[i])) {
+			fprintf(stderr, "%s: refinement failed\n", layer_msg);
+			rc = false;
+			break;
+		}
+		uint32_t num_layers = layers[i];
+		auto reference = decode_test_image(file,
+				[num_layers, reduce](grk_dparameters_t *parameters) {
+					parameters->cp_layer = num_layers;
+					parameters->cp_reduce = reduce;
+				}, x0, y0, x1, y1);
+		rc = compare_test_images(layer_msg, reference, image);
+		/* all layers of a lossless encode */
+		if (rc && !reduce && !x1 && (num_layers == 0 || num_layers == 4))
+			rc = compare_test_images(layer_msg, original, image);
+		if (reference)
+			grk_image_destroy(reference);
+	}
+	rc = rc && grk_end_decompress(codec, stream);
+	grk_destroy_codec(codec);
+	if (stream)
+		grk_stream_destroy(stream);
+	if (image)
+		grk_image_destroy(image);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	auto image = create_test_image(3, 221, 157, 8, false, PATTERN_NATURAL);
+	if (!image || !encode_test_image(image, file,
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 96;
+				parameters->cp_tdy = 64;
+				parameters->tcp_numlayers = 4;
+				parameters->tcp_rates[0] = 80;
+				parameters->tcp_rates[1] = 30;
+				parameters->tcp_rates[2] = 10;
+				parameters->tcp_rates[3] = 0;
+			})) {
+		fprintf(stderr, "encode failed\n");
+		rc = 1;
+	} else if (!test_refinement("full image", file, image, 0)
+			|| !test_refinement("reduced decode area", file, image, 1, 40, 30,
+					200, 120)) {
+		rc = 1;
+	}
+
+	/* refinement needs layer_refinement */
+	if (!rc) {
+		grk_dparameters_t parameters;
+		grk_set_default_decoder_parameters(&parameters);
+		parameters.cp_layer = 1;
+		auto codec = create_test_decompressor(file, &parameters);
+		grk_image_t *decoded = nullptr;
+		auto stream = grk_stream_create_default_file_stream(file, true);
+		if (!codec || !stream || !grk_read_header(stream, codec, &decoded)
+				|| !grk_set_decode_area(codec, decoded, 0, 0, 0, 0)
+				|| !grk_decode(codec, nullptr, stream, decoded)
+				|| grk_decode_layers(codec, decoded, 2)) {
+			fprintf(stderr, "refinement without layer_refinement succeeded\n");
+			rc = 1;
+		}
+		if (codec)
+			grk_destroy_codec(codec);
+		if (stream)
+			grk_stream_destroy(stream);
+		if (decoded)
+			grk_image_destroy(decoded);
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
@@ -0,0 +1,396 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ grk_decompress decode service (-S -): jobs read from stdin must each get
+ a reply in order, and the images they store must match a plain decode
+ with the same reduce, layer and area parameters. The service must keep
+ going after a job fails, alternate between J2K and JP2 jobs, accept
+ quoted paths that contain spaces, and report job and failure counts in
+ its stats line. Served from a Unix domain socket, an idle client must not
+ hold up another client's job, and must be disconnected once idle for
+ longer than the service timeout.
+
+ usage: test_decode_service <grk_decompress> <work file>
+ */
+
+#include "test_common.h"
+#include <vector>
+#include <chrono>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace grk_test;
+
+struct service_job_t {
+	std::string infile;
+	std::string options;
+	uint32_t reduce;
+	uint32_t layers;
+	uint32_t x0, y0, x1, y1;
+	bool ok;
+	// enclose paths in quotes
+	bool quote;
+};
+
+static std::string output_file(const std::string &work, size_t i, bool quote) {
+	return work + (quote ? " out " : "_") + std::to_string(i) + ".raw";
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> &data) {
+	auto f = fopen(path, "rb");
+	if (!f)
+		return false;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t) ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool rc = fread(data.data(), 1, data.size(), f) == data.size();
+	fclose(f);
+	return rc;
+}
+
+/**
+ Compare 8 bit raw output, with components one after another,
+ to a plain decode with the job's parameters
+ */
+static bool compare_raw_output(const char *msg, const service_job_t &job,
+		const char *outfile) {
+	std::vector<uint8_t> data;
+	if (!read_file(outfile, data)) {
+		fprintf(stderr, "%s: no output\n", msg);
+		return false;
+	}
+	auto reduce = job.reduce;
+	auto layers = job.layers;
+	auto reference = decode_test_image(job.infile.c_str(),
+			[reduce, layers](grk_dparameters_t *parameters) {
+				parameters->cp_reduce = reduce;
+				parameters->cp_layer = layers;
+			}, job.x0, job.y0, job.x1, job.y1);
+	if (!reference) {
+		fprintf(stderr, "%s: decode failed\n", msg);
+		return false;
+	}
+	bool rc = true;
+	size_t pos = 0;
+	for (uint32_t compno = 0; compno < reference->numcomps && rc; ++compno) {
+		auto comp = reference->comps + compno;
+		size_t len = (size_t) comp->w * comp->h;
+		if (pos + len > data.size()) {
+			fprintf(stderr, "%s: output is too short\n", msg);
+			rc = false;
+			break;
+		}
+		for (size_t i = 0; i < len && rc; ++i) {
+			if (data[pos + i] != comp->data[i]) {
+				fprintf(stderr, "%s: component %u differs at sample %u\n", msg,
+						compno, (uint32_t) i);
+				rc = false;
+			}
+		}
+		pos += len;
+	}
+	if (rc && pos != data.size()) {
+		fprintf(stderr, "%s: output is too long\n", msg);
+		rc = false;
+	}
+	grk_image_destroy(reference);
+	return rc;
+}
+
+#ifndef _WIN32
+static int connect_service(const std::string &path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, path.c_str());
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void set_receive_timeout(int fd, uint32_t seconds) {
+	struct timeval tv;
+	tv.tv_sec = seconds;
+	tv.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+static bool send_line(int fd, const std::string &line) {
+	std::string data = line + "\n";
+	return send(fd, data.c_str(), data.size(), 0) == (ssize_t) data.size();
+}
+
+static bool receive_line(int fd, std::string &line) {
+	line.clear();
+	char c;
+	while (recv(fd, &c, 1, 0) == 1) {
+		if (c == '\n')
+			return true;
+		line += c;
+	}
+	return false;
+}
+
+/**
+ Serve jobs from a socket, with a short timeout for idle connections
+ */
+static bool test_socket(const std::string &decompress, const std::string &work,
+		const std::string &j2k) {
+	const uint32_t timeout = 3;
+	std::string path = work + ".sock";
+	std::string outfile = work + " socket out.raw";
+	remove(path.c_str());
+	remove(outfile.c_str());
+	std::string timeout_arg = std::to_string(timeout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		execl(decompress.c_str(), decompress.c_str(), "-S", path.c_str(), "-W",
+				timeout_arg.c_str(), (char*) nullptr);
+		_exit(127);
+	}
+	if (pid < 0) {
+		fprintf(stderr, "socket: unable to start service\n");
+		return false;
+	}
+	int idle = -1;
+	for (uint32_t i = 0; i < 100 && idle < 0; ++i) {
+		idle = connect_service(path);
+		if (idle < 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	if (idle < 0) {
+		fprintf(stderr, "socket: unable to connect to service\n");
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		return false;
+	}
+
+	/* a job is served while another client is connected and idle */
+	bool rc = true;
+	int client = connect_service(path);
+	std::string reply;
+	if (client < 0) {
+		fprintf(stderr, "socket: unable to connect second client\n");
+		rc = false;
+	} else {
+		set_receive_timeout(client, 30);
+		if (!send_line(client, "\"" + j2k + "\" \"" + outfile + "\" -r 1")
+				|| !receive_line(client, reply) || reply.compare(0, 5, "ok 1 ")) {
+			fprintf(stderr, "socket: unexpected reply %s\n", reply.c_str());
+			rc = false;
+		}
+		close(client);
+	}
+	if (rc) {
+		service_job_t job = { j2k, "", 1, 0, 0, 0, 0, 0, true, true };
+		rc = compare_raw_output("socket", job, outfile.c_str());
+	}
+	char c;
+	if (rc && (recv(idle, &c, 1, MSG_DONTWAIT) != -1 || errno != EAGAIN)) {
+		fprintf(stderr, "socket: idle client disconnected too early\n");
+		rc = false;
+	}
+
+	/* the idle client is disconnected after the timeout */
+	set_receive_timeout(idle, 10 * timeout);
+	auto start = std::chrono::steady_clock::now();
+	if (rc && recv(idle, &c, 1, 0) != 0) {
+		fprintf(stderr, "socket: idle client was not disconnected\n");
+		rc = false;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()
+			- start;
+	if (rc && elapsed.count() > 2 * timeout) {
+		fprintf(stderr, "socket: idle client disconnected after %.1f s\n",
+				elapsed.count());
+		rc = false;
+	}
+	close(idle);
+
+	/* stop the service: it exits once its connections are closed */
+	client = connect_service(path);
+	if (client < 0 || !send_line(client, "quit")) {
+		fprintf(stderr, "socket: unable to stop service\n");
+		rc = false;
+	}
+	if (client >= 0)
+		close(client);
+	int status = -1;
+	bool stopped = false;
+	for (uint32_t i = 0; i < 100 && !stopped; ++i) {
+		stopped = waitpid(pid, &status, WNOHANG) == pid;
+		if (!stopped)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	if (!stopped) {
+		fprintf(stderr, "socket: service did not stop\n");
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		rc = false;
+	} else if (!WIFEXITED(status) || WEXITSTATUS(status)
+			|| access(path.c_str(), F_OK) == 0) {
+		fprintf(stderr, "socket: service did not exit cleanly\n");
+		rc = false;
+	}
+	remove(outfile.c_str());
+	return rc;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <grk_decompress> <work file>\n", argv[0]);
+		return 1;
+	}
+	std::string decompress = argv[1];
+	std::string work = argv[2];
+	std::string j2k = work + ".j2k";
+	std::string j2k_spaces = work + " with spaces.j2k";
+	std::string jp2 = work + ".jp2";
+	std::string jobs_file = work + "_jobs.txt";
+	std::string replies_file = work + "_replies.txt";
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	auto gray = create_test_image(1, 211, 163, 8, false, PATTERN_NATURAL);
+	auto rgb = create_test_image(3, 150, 110, 8, false, PATTERN_NATURAL);
+	if (!gray || !rgb || !encode_test_image(gray, j2k.c_str(),
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 64;
+				parameters->cp_tdy = 64;
+				parameters->tcp_numlayers = 2;
+				parameters->tcp_rates[0] = 20;
+				parameters->tcp_rates[1] = 0;
+			}) || !encode_test_image(gray, j2k_spaces.c_str())
+			|| !encode_test_image(rgb, jp2.c_str())) {
+		fprintf(stderr, "encode failed\n");
+		rc = 1;
+	}
+	if (gray)
+		grk_image_destroy(gray);
+	if (rgb)
+		grk_image_destroy(rgb);
+
+	std::vector<service_job_t> jobs = {
+			{ j2k, "", 0, 0, 0, 0, 0, 0, true, false },
+			{ j2k, "-r 1", 1, 0, 0, 0, 0, 0, true, false },
+			{ jp2, "", 0, 0, 0, 0, 0, 0, true, false },
+			{ j2k, "-d 20,10,150,90", 0, 0, 20, 10, 150, 90, true, false },
+			{ work + "_missing.j2k", "", 0, 0, 0, 0, 0, 0, false, false },
+			{ j2k, "-r 2 -l 1 -d 70,0,211,163", 2, 1, 70, 0, 211, 163, true, false },
+			{ jp2, "-d 0,0,75,55", 0, 0, 0, 0, 75, 55, true, true },
+			{ j2k_spaces, "", 0, 0, 0, 0, 0, 0, true, true },
+			{ j2k_spaces, "-r \"1\" -d 0,0,100,80", 1, 0, 0, 0, 100, 80, true, true },
+			{ j2k_spaces, "", 0, 0, 0, 0, 0, 0, false, false },
+			{ j2k, "-d \"20,10,150,90", 0, 0, 0, 0, 0, 0, false, false },
+			{ j2k, "-x 1", 0, 0, 0, 0, 0, 0, false, false },
+			{ j2k, "", 0, 0, 0, 0, 0, 0, true, false } };
+	if (!rc) {
+		auto f = fopen(jobs_file.c_str(), "w");
+		if (!f) {
+			fprintf(stderr, "unable to write jobs\n");
+			rc = 1;
+		} else {
+			fprintf(f, "# decode service jobs\n");
+			for (size_t i = 0; i < jobs.size(); ++i) {
+				auto q = jobs[i].quote ? "\"" : "";
+				fprintf(f, "%s%s%s %s%s%s %s\n", q, jobs[i].infile.c_str(), q, q,
+						output_file(work, i, jobs[i].quote).c_str(), q,
+						jobs[i].options.c_str());
+			}
+			fprintf(f, "stats\nquit\n");
+			fclose(f);
+		}
+	}
+	if (!rc) {
+		for (size_t i = 0; i < jobs.size(); ++i)
+			remove(output_file(work, i, jobs[i].quote).c_str());
+		std::string cmd = "\"" + decompress + "\" -S - < \"" + jobs_file
+				+ "\" > \"" + replies_file + "\"";
+		if (system(cmd.c_str())) {
+			fprintf(stderr, "%s failed\n", cmd.c_str());
+			rc = 1;
+		}
+	}
+
+	/* one reply per job, in order, then stats */
+	auto replies = rc ? nullptr : fopen(replies_file.c_str(), "r");
+	if (!rc && !replies) {
+		fprintf(stderr, "no replies\n");
+		rc = 1;
+	}
+	uint32_t num_failed = 0;
+	for (size_t i = 0; i < jobs.size() && !rc; ++i) {
+		char status[16] = { };
+		unsigned job = 0;
+		char line[1024];
+		if (!fgets(line, sizeof(line), replies)
+				|| sscanf(line, "%15s %u", status, &job) != 2
+				|| job != i + 1) {
+			fprintf(stderr, "job %u: missing reply\n", (uint32_t) i + 1);
+			rc = 1;
+			break;
+		}
+		char msg[256];
+		sprintf(msg, "job %u", (uint32_t) i + 1);
+		if (strcmp(status, jobs[i].ok ? "ok" : "error")) {
+			fprintf(stderr, "%s: unexpected reply %s", msg, line);
+			rc = 1;
+		} else if (jobs[i].ok) {
+			std::string outfile = output_file(work, i, jobs[i].quote);
+			if (!compare_raw_output(msg, jobs[i], outfile.c_str()))
+				rc = 1;
+		} else {
+			num_failed++;
+		}
+	}
+	if (!rc) {
+		char line[1024];
+		unsigned num_jobs = 0, failed = 0;
+		if (!fgets(line, sizeof(line), replies)
+				|| sscanf(line, "stats %u %u", &num_jobs, &failed) != 2
+				|| num_jobs != jobs.size() || failed != num_failed) {
+			fprintf(stderr, "unexpected stats\n");
+			rc = 1;
+		}
+	}
+	if (replies)
+		fclose(replies);
+#ifndef _WIN32
+	if (!rc && !test_socket(decompress, work, j2k))
+		rc = 1;
+#endif
+	grk_deinitialize();
+	return rc;
+}
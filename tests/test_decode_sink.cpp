@@ -0,0 +1,200 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Streaming decode to a sink: the regions passed to the sink, put back
+ together, must match a plain decode, at full resolution and reduced,
+ for the whole image and for a decode area. A sink that returns false
+ must abort the decode, and so must a per-tile memory limit that is too small.
+
+ usage: test_decode_sink <file>
+ */
+
+#include "test_common.h"
+#include <vector>
+
+using namespace grk_test;
+
+/* image put back together from the regions passed to the sink */
+struct sink_image_t {
+	sink_image_t() :
+			numcomps(0), num_regions(0), abort_after(0) {
+	}
+	uint32_t numcomps;
+	uint32_t w[4];
+	uint32_t h[4];
+	std::vector<int32_t> data[4];
+	uint32_t num_regions;
+	/* if != 0, sink returns false for this region */
+	uint32_t abort_after;
+};
+
+static bool sink(grk_decoded_region_t *region, void *user_data) {
+	auto img = (sink_image_t*) user_data;
+	if (region->numcomps != img->numcomps)
+		return false;
+	if (img->abort_after && img->num_regions + 1 == img->abort_after)
+		return false;
+	img->num_regions++;
+	for (uint32_t compno = 0; compno < region->numcomps; ++compno) {
+		auto comp = region->comps + compno;
+		if (comp->x0 + comp->w > img->w[compno]
+				|| comp->y0 + comp->h > img->h[compno])
+			return false;
+		for (uint32_t y = 0; y < comp->h; ++y)
+			memcpy(
+					img->data[compno].data() + comp->x0
+							+ (size_t) (comp->y0 + y) * img->w[compno],
+					comp->data + (size_t) y * comp->stride,
+					comp->w * sizeof(int32_t));
+	}
+	return true;
+}
+
+/**
+ Decode to sink, with the dimensions of the reference decode
+ */
+static bool decode_to_sink(const char *path, grk_image_t *reference,
+		uint32_t reduce, uint64_t max_tile_memory, sink_image_t *img,
+		uint32_t x0 = 0, uint32_t y0 = 0, uint32_t x1 = 0, uint32_t y1 = 0) {
+	img->numcomps = reference->numcomps;
+	for (uint32_t compno = 0; compno < reference->numcomps; ++compno) {
+		img->w[compno] = reference->comps[compno].w;
+		img->h[compno] = reference->comps[compno].h;
+		img->data[compno].assign((size_t) img->w[compno] * img->h[compno],
+				-1);
+	}
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = reduce;
+	parameters.sink = sink;
+	parameters.sink_user_data = img;
+	parameters.max_tile_memory = max_tile_memory;
+	auto codec = create_test_decompressor(path, &parameters);
+	if (!codec)
+		return false;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(path, true);
+	if (stream && grk_read_header(stream, codec, &image)
+			&& grk_set_decode_area(codec, image, x0, y0, x1, y1)) {
+		rc = grk_decode(codec, nullptr, stream, image)
+				&& grk_end_decompress(codec, stream);
+		/* samples only go to the sink */
+		for (uint32_t compno = 0; compno < image->numcomps && rc; ++compno)
+			rc = image->comps[compno].data == nullptr;
+	}
+	if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (image)
+		grk_image_destroy(image);
+	return rc;
+}
+
+static bool compare_sink_image(const char *msg, grk_image_t *reference,
+		sink_image_t *img) {
+	for (uint32_t compno = 0; compno < reference->numcomps; ++compno) {
+		auto comp = reference->comps + compno;
+		if (memcmp(comp->data, img->data[compno].data(),
+				(size_t) comp->w * comp->h * sizeof(int32_t))) {
+			fprintf(stderr, "%s: component %u differs\n", msg, compno);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	/* 4 x 3 tiles, the last row and column partial */
+	auto image = create_test_image(3, 217, 161, 8, false, PATTERN_NATURAL);
+	if (!image || !encode_test_image(image, file,
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 64;
+				parameters->cp_tdy = 64;
+			})) {
+		fprintf(stderr, "encode failed\n");
+		rc = 1;
+	}
+	struct {
+		const char *msg;
+		uint32_t reduce;
+		uint32_t x0, y0, x1, y1;
+		uint32_t num_regions;
+	} cases[] = { { "full image", 0, 0, 0, 0, 0, 12 }, { "reduced", 1, 0, 0, 0,
+			0, 12 }, { "decode area", 0, 50, 30, 150, 100, 6 }, };
+	for (auto &c : cases) {
+		if (rc)
+			break;
+		uint32_t reduce = c.reduce;
+		auto reference = decode_test_image(file,
+				[reduce](grk_dparameters_t *parameters) {
+					parameters->cp_reduce = reduce;
+				}, c.x0, c.y0, c.x1, c.y1);
+		sink_image_t img;
+		if (!reference) {
+			fprintf(stderr, "%s: decode failed\n", c.msg);
+			rc = 1;
+		} else if (!decode_to_sink(file, reference, c.reduce, 0, &img, c.x0,
+				c.y0, c.x1, c.y1)) {
+			fprintf(stderr, "%s: decode to sink failed\n", c.msg);
+			rc = 1;
+		} else if (img.num_regions != c.num_regions) {
+			fprintf(stderr, "%s: %u regions passed to sink, expected %u\n",
+					c.msg, img.num_regions, c.num_regions);
+			rc = 1;
+		} else if (!compare_sink_image(c.msg, reference, &img)) {
+			rc = 1;
+		}
+
+		/* a full 64x64 tile of 3 components needs more than this */
+		if (!rc && reference) {
+			sink_image_t small;
+			if (decode_to_sink(file, reference, c.reduce, 1024, &small, c.x0,
+					c.y0, c.x1, c.y1)) {
+				fprintf(stderr, "%s: decode within 1024 bytes succeeded\n",
+						c.msg);
+				rc = 1;
+			}
+		}
+		if (!rc && reference) {
+			sink_image_t aborted;
+			aborted.abort_after = 2;
+			if (decode_to_sink(file, reference, c.reduce, 0, &aborted, c.x0,
+					c.y0, c.x1, c.y1) || aborted.num_regions != 1) {
+				fprintf(stderr, "%s: sink did not abort decode\n", c.msg);
+				rc = 1;
+			}
+		}
+		if (reference)
+			grk_image_destroy(reference);
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
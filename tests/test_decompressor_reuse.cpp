@@ -0,0 +1,140 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Decompressor reuse: one decompressor decodes a sequence of images that
+ differ in size, tiling, number of components and precision, with and
+ without a decode area. Every image must match a decode with a fresh
+ decompressor. Both J2K and JP2 decompressors are covered.
+ A component subset only applies to the image read after it was set up:
+ the next image is decoded with all components, unless the decompressor
+ is set up again.
+
+ usage: test_decompressor_reuse <work file>
+ */
+
+#include "test_common.h"
+#include <vector>
+
+using namespace grk_test;
+
+struct reuse_job_t {
+	std::string file;
+	uint32_t x0, y0, x1, y1;
+	/* set the decompressor up again before this image, with these components */
+	bool setup;
+	std::vector<uint32_t> comps;
+};
+
+static bool test_reuse(const char *msg, const std::vector<reuse_job_t> &jobs) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	auto codec = create_test_decompressor(jobs[0].file.c_str(), &parameters);
+	if (!codec)
+		return false;
+	bool rc = true;
+	for (size_t i = 0; i < jobs.size() && rc; ++i) {
+		auto &job = jobs[i];
+		char job_msg[256];
+		sprintf(job_msg, "%s, image %u", msg, (uint32_t) i);
+		grk_image_t *image = nullptr;
+		if (job.setup) {
+			grk_set_default_decoder_parameters(&parameters);
+			parameters.numcomps_to_decode = (uint32_t) job.comps.size();
+			parameters.comps_to_decode = (uint32_t*) job.comps.data();
+			grk_setup_decoder(codec, &parameters);
+		}
+		auto stream = grk_stream_create_default_file_stream(job.file.c_str(),
+				true);
+		rc = stream && grk_read_header(stream, codec, &image)
+				&& grk_set_decode_area(codec, image, job.x0, job.y0, job.x1,
+						job.y1) && grk_decode(codec, nullptr, stream, image)
+				&& grk_end_decompress(codec, stream);
+		if (!rc) {
+			fprintf(stderr, "%s: decode failed\n", job_msg);
+		} else {
+			auto comps = job.comps;
+			auto reference = decode_test_image(job.file.c_str(),
+					[&comps](grk_dparameters_t *parameters) {
+						parameters->numcomps_to_decode = (uint32_t) comps.size();
+						parameters->comps_to_decode = comps.data();
+					}, job.x0, job.y0, job.x1, job.y1);
+			rc = compare_test_images(job_msg, reference, image);
+			if (reference)
+				grk_image_destroy(reference);
+		}
+		if (stream)
+			grk_stream_destroy(stream);
+		if (image)
+			grk_image_destroy(image);
+	}
+	grk_destroy_codec(codec);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <work file>\n", argv[0]);
+		return 1;
+	}
+	std::string work = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+	const char *formats[] = { ".j2k", ".jp2" };
+	for (auto ext : formats) {
+		std::string tiled = work + "_tiled" + ext;
+		std::string gray = work + "_gray" + ext;
+		auto rgb_image = create_test_image(3, 230, 170, 8, false,
+				PATTERN_NATURAL);
+		auto gray_image = create_test_image(1, 301, 97, 12, false,
+				PATTERN_NATURAL);
+		if (!rgb_image || !gray_image
+				|| !encode_test_image(rgb_image, tiled.c_str(),
+						[](grk_cparameters_t *parameters) {
+							parameters->tile_size_on = true;
+							parameters->cp_tdx = 64;
+							parameters->cp_tdy = 64;
+						}) || !encode_test_image(gray_image, gray.c_str())) {
+			fprintf(stderr, "%s: encode failed\n", ext);
+			rc = 1;
+		} else {
+			std::vector<reuse_job_t> jobs = { { tiled, 0, 0, 0, 0, false, { } },
+					{ gray, 0, 0, 0, 0, false, { } }, { tiled, 70, 10, 200, 150,
+							false, { } }, { gray, 5, 5, 250, 60, false, { } }, {
+							tiled, 0, 0, 0, 0, false, { } } };
+			/* subset, then all components with and without a new setup */
+			std::vector<reuse_job_t> subset_jobs = { { tiled, 0, 0, 0, 0, true,
+					{ 0, 2 } }, { tiled, 0, 0, 0, 0, false, { } }, { tiled, 70,
+					10, 200, 150, true, { 1 } }, { tiled, 70, 10, 200, 150, true,
+					{ } }, { tiled, 0, 0, 0, 0, true, { 2 } }, { gray, 0, 0, 0, 0,
+					false, { } } };
+			std::string subset_msg = std::string(ext) + ", subset";
+			if (!test_reuse(ext, jobs)
+					|| !test_reuse(subset_msg.c_str(), subset_jobs))
+				rc = 1;
+		}
+		if (rgb_image)
+			grk_image_destroy(rgb_image);
+		if (gray_image)
+			grk_image_destroy(gray_image);
+		if (rc)
+			break;
+	}
+	grk_deinitialize();
+	return rc;
+}
@@ -0,0 +1,302 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Growing stream decode: a codestream is handed to the decoder in chunks,
+ from a file that is being appended to and, on POSIX systems, from a named pipe.
+ After the last chunk, the image must match a one-shot decode of the same codestream.
+ Codestreams include several tile-parts per tile, and a last tile-part
+ whose length is not signalled (Psot == 0).
+
+ usage: test_growing_stream <work file>
+ */
+
+#include "test_common.h"
+#include <algorithm>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace grk_test;
+
+static bool read_file(const char *path, std::vector<uint8_t> &data) {
+	auto f = fopen(path, "rb");
+	if (!f)
+		return false;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t) ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool rc = fread(data.data(), 1, data.size(), f) == data.size();
+	fclose(f);
+	return rc;
+}
+
+static bool write_file(const char *path, const std::vector<uint8_t> &data) {
+	auto f = fopen(path, "wb");
+	if (!f)
+		return false;
+	bool rc = fwrite(data.data(), 1, data.size(), f) == data.size();
+	fclose(f);
+	return rc;
+}
+
+static uint32_t read_be(const std::vector<uint8_t> &data, size_t pos,
+		uint32_t nb_bytes) {
+	uint32_t val = 0;
+	for (uint32_t i = 0; i < nb_bytes; ++i)
+		val = (val << 8) | data[pos + i];
+	return val;
+}
+
+/* offset of the first SOT marker, i.e. the length of the main header */
+static size_t main_header_length(const std::vector<uint8_t> &data) {
+	size_t pos = 2;
+	while (pos + 4 <= data.size()) {
+		uint32_t marker = read_be(data, pos, 2);
+		if (marker == 0xFF90)
+			return pos;
+		pos += 2 + read_be(data, pos + 2, 2);
+	}
+	return 0;
+}
+
+/* set Psot of the last tile-part to zero: the tile-part then runs up to EOC */
+static bool clear_last_psot(std::vector<uint8_t> &data) {
+	size_t pos = main_header_length(data);
+	if (!pos)
+		return false;
+	while (pos + 12 <= data.size() && read_be(data, pos, 2) == 0xFF90) {
+		uint32_t psot = read_be(data, pos + 6, 4);
+		if (!psot)
+			return false;
+		if (pos + psot == data.size() - 2) {
+			memset(&data[pos + 6], 0, 4);
+			return true;
+		}
+		pos += psot;
+	}
+	return false;
+}
+
+/**
+ Source of a growing codestream: either a file that is appended to,
+ or a named pipe
+ */
+struct growing_source_t {
+	growing_source_t() :
+			file(nullptr), fd(-1) {
+	}
+	~growing_source_t() {
+		if (file)
+			fclose(file);
+#ifndef _WIN32
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+	bool open(const char *path, bool pipe, grk_stream_t **stream) {
+		/* a named pipe may be left over from an earlier run */
+		remove(path);
+		if (!pipe) {
+			file = fopen(path, "wb");
+			if (!file)
+				return false;
+			*stream = grk_stream_create_default_file_stream(path, true);
+			return *stream != nullptr;
+		}
+#ifdef _WIN32
+		return false;
+#else
+		if (mkfifo(path, 0600))
+			return false;
+		/* a reader must exist before the write end can be opened without blocking,
+		 * and a writer must exist before the stream's reader can */
+		int reader = ::open(path, O_RDONLY | O_NONBLOCK);
+		if (reader < 0)
+			return false;
+		fd = ::open(path, O_WRONLY);
+		if (fd >= 0)
+			*stream = grk_stream_create_default_file_stream(path, true);
+		close(reader);
+		return fd >= 0 && *stream != nullptr;
+#endif
+	}
+	bool append(const uint8_t *buf, size_t len) {
+		if (file)
+			return fwrite(buf, 1, len, file) == len && !fflush(file);
+#ifndef _WIN32
+		while (len) {
+			auto written = write(fd, buf, len);
+			if (written <= 0)
+				return false;
+			buf += written;
+			len -= (size_t) written;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+	FILE *file;
+	int fd;
+};
+
+/**
+ Decode data, handing it to the decoder chunk_len bytes at a time
+ */
+static grk_image_t* decode_growing(const std::vector<uint8_t> &data,
+		size_t chunk_len, const char *path, bool pipe) {
+	growing_source_t source;
+	grk_stream_t *stream = nullptr;
+	grk_codec_t *codec = nullptr;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.growing_stream = true;
+
+	/* the main header is needed to read the header, and some tile data on top */
+	size_t len = std::min(data.size(), main_header_length(data) + chunk_len);
+	if (!source.open(path, pipe, &stream) || !source.append(data.data(), len))
+		goto cleanup;
+	grk_stream_set_user_data_length(stream, len);
+	codec = create_test_decompressor("growing.j2k", &parameters);
+	if (!codec || !grk_read_header(stream, codec, &image)
+			|| !grk_set_decode_area(codec, image, 0, 0, 0, 0)
+			|| !grk_decode(codec, nullptr, stream, image))
+		goto cleanup;
+	while (len < data.size()) {
+		size_t next = std::min(data.size() - len, chunk_len);
+		if (!source.append(data.data() + len, next))
+			goto cleanup;
+		len += next;
+		grk_stream_set_user_data_length(stream, len);
+		if (!grk_decode_update(codec, stream, image)) {
+			fprintf(stderr, "decode update failed at %u of %u bytes\n",
+					(uint32_t) len, (uint32_t) data.size());
+			goto cleanup;
+		}
+	}
+	rc = grk_end_decompress(codec, stream);
+	cleanup: if (codec)
+		grk_destroy_codec(codec);
+	if (stream)
+		grk_stream_destroy(stream);
+	if (!rc && image) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+	return image;
+}
+
+static bool test_codestream(const char *msg, const char *file,
+		const char *work_file, const std::vector<uint8_t> &data,
+		grk_image_t *original) {
+	auto reference = decode_test_image(file);
+	bool rc = compare_test_images(msg, original, reference);
+	const size_t chunk_lens[] = { 997, 4096 };
+	for (auto chunk_len : chunk_lens) {
+		if (!rc)
+			break;
+		for (uint32_t pipe = 0; pipe < 2 && rc; ++pipe) {
+#ifdef _WIN32
+			if (pipe)
+				continue;
+#endif
+			char test_msg[256];
+			sprintf(test_msg, "%s, %u byte chunks from %s", msg,
+					(uint32_t) chunk_len, pipe ? "pipe" : "file");
+			auto decoded = decode_growing(data, chunk_len, work_file,
+					pipe != 0);
+			if (!decoded) {
+				fprintf(stderr, "%s: decode failed\n", test_msg);
+				rc = false;
+			} else {
+				rc = compare_test_images(test_msg, reference, decoded);
+				grk_image_destroy(decoded);
+			}
+		}
+	}
+	if (reference)
+		grk_image_destroy(reference);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <work file>\n", argv[0]);
+		return 1;
+	}
+	std::string work = argv[1];
+	std::string file = work + ".j2k";
+	std::string growing_file = work + ".growing";
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	/* tiled, three quality layers, one tile-part per resolution */
+	auto image = create_test_image(3, 211, 163, 8, false, PATTERN_NATURAL);
+	std::vector<uint8_t> data;
+	if (!image || !encode_test_image(image, file.c_str(),
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 64;
+				parameters->cp_tdy = 64;
+				parameters->tcp_numlayers = 3;
+				parameters->tcp_rates[0] = 40;
+				parameters->tcp_rates[1] = 10;
+				parameters->tcp_rates[2] = 0;
+				parameters->tp_on = 1;
+				parameters->tp_flag = 'R';
+			}) || !read_file(file.c_str(), data)) {
+		fprintf(stderr, "tiled: encode failed\n");
+		rc = 1;
+	} else if (!test_codestream("tiled", file.c_str(), growing_file.c_str(),
+			data, image)) {
+		rc = 1;
+	}
+	if (image)
+		grk_image_destroy(image);
+
+	/* single tile, resolution progression, last tile-part with Psot == 0 */
+	image = create_test_image(1, 300, 200, 12, false, PATTERN_NATURAL);
+	if (!rc) {
+		if (!image || !encode_test_image(image, file.c_str(),
+				[](grk_cparameters_t *parameters) {
+					parameters->prog_order = GRK_RPCL;
+					parameters->tcp_numlayers = 2;
+					parameters->tcp_rates[0] = 20;
+					parameters->tcp_rates[1] = 0;
+				}) || !read_file(file.c_str(), data)
+				|| !clear_last_psot(data)
+				|| !write_file(file.c_str(), data)) {
+			fprintf(stderr, "Psot == 0: encode failed\n");
+			rc = 1;
+		} else if (!test_codestream("Psot == 0", file.c_str(),
+				growing_file.c_str(), data, image)) {
+			rc = 1;
+		}
+	}
+	if (image)
+		grk_image_destroy(image);
+	remove(growing_file.c_str());
+	grk_deinitialize();
+	return rc;
+}
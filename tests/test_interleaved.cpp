@@ -0,0 +1,292 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ 8 and 16 bit caller-supplied buffers, on both sides of the codec:
+ encoding from interleaved or planar input buffers must give the same
+ lossless round trip as encoding from image components, and decoding
+ to an interleaved output buffer must give the same samples as a plain
+ decode, without writing outside of the image rows. Buffers that are too
+ short, or too narrow for the data, must be rejected.
+
+ usage: test_interleaved <file>
+ */
+
+#include "test_common.h"
+#include <vector>
+
+using namespace grk_test;
+
+/**
+ Fill an input buffer with the samples of image
+ */
+static std::vector<uint8_t> make_input_buffer(grk_image_t *image,
+		uint32_t prec, bool interleaved, uint64_t stride) {
+	uint32_t numcomps = image->numcomps;
+	uint32_t w = image->comps[0].w;
+	uint32_t h = image->comps[0].h;
+	uint32_t bytes_per_sample = prec / 8;
+	std::vector<uint8_t> buf((size_t) stride * h * (interleaved ? 1 : numcomps));
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		for (uint32_t y = 0; y < h; ++y) {
+			uint8_t *row = buf.data() + (size_t) y * stride;
+			if (!interleaved)
+				row += (size_t) compno * stride * h;
+			for (uint32_t x = 0; x < w; ++x) {
+				size_t pos = interleaved ? (size_t) x * numcomps + compno : x;
+				int32_t val = comp->data[x + (size_t) y * w];
+				if (bytes_per_sample == 1)
+					row[pos] = (uint8_t) val;
+				else
+					((uint16_t*) row)[pos] = (uint16_t) val;
+			}
+		}
+	}
+	return buf;
+}
+
+static bool test_input_buffer(const char *file, uint32_t prec, bool sgnd,
+		uint32_t buffer_prec, bool interleaved) {
+	char msg[256];
+	sprintf(msg, "%u bit %s input, %u bit %s buffer", prec,
+			sgnd ? "signed" : "unsigned", buffer_prec,
+			interleaved ? "interleaved" : "planar");
+	auto image = create_test_image(3, 150, 97, prec, sgnd, PATTERN_NATURAL);
+	if (!image)
+		return false;
+	/* rows are padded */
+	uint64_t stride = (uint64_t) image->comps[0].w * (buffer_prec / 8)
+			* (interleaved ? image->numcomps : 1) + 13;
+	auto buf = make_input_buffer(image, buffer_prec, interleaved, stride);
+	auto setup = [&buf, stride, buffer_prec, interleaved](
+			grk_cparameters_t *parameters) {
+		parameters->input_buffer = buf.data();
+		parameters->input_stride = stride;
+		parameters->input_prec = buffer_prec;
+		parameters->input_interleaved = interleaved;
+		parameters->tile_size_on = true;
+		parameters->cp_tdx = 64;
+		parameters->cp_tdy = 48;
+	};
+	/* encoded samples must come from the buffer, not from the image */
+	auto encoded = clone_test_image(image);
+	bool rc = encoded != nullptr;
+	for (uint32_t compno = 0; rc && compno < encoded->numcomps; ++compno)
+		memset(encoded->comps[compno].data, 0,
+				(size_t) encoded->comps[compno].w * encoded->comps[compno].h
+						* sizeof(int32_t));
+	if (rc && !encode_test_image(encoded, file, setup)) {
+		fprintf(stderr, "%s: encode failed\n", msg);
+		rc = false;
+	}
+	if (rc) {
+		auto decoded = decode_test_image(file);
+		rc = compare_test_images(msg, image, decoded);
+		if (decoded)
+			grk_image_destroy(decoded);
+	}
+
+	/* stride that is too small */
+	if (rc && encode_test_image(image, file,
+			[&buf, stride, buffer_prec, interleaved](
+					grk_cparameters_t *parameters) {
+				parameters->input_buffer = buf.data();
+				parameters->input_stride = (interleaved ? 3 : 1) * 150 *
+						(buffer_prec / 8) - 1;
+				parameters->input_prec = buffer_prec;
+				parameters->input_interleaved = interleaved;
+			})) {
+		fprintf(stderr, "%s: stride that is too small was accepted\n", msg);
+		rc = false;
+	}
+	if (encoded)
+		grk_image_destroy(encoded);
+	grk_image_destroy(image);
+	return rc;
+}
+
+/**
+ Decode to an interleaved buffer of len bytes.
+ Returns false if decode failed.
+ */
+static bool decode_interleaved(const char *file, std::vector<uint8_t> &buf,
+		uint64_t len, uint64_t stride, uint32_t prec) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.interleaved_buffer = buf.data();
+	parameters.interleaved_buffer_len = len;
+	parameters.interleaved_stride = stride;
+	parameters.interleaved_prec = prec;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return false;
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	if (stream && grk_read_header(stream, codec, &image)
+			&& grk_set_decode_area(codec, image, 0, 0, 0, 0))
+		rc = grk_decode(codec, nullptr, stream, image)
+				&& grk_end_decompress(codec, stream);
+	if (stream)
+		grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (image)
+		grk_image_destroy(image);
+	return rc;
+}
+
+static bool test_output_buffer(const char *file, uint32_t prec,
+		uint32_t buffer_prec) {
+	char msg[256];
+	sprintf(msg, "%u bit image, %u bit interleaved output", prec, buffer_prec);
+	const uint8_t pad = 0xA5;
+	auto image = create_test_image(3, 203, 131, prec, false, PATTERN_NATURAL);
+	if (!image || !encode_test_image(image, file,
+			[](grk_cparameters_t *parameters) {
+				parameters->tile_size_on = true;
+				parameters->cp_tdx = 64;
+				parameters->cp_tdy = 64;
+			})) {
+		fprintf(stderr, "%s: encode failed\n", msg);
+		if (image)
+			grk_image_destroy(image);
+		return false;
+	}
+	uint32_t numcomps = image->numcomps;
+	uint32_t w = image->comps[0].w;
+	uint32_t h = image->comps[0].h;
+	uint32_t bytes_per_sample = buffer_prec / 8;
+	uint64_t row_len = (uint64_t) w * numcomps * bytes_per_sample;
+	uint64_t stride = row_len + 7;
+	uint64_t len = stride * (h - 1) + row_len;
+	std::vector<uint8_t> buf(len, pad);
+	bool rc = decode_interleaved(file, buf, len, stride, buffer_prec);
+	if (!rc)
+		fprintf(stderr, "%s: decode failed\n", msg);
+	for (uint32_t y = 0; y < h && rc; ++y) {
+		const uint8_t *row = buf.data() + y * stride;
+		for (uint32_t x = 0; x < w && rc; ++x) {
+			for (uint32_t compno = 0; compno < numcomps && rc; ++compno) {
+				size_t pos = (size_t) x * numcomps + compno;
+				int32_t val =
+						bytes_per_sample == 1 ?
+								row[pos] : ((const uint16_t*) row)[pos];
+				int32_t expected = image->comps[compno].data[x + (size_t) y * w];
+				if (val != expected) {
+					fprintf(stderr,
+							"%s: component %u differs at (%u,%u): %d != %d\n",
+							msg, compno, x, y, val, expected);
+					rc = false;
+				}
+			}
+		}
+		for (uint64_t i = row_len; i < stride && y + 1 < h && rc; ++i) {
+			if (row[i] != pad) {
+				fprintf(stderr, "%s: row padding written in row %u\n", msg, y);
+				rc = false;
+			}
+		}
+	}
+
+	/* buffer one byte too short */
+	if (rc && decode_interleaved(file, buf, len - 1, stride, buffer_prec)) {
+		fprintf(stderr, "%s: buffer that is too short was accepted\n", msg);
+		rc = false;
+	}
+	grk_image_destroy(image);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+	struct {
+		uint32_t prec;
+		bool sgnd;
+		uint32_t buffer_prec;
+	} inputs[] = { { 8, false, 8 }, { 8, true, 8 }, { 12, false, 16 }, { 16,
+			true, 16 }, { 8, false, 16 } };
+	for (auto &in : inputs) {
+		for (uint32_t interleaved = 0; interleaved < 2 && !rc; ++interleaved) {
+			if (!test_input_buffer(file, in.prec, in.sgnd, in.buffer_prec,
+					interleaved != 0))
+				rc = 1;
+		}
+	}
+	/* precision too high for buffer */
+	if (!rc) {
+		auto image = create_test_image(1, 40, 30, 12, false, PATTERN_NATURAL);
+		std::vector<uint8_t> buf(40 * 30);
+		if (!image || encode_test_image(image, file,
+				[&buf](grk_cparameters_t *parameters) {
+					parameters->input_buffer = buf.data();
+					parameters->input_stride = 40;
+					parameters->input_prec = 8;
+				})) {
+			fprintf(stderr, "12 bit image encoded from 8 bit buffer\n");
+			rc = 1;
+		}
+		if (image)
+			grk_image_destroy(image);
+	}
+
+	const uint32_t outputs[][2] = { { 8, 8 }, { 12, 16 }, { 8, 16 }, { 12, 8 } };
+	for (auto &out : outputs) {
+		if (rc)
+			break;
+		if (out[0] > out[1]) {
+			/* rejected */
+			auto image = create_test_image(3, 64, 64, out[0], false,
+					PATTERN_NATURAL);
+			std::vector<uint8_t> buf(64 * 64 * 3);
+			if (!image || !encode_test_image(image, file)
+					|| decode_interleaved(file, buf, buf.size(), 64 * 3,
+							out[1])) {
+				fprintf(stderr,
+						"%u bit image decoded to %u bit interleaved buffer\n",
+						out[0], out[1]);
+				rc = 1;
+			}
+			if (image)
+				grk_image_destroy(image);
+		} else if (!test_output_buffer(file, out[0], out[1])) {
+			rc = 1;
+		}
+	}
+
+	/* signed components are rejected */
+	if (!rc) {
+		auto image = create_test_image(3, 64, 64, 8, true, PATTERN_NATURAL);
+		std::vector<uint8_t> buf(64 * 64 * 3);
+		if (!image || !encode_test_image(image, file)
+				|| decode_interleaved(file, buf, buf.size(), 64 * 3, 8)) {
+			fprintf(stderr, "signed image decoded to interleaved buffer\n");
+			rc = 1;
+		}
+		if (image)
+			grk_image_destroy(image);
+	}
+	grk_deinitialize();
+	return rc;
+}
@@ -0,0 +1,84 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Layer-limited decode: the same image is encoded with three quality layers
+ in LRCP, RLCP and RPCL progression order. Decoding only the first layers
+ must give the same image for every progression order, since the code-block
+ data read is the same: passes from layers that are not decoded must never
+ reach T1, whether their packets are skipped or never reached.
+
+ usage: test_layer_decode <file>
+ */
+
+#include "test_common.h"
+
+using namespace grk_test;
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	std::string file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+	const GRK_PROG_ORDER orders[] = { GRK_LRCP, GRK_RLCP, GRK_RPCL };
+	const char *order_names[] = { "LRCP", "RLCP", "RPCL" };
+	const uint32_t num_orders = sizeof(orders) / sizeof(orders[0]);
+	auto image = create_test_image(3, 257, 193, 8, false, PATTERN_NATURAL);
+	for (uint32_t layers = 1; layers <= 2 && !rc; ++layers) {
+		grk_image_t *decoded[num_orders] = { };
+		for (uint32_t i = 0; i < num_orders && !rc; ++i) {
+			char msg[256];
+			sprintf(msg, "%s, %u layer(s)", order_names[i], layers);
+			auto prog = orders[i];
+			if (!image || !encode_test_image(image, file.c_str(),
+					[prog](grk_cparameters_t *parameters) {
+						parameters->prog_order = prog;
+						parameters->numresolution = 5;
+						parameters->tcp_numlayers = 3;
+						parameters->tcp_rates[0] = 80;
+						parameters->tcp_rates[1] = 20;
+						parameters->tcp_rates[2] = 0;
+					})) {
+				fprintf(stderr, "%s: encode failed\n", msg);
+				rc = 1;
+				break;
+			}
+			decoded[i] = decode_test_image(file.c_str(),
+					[layers](grk_dparameters_t *parameters) {
+						parameters->cp_layer = layers;
+					});
+			if (!decoded[i]) {
+				fprintf(stderr, "%s: decode failed\n", msg);
+				rc = 1;
+			} else if (i && !compare_test_images(msg, decoded[0], decoded[i])) {
+				rc = 1;
+			}
+		}
+		for (uint32_t i = 0; i < num_orders; ++i) {
+			if (decoded[i])
+				grk_image_destroy(decoded[i]);
+		}
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
@@ -0,0 +1,86 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Lossless round trip at a given precision, for images that drive
+ 5/3 wavelet coefficients to the limits of their range.
+ The inverse transform switches to 16 bit lanes for narrow data, so
+ precisions on either side of that limit must reconstruct exactly.
+
+ usage: test_lossless_limits <precision> <file>
+ */
+
+#include "test_common.h"
+
+using namespace grk_test;
+
+int main(int argc, char *argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <precision> <file>\n", argv[0]);
+		return 1;
+	}
+	uint32_t prec = (uint32_t) atoi(argv[1]);
+	const char *file = argv[2];
+	if (prec < 1 || prec > 16) {
+		fprintf(stderr, "precision must be between 1 and 16\n");
+		return 1;
+	}
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+	const test_pattern_t patterns[] = { PATTERN_NATURAL, PATTERN_EXTREME,
+			PATTERN_CHECKER };
+	for (auto pattern : patterns) {
+		if (rc)
+			break;
+		for (uint32_t sgnd = 0; sgnd < 2 && !rc; ++sgnd) {
+			for (uint32_t tiled = 0; tiled < 2 && !rc; ++tiled) {
+				char msg[256];
+				sprintf(msg, "precision %u, %s, %s, %s", prec,
+						pattern == PATTERN_NATURAL ?
+								"natural" :
+								(pattern == PATTERN_EXTREME ? "extreme" : "checker"),
+						sgnd ? "signed" : "unsigned",
+						tiled ? "tiled" : "single tile");
+				auto image = create_test_image(1, 237, 181, prec, sgnd != 0,
+						pattern);
+				if (!image || !encode_test_image(image, file,
+						[tiled](grk_cparameters_t *parameters) {
+							parameters->numresolution = 6;
+							if (tiled) {
+								parameters->tile_size_on = true;
+								parameters->cp_tdx = 64;
+								parameters->cp_tdy = 48;
+							}
+						})) {
+					fprintf(stderr, "%s: encode failed\n", msg);
+					rc = 1;
+				} else {
+					auto decoded = decode_test_image(file);
+					if (!compare_test_images(msg, image, decoded))
+						rc = 1;
+					if (decoded)
+						grk_image_destroy(decoded);
+				}
+				if (image)
+					grk_image_destroy(image);
+			}
+		}
+	}
+	grk_deinitialize();
+	return rc;
+}
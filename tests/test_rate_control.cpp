@@ -0,0 +1,152 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/*
+ Rate control pass skipping: with bisection rate control, T1 does not code
+ passes far below the expected truncation threshold. The codestream must be
+ identical to one with every pass coded, so that truncation points are
+ unchanged, while fewer passes are coded: for the first tile, whose
+ threshold is estimated from a sample of code-blocks, as well as for later
+ tiles. Lossless and fixed quality final layers code every pass.
+
+ usage: test_rate_control <file>
+ */
+
+#include "test_common.h"
+#include <vector>
+
+using namespace grk_test;
+
+static bool read_file(const std::string &path, std::vector<uint8_t> *data) {
+	auto f = fopen(path.c_str(), "rb");
+	if (!f)
+		return false;
+	data->clear();
+	uint8_t buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		data->insert(data->end(), buf, buf + n);
+	fclose(f);
+	return true;
+}
+
+struct rate_control_job {
+	const char *name;
+	bool tiled;
+	uint32_t num_layers;
+	double rates[3];
+	bool fixed_quality;
+	bool skips;
+};
+
+static bool test_job(const rate_control_job &job, grk_image_t *image,
+		const char *file) {
+	auto setup = [&job](grk_cparameters_t *parameters) {
+		if (job.tiled) {
+			parameters->tile_size_on = true;
+			parameters->cp_tdx = 256;
+			parameters->cp_tdy = 256;
+		}
+		parameters->cblockw_init = 32;
+		parameters->cblockh_init = 32;
+		parameters->tcp_numlayers = job.num_layers;
+		for (uint32_t i = 0; i < job.num_layers; ++i) {
+			if (job.fixed_quality)
+				parameters->tcp_distoratio[i] = (float) job.rates[i];
+			else
+				parameters->tcp_rates[i] = job.rates[i];
+		}
+		if (job.fixed_quality) {
+			parameters->cp_disto_alloc = 0;
+			parameters->cp_fixed_quality = 1;
+		}
+	};
+	std::string reference_file = std::string(file) + ".all.j2k";
+	grk_compress_stats_t all_stats, stats;
+	if (!encode_test_image(image, reference_file.c_str(),
+			[setup](grk_cparameters_t *parameters) {
+				setup(parameters);
+				parameters->code_all_passes = true;
+			}, &all_stats) || !encode_test_image(image, file, setup, &stats)) {
+		fprintf(stderr, "%s: encode failed\n", job.name);
+		return false;
+	}
+	std::vector<uint8_t> reference, codestream;
+	if (!read_file(reference_file, &reference)
+			|| !read_file(file, &codestream)) {
+		fprintf(stderr, "%s: cannot read codestreams\n", job.name);
+		return false;
+	}
+	remove(reference_file.c_str());
+	printf("%s: %llu of %llu passes coded\n", job.name,
+			(unsigned long long) stats.passes_coded,
+			(unsigned long long) (stats.passes_coded + stats.passes_skipped));
+	if (all_stats.passes_skipped) {
+		fprintf(stderr, "%s: passes skipped with code_all_passes\n", job.name);
+		return false;
+	}
+	if (stats.passes_coded + stats.passes_skipped != all_stats.passes_coded) {
+		fprintf(stderr, "%s: pass counts do not add up\n", job.name);
+		return false;
+	}
+	if (job.skips != (stats.passes_skipped != 0)) {
+		fprintf(stderr, "%s: expected passes %s\n", job.name,
+				job.skips ? "to be skipped" : "to be coded");
+		return false;
+	}
+	if (codestream != reference) {
+		fprintf(stderr, "%s: codestream differs from one with all passes coded\n",
+				job.name);
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	const rate_control_job jobs[] = {
+			{ "single tile, 50:1", false, 1, { 50 }, false, true },
+			{ "single tile, 200:1", false, 1, { 200 }, false, true },
+			{ "single tile, three layers", false, 3, { 200, 80, 20 }, false, true },
+			{ "tiled, 50:1", true, 1, { 50 }, false, true },
+			{ "tiled, three layers", true, 3, { 200, 80, 20 }, false, true },
+			{ "tiled, lossless final layer", true, 2, { 50, 0 }, false, false },
+			{ "tiled, fixed quality", true, 1, { 30 }, true, false } };
+	auto image = create_test_image(3, 640, 480, 8, false, PATTERN_NATURAL);
+	if (!image) {
+		fprintf(stderr, "cannot create image\n");
+		rc = 1;
+	}
+	for (auto &job : jobs) {
+		if (rc)
+			break;
+		if (!test_job(job, image, file))
+			rc = 1;
+	}
+	if (image)
+		grk_image_destroy(image);
+	grk_deinitialize();
+	return rc;
+}
@@ -0,0 +1,220 @@
+/*
+ *    Copyright (C) 2016-2019 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+
+/*
+ Thumbnail decode: the thumbnail must have the dimensions of the lowest
+ resolution, and match a decode reduced by all decomposition levels.
+ With a resolution-major progression, packets of higher resolutions must
+ be skipped without being read: their SOP markers are corrupted, and the
+ thumbnail must decode without a warning about them, while a decode that
+ reads them must warn.
+
+ usage: test_thumbnail <file>
+ */
+
+#include "test_common.h"
+#include <atomic>
+#include <vector>
+
+using namespace grk_test;
+
+const uint32_t num_comps = 3;
+const uint32_t num_resolutions = 4;
+
+static std::atomic<uint32_t> sop_warnings(0);
+
+static void warning_callback(const char *msg, void *client_data) {
+	(void) client_data;
+	if (strstr(msg, "SOP"))
+		++sop_warnings;
+}
+
+/**
+ Overwrite the SOP markers of all packets that do not belong to the lowest
+ resolution. There is one layer and one precinct per resolution, so these
+ are the packets numbered num_comps and above in either progression.
+ Returns the number of corrupted markers.
+ */
+static uint32_t corrupt_sop_markers(const char *file, const char *corrupt) {
+	std::vector<uint8_t> data;
+	auto fp = fopen(file, "rb");
+	if (!fp)
+		return 0;
+	int c;
+	while ((c = fgetc(fp)) != EOF)
+		data.push_back((uint8_t) c);
+	fclose(fp);
+	uint32_t num_corrupted = 0;
+	for (size_t i = 0; i + 6 <= data.size(); ++i) {
+		if (data[i] != 0xFF || data[i + 1] != 0x91 || data[i + 2] != 0
+				|| data[i + 3] != 4)
+			continue;
+		uint32_t packno = (uint32_t) ((data[i + 4] << 8) | data[i + 5]);
+		if (packno >= num_comps) {
+			data[i + 1] = 0x90;
+			num_corrupted++;
+		}
+	}
+	fp = fopen(corrupt, "wb");
+	if (!fp)
+		return 0;
+	if (fwrite(data.data(), 1, data.size(), fp) != data.size())
+		num_corrupted = 0;
+	fclose(fp);
+	return num_corrupted;
+}
+
+/**
+ Decode with SOP warnings counted. Returns the decoded image, or nullptr
+ on failure.
+ */
+static grk_image_t* decode_counting_warnings(const char *file, bool thumbnail,
+		uint32_t reduce, uint32_t *num_warnings) {
+	grk_dparameters_t parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.thumbnail = thumbnail;
+	parameters.cp_reduce = reduce;
+	auto codec = create_test_decompressor(file, &parameters);
+	if (!codec)
+		return nullptr;
+	sop_warnings = 0;
+	grk_set_warning_handler(codec, warning_callback, nullptr);
+	grk_image_t *image = nullptr;
+	bool rc = false;
+	auto stream = grk_stream_create_default_file_stream(file, true);
+	if (stream && grk_read_header(stream, codec, &image))
+		rc = grk_decode(codec, nullptr, stream, image)
+				&& grk_end_decompress(codec, stream);
+	if (stream)
+		grk_stream_destroy(stream);
+	grk_set_warning_handler(codec, nullptr, nullptr);
+	grk_destroy_codec(codec);
+	*num_warnings = sop_warnings;
+	if (!rc && image) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+	return image;
+}
+
+static bool test_thumbnail(const char *msg, const char *file,
+		const char *corrupt, grk_image_t *original) {
+	bool rc = true;
+	uint32_t num_warnings = 0;
+	auto reference = decode_test_image(file,
+			[](grk_dparameters_t *parameters) {
+				parameters->cp_reduce = num_resolutions - 1;
+			});
+	auto thumbnail = decode_counting_warnings(file, true, 0, &num_warnings);
+	if (!reference || !thumbnail) {
+		fprintf(stderr, "%s: decode failed\n", msg);
+		rc = false;
+	}
+
+	/* dimensions of the lowest resolution */
+	const uint32_t scale = 1U << (num_resolutions - 1);
+	for (uint32_t i = 0; i < num_comps && rc; ++i) {
+		uint32_t w = (original->comps[i].w + scale - 1) / scale;
+		uint32_t h = (original->comps[i].h + scale - 1) / scale;
+		if (thumbnail->comps[i].w != w || thumbnail->comps[i].h != h) {
+			fprintf(stderr,
+					"%s: component %u is %ux%u, expected %ux%u\n", msg, i,
+					thumbnail->comps[i].w, thumbnail->comps[i].h, w, h);
+			rc = false;
+		}
+	}
+	rc = rc && compare_test_images(msg, reference, thumbnail);
+	if (thumbnail)
+		grk_image_destroy(thumbnail);
+	thumbnail = nullptr;
+
+	/* higher resolution packets are not read */
+	if (rc) {
+		uint32_t num_corrupted = corrupt_sop_markers(file, corrupt);
+		if (num_corrupted != num_comps * (num_resolutions - 1)) {
+			fprintf(stderr, "%s: corrupted %u SOP markers, expected %u\n",
+					msg, num_corrupted, num_comps * (num_resolutions - 1));
+			rc = false;
+		}
+	}
+	if (rc) {
+		thumbnail = decode_counting_warnings(corrupt, true, 0, &num_warnings);
+		if (num_warnings) {
+			fprintf(stderr,
+					"%s: thumbnail read higher resolution packets\n", msg);
+			rc = false;
+		} else {
+			std::string thumbnail_msg = std::string(msg) + ", corrupted file";
+			rc = compare_test_images(thumbnail_msg.c_str(), reference,
+					thumbnail);
+		}
+	}
+	/* the corruption is seen by a decode that reads the next resolution */
+	if (rc) {
+		auto decoded = decode_counting_warnings(corrupt, false,
+				num_resolutions - 2, &num_warnings);
+		if (!num_warnings) {
+			fprintf(stderr, "%s: corrupted SOP markers were not detected\n",
+					msg);
+			rc = false;
+		}
+		if (decoded)
+			grk_image_destroy(decoded);
+	}
+	if (thumbnail)
+		grk_image_destroy(thumbnail);
+	if (reference)
+		grk_image_destroy(reference);
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <file>\n", argv[0]);
+		return 1;
+	}
+	const char *file = argv[1];
+	std::string corrupt = std::string(file) + ".sop.j2k";
+	grk_initialize(nullptr, 0);
+	int rc = 0;
+
+	auto image = create_test_image(num_comps, 213, 159, 8, false,
+			PATTERN_NATURAL);
+	const GRK_PROG_ORDER orders[] = { GRK_RPCL, GRK_RLCP };
+	const char *names[] = { "RPCL", "RLCP" };
+	for (uint32_t i = 0; i < 2 && !rc; ++i) {
+		auto order = orders[i];
+		if (!image || !encode_test_image(image, file,
+				[order](grk_cparameters_t *parameters) {
+					parameters->numresolution = num_resolutions;
+					parameters->prog_order = order;
+					parameters->csty |= 0x02;
+				})) {
+			fprintf(stderr, "encode failed\n");
+			rc = 1;
+		} else if (!test_thumbnail(names[i], file, corrupt.c_str(), image)) {
+			rc = 1;
+		}
+	}
+	if (image)
+		grk_image_destroy(image);
+	remove(corrupt.c_str());
+	grk_deinitialize();
+	return rc;
+}